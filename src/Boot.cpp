@@ -26,6 +26,9 @@ extern "C"
 	__declspec(dllexport) unsigned long NvOptimusEnablement = 1;
 #endif
 
+	// Host path to the Data folder, for threads that can't go through the Pomme file manager
+	char gDataHostPath[1024];
+
 	int gAntialiasingLevelAppliedOnBoot = 0;
 	int gFullscreenModeAppliedOnBoot = 0;
 
@@ -82,6 +85,60 @@ tryAgain:
 	return dataPath;
 }
 
+// Turns a Mac-style path relative to the Data folder (":Audio:Song.aiff") into a host path
+// that can be opened without the Pomme file manager (e.g. from another thread).
+// Like Pomme, each path component is matched case-insensitively against what's on disk.
+// Must be called from the main thread.
+bool ResolveDataHostPath(const char* macPath, char* hostPath, size_t hostPathSize)
+{
+	FSSpec spec;
+	if (noErr != FSMakeFSSpec(gDataSpec.vRefNum, gDataSpec.parID, macPath, &spec))	// same lookup as any other data file
+		return false;
+
+	fs::path path = (const char8_t*) gDataHostPath;
+	std::string remaining = macPath;
+
+	while (!remaining.empty())
+	{
+		size_t colon = remaining.find(':');
+		std::string component = remaining.substr(0, colon);
+		remaining = (colon == std::string::npos) ? "" : remaining.substr(colon + 1);
+
+		if (component.empty())
+			continue;
+
+		fs::path exact = path / (const char8_t*) component.c_str();
+		std::error_code ec;
+		if (fs::exists(exact, ec))
+		{
+			path = exact;
+			continue;
+		}
+
+		bool found = false;
+		for (const auto& entry : fs::directory_iterator(path, ec))
+		{
+			auto name = entry.path().filename().u8string();
+			if (0 == SDL_strcasecmp((const char*) name.c_str(), component.c_str()))
+			{
+				path = entry.path();
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			return false;
+	}
+
+	auto path8 = path.u8string();
+	if (path8.size() >= hostPathSize)
+		return false;
+
+	snprintf(hostPath, hostPathSize, "%s", (const char*) path8.c_str());
+	return true;
+}
+
 static void ParseCommandLine(int argc, char** argv)
 {
 	memset(&gCommandLine, 0, sizeof(gCommandLine));
@@ -108,6 +165,8 @@ static void ParseCommandLine(int argc, char** argv)
 			gCommandLine.msaa = 8;
 		else if (argument == "--msaa16x")
 			gCommandLine.msaa = 16;
+		else if (argument == "--point-sprite-particles")
+			gCommandLine.pointSpriteParticles = 1;
 		else if (argument == "--fullscreen-resolution")
 		{
 			GAME_ASSERT_MESSAGE(i + 2 < argc, "fullscreen width & height unspecified");
@@ -115,6 +174,12 @@ static void ParseCommandLine(int argc, char** argv)
 			gCommandLine.fullscreenHeight = atoi(argv[i + 2]);
 			i += 2;
 		}
+		else if (argument == "--voices")
+		{
+			GAME_ASSERT_MESSAGE(i + 1 < argc, "number of voices unspecified");
+			gCommandLine.numEffectVoices = atoi(argv[i + 1]);
+			i += 1;
+		}
 		else if (argument == "--fullscreen-refresh-rate")
 		{
 			GAME_ASSERT_MESSAGE(i + 1 < argc, "fullscreen refresh rate unspecified");
@@ -196,6 +261,7 @@ tryAgain:
 
 	// Find path to game data folder
 	fs::path dataPath = FindGameData(executablePath);
+	snprintf(gDataHostPath, sizeof(gDataHostPath), "%s", (const char*) dataPath.u8string().c_str());
 
 #if !(NOJOYSTICK)
 	// Init joystick subsystem
@@ -41,6 +41,10 @@ float CalcQuickDistance(float x1, float y1, float x2, float y2);
 void FastNormalizeVector(float vx, float vy, float vz, TQ3Vector3D *outV);
 void FastNormalizeVector2D(float vx, float vy, TQ3Vector2D *outV);
 void MatrixMultiplyFast(TQ3Matrix4x4 *a, TQ3Matrix4x4 *b, TQ3Matrix4x4 *result);
+void MatrixMultiplyAffine(const TQ3Matrix4x4 *a, const TQ3Matrix4x4 *b, TQ3Matrix4x4 *result);
+void TransformPointsAffine(const TQ3Point3D *in, const TQ3Matrix4x4 *m, TQ3Point3D *out, int numPoints);
+void TransformVectors(const TQ3Vector3D *in, const TQ3Matrix4x4 *m, TQ3Vector3D *out, int numVectors);
+void SetInverseTransposeMatrix(const TQ3Matrix4x4 *m, TQ3Matrix4x4 *result);
 
 
 
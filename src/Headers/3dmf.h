@@ -4,5 +4,6 @@
 
 extern	void Init3DMFManager(void);
 extern	void LoadGrouped3DMF(FSSpec *spec, Byte groupNum);
+extern	void LoadResidentGrouped3DMF(FSSpec *spec, Byte groupNum);
 extern	void Free3DMFGroup(Byte groupNum);
 extern	void DeleteAll3DMFGroups(void);
@@ -0,0 +1,33 @@
+#pragma once
+
+// Resident asset cache.
+//
+// Keeps assets that every level needs (global model groups, the player/ladybug/buddy skeletons,
+// the Main sound bank) loaded across level transitions instead of reloading them from disk
+// (and re-uploading their textures) every time.
+//
+// Entries are ref-counted. An entry whose refcount drops to zero is "parked": it stays in memory
+// so the next Acquire with the same key is free. Parked entries are evicted in least-recently-used
+// order whenever the cache exceeds RESIDENT_ASSET_BUDGET.
+
+#define RESIDENT_ASSET_BUDGET	(24 * 1024 * 1024)	// bytes of heap that parked assets may hold on to
+#define MAX_RESIDENT_ASSETS		16
+#define MAX_RESIDENT_KEY_LENGTH	64
+
+typedef void (*ResidentAssetDisposeProc)(void* payload);
+
+// Looks up a resident asset by key.
+// If found, bumps its refcount and returns its payload. Returns NULL on a miss.
+void* AcquireResidentAsset(const char* key);
+
+// Registers a freshly-loaded asset with a refcount of 1.
+// bytes: approximate heap footprint of the payload, counted against the budget.
+// disposeProc: called with the payload when the entry is evicted.
+void InsertResidentAsset(const char* key, void* payload, long bytes, ResidentAssetDisposeProc disposeProc);
+
+// Drops a reference to a payload obtained from Acquire/Insert.
+// The payload stays in memory until evicted.
+void ReleaseResidentAsset(void* payload);
+
+// Disposes of all parked assets. Assets that are still referenced are left alone.
+void PurgeResidentAssets(void);
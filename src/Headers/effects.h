@@ -34,7 +34,9 @@ enum
 
 #define	FULL_ALPHA	1.0f
 
-ObjNode *MakeRipple(float x, float y, float z, float startScale);
+void MakeRipple(float x, float y, float z, float startScale);
+void MoveRipples(void);
+void DrawRipples(void);
 
 void InitParticleSystem(void);
 void DeleteAllParticleGroups(void);
@@ -44,5 +46,6 @@ bool AddParticleToGroup(int32_t groupID, TQ3Point3D* where, TQ3Vector3D* delta,
 void MoveParticleGroups(void);
 void DrawParticleGroup(const QD3DSetupOutputType *setupInfo);
 bool ParticleHitObject(ObjNode *theNode, uint8_t inFlags);
+void StressTestParticleGroups(const TQ3Point3D* where);
 
 void MakeSplash(float x, float y, float z, float force, float volume);
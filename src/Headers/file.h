@@ -72,6 +72,7 @@ OSErr MakePrefsFSSpec(const char* filename, bool createFolder, FSSpec* spec);
 
 extern	SkeletonDefType *LoadSkeletonFile(short skeletonType);
 short OpenGameFile(const char* filename);
+bool ResolveDataHostPath(const char* macPath, char* hostPath, size_t hostPathSize);	// in Boot.cpp
 extern	OSErr LoadPrefs(PrefsType *prefBlock);
 extern	void SavePrefs(PrefsType *prefs);
 extern	void SaveGame(int slot);
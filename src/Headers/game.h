@@ -25,6 +25,7 @@ extern "C"
 #include "window.h"
 #include "main.h"
 #include "misc.h"
+#include "parallel.h"
 #include "bones.h"
 #include "skeletonobj.h"
 #include "skeletonanim.h"
@@ -32,14 +33,17 @@ extern "C"
 #include "camera.h"
 #include "player_control.h"
 #include "sound2.h"
+#include "musicstream.h"
 #include "3dmf.h"
 #include "file.h"
+#include "assetcache.h"
 #include "input.h"
 #include "terrain.h"
 #include "myguy.h"
 #include "enemy.h"
 #include "3dmath.h"
 #include "items.h"
+#include "scenerybatch.h"
 #include "highscores.h"
 #include "qd3d_geometry.h"
 #include "environmentmap.h"
@@ -141,6 +145,8 @@ extern	TerrainInfoMatrixType		**gMapInfoMatrix;
 extern	TerrainItemEntryType		**gTerrainItemLookupTableX;
 extern	TerrainItemEntryType 		**gMasterItemList;
 extern	TerrainYCoordType			**gMapYCoords;
+extern	VoiceStats					gVoiceStats;
+extern	char						gDataHostPath[];
 extern	char						gTypedAsciiKey;
 extern	const char					*kLevelNames[NUM_LEVELS];
 extern	const RenderModifiers		kDefaultRenderMods_UI;
@@ -157,12 +163,16 @@ extern	float						gCycScale;
 extern	float						gFramesPerSecond;
 extern	float						gFramesPerSecondFrac;
 extern	float						gGammaFadeFactor;
+extern	float						gItemScanMilliseconds;
 extern	float						gMyDistToFloor;
 extern	float						gMyHealth;
+extern	float						gParticleDrawMilliseconds;
 extern	float						gPlayerCurrentWaterY;
 extern	float						gPlayerMaxSpeed;
 extern	float						gPlayerToCameraAngle;
 extern	float						gShieldTimer;
+extern	float						gSuperTileBuildMilliseconds;
+extern	float						gSuperTileTextureMilliseconds;
 extern	float						gTerrainItemDeleteWindow_Far;
 extern	float						gTerrainItemDeleteWindow_Left;
 extern	float						gTerrainItemDeleteWindow_Near;
@@ -171,7 +181,18 @@ extern	int							gAntialiasingLevelAppliedOnBoot;
 extern	int							gDebugMode;
 extern	int							gFullscreenModeAppliedOnBoot;
 extern	int							gMaxItemsAllocatedInAPass;
+extern	int							gNumBatchedSceneryNodes;
+extern	int							gNumBatchedShadows;
+extern	int							gNumDroppedParticles;
+extern	int							gNumFarSuperTilesDrawn;
+extern	int							gNumLiveParticles;
 extern	int							gNumObjNodes;
+extern	int							gNumParkedResidentAssets;
+extern	int							gNumResidentAssets;
+extern	int							gNumRipples;
+extern	int							gNumSceneryBatchDraws;
+extern	int							gNumShadowBlockerTests;
+extern	int							gParticleArenaBytes;
 extern	int							gWindowHeight;
 extern	int							gWindowWidth;
 extern	int 						gCurrentSaveSlot;
@@ -191,6 +212,7 @@ extern	long						gNumSuperTilesDeep;
 extern	long						gNumSuperTilesWide;
 extern	long						gNumTerrainTextureTiles;
 extern	long						gPrefsFolderDirID;
+extern	long						gResidentAssetBytes;
 extern	long						gSupertileBudget;
 extern	long						gTerrainTileDepth;
 extern	long						gTerrainTileWidth;
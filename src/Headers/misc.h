@@ -15,6 +15,10 @@ void SetMyRandomSeed(uint32_t seed);
 uint32_t MyRandomLong(void);
 float RandomFloat(void);
 
+// Returns a high-resolution timestamp. Pass it to GetMillisecondsSince() to measure elapsed time.
+uint64_t GetProfilingTimestamp(void);
+float GetMillisecondsSince(uint64_t timestamp);
+
 void VerifySystem(void);
 void ApplyFrictionToDeltas(float f,TQ3Vector3D *d);
 
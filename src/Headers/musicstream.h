@@ -0,0 +1,31 @@
+#pragma once
+
+// Background music streamer.
+//
+// Songs are read and decoded on a dedicated thread into a lock-free single-producer/single-consumer
+// ring buffer, which is drained by an SDL audio callback. The main thread never reads song data:
+// it only looks up the file's path and posts commands, so starting or switching songs doesn't
+// stall the frame.
+//
+// Supports AIFF and AIFF-C files (uncompressed PCM or IMA4), gapless looping, and crossfades.
+
+#define MUSIC_CROSSFADE_MS		750		// default crossfade when a song replaces another
+#define MUSIC_DECLICK_MS		15		// shortest fade, used instead of hard cuts
+
+void InitMusicStream(void);
+void ShutdownMusicStream(void);
+
+// Starts streaming a song. The path is relative to the game's data folder, in Mac-style
+// ":Folder:File" notation. Any song that's already playing fades out over crossfadeMS
+// while the new one fades in.
+void MusicStream_Play(const char* path, bool loop, int crossfadeMS);
+
+// Fades out whatever is playing.
+void MusicStream_Stop(int fadeOutMS);
+
+void MusicStream_SetVolume(float volume);
+void MusicStream_Pause(bool pause);
+
+// Returns true until the last song requested has finished playing (and drained from the ring).
+// Looping songs never finish on their own.
+bool MusicStream_IsPlaying(void);
@@ -71,9 +71,16 @@ extern	void CalcObjectBoxFromGlobal(ObjNode *theNode);
 extern	void SetObjectCollisionBounds(ObjNode *theNode, short top, short bottom, short left,
 							 short right, short front, short back);
 extern	void UpdateShadow(ObjNode *theNode);
+void InvalidateShadowBlockerList(void);
+#if _DEBUG
+void BenchmarkShadowBlockers(void);
+#endif
 extern	void CheckAllObjectsInConeOfVision(void);
 ObjNode	*AttachShadowToObject(ObjNode *theNode, float scaleX, float scaleZ, Boolean checkBlockers);
 ObjNode	*AttachGlowShadowToObject(ObjNode *theNode, float scaleX, float scaleZ, Boolean checkBlockers);
+void BeginShadowBatch(void);
+Boolean AddShadowToBatch(ObjNode *theNode);
+void SubmitShadowBatch(void);
 extern	void StopObjectStreamEffect(ObjNode *theNode);
 extern	void KeepOldCollisionBoxes(ObjNode *theNode);
 
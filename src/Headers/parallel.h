@@ -0,0 +1,14 @@
+#pragma once
+
+#define MAX_PARALLEL_WORKERS	16
+
+// Processes items [begin, end) of a loop.
+typedef void (*ParallelForProc)(int begin, int end, void* userData);
+
+// Returns how many threads ParallelFor will split work across.
+int GetNumParallelWorkers(void);
+
+// Splits the range [0, count) into contiguous chunks and runs proc on each chunk
+// on its own thread (the calling thread takes the first chunk). Returns once all chunks are done.
+// Threads are spawned per call, so this is meant for heavy, infrequent work (e.g. level loading).
+void ParallelFor(int count, ParallelForProc proc, void* userData);
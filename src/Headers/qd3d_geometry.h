@@ -12,17 +12,8 @@ enum
 	SHARD_MODE_NULLSHADER		= (1 << 3)
 };
 
-#define	MAX_SHARDS			80
-
-typedef struct
-{
-	TQ3Vector3D				rot,rotDelta;
-	TQ3Point3D				coord,coordDelta;
-	float					decaySpeed,scale;
-	Byte					mode;
-	TQ3Matrix4x4			matrix;
-	TQ3TriMeshData			*mesh;
-}ShardType;
+#define	MAX_SHARDS			1024		// shards are batched into one mesh per material, so this can be generous
+#define	MAX_SHARD_MATERIALS	16			// max distinct texture/color combos among live shards
 
 void QD3D_CalcObjectBoundingBox(int numMeshes, TQ3TriMeshData** meshList, TQ3BoundingBox* boundingBox);
 void QD3D_CalcObjectBoundingSphere(int numMeshes, TQ3TriMeshData** meshList, TQ3BoundingSphere* boundingSphere);
@@ -41,6 +41,14 @@ typedef struct RenderModifiers
 	// Note that opaque meshes within the same draw order group are drawn front-to-back,
 	// and transparent meshes are drawn back-to-front.
 	int						drawOrder;
+
+	// If nonzero, the mesh's vertices are drawn as camera-facing point sprites
+	// of this diameter (in pixels) instead of drawing the mesh's triangles.
+	float					pointSize;
+
+	// Offset added to the mesh's texture coordinates (through the texture matrix).
+	// Lets scrolling textures animate without rewriting the mesh's UVs.
+	TQ3Param2D				uvOffset;
 } RenderModifiers;
 
 enum
@@ -177,6 +185,17 @@ void Render_SubmitMesh(
 		const RenderModifiers* mods,
 		const TQ3Point3D* centerCoord);
 
+// Same as Render_SubmitMesh, but draws the mesh's vertices with a separate list of 16-bit indices
+// (3 per triangle) instead of mesh->triangles. numTriangles may differ from mesh->numTriangles.
+// IMPORTANT: the index list must remain valid until Render_FlushQueue().
+void Render_SubmitMeshWithShortIndices(
+		const TQ3TriMeshData* mesh,
+		int numTriangles,
+		const uint16_t* indices,
+		const TQ3Matrix4x4* transform,
+		const RenderModifiers* mods,
+		const TQ3Point3D* centerCoord);
+
 #pragma mark -
 
 void Render_Enter2D_Full640x480(void);
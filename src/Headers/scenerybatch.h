@@ -0,0 +1,35 @@
+#pragma once
+
+// Static scenery batches.
+//
+// Scenery that never moves once spawned (grass, flowers, reeds, posts...) gets merged
+// into one mesh per texture for each supertile, already in world space. Each batch is
+// drawn as a whole instead of node by node.
+//
+// The ObjNodes stay alive for collision and terrain item tracking; they just don't draw
+// themselves. A batch gets rebuilt whenever a node joins or leaves it, and freed when
+// its last node goes away (i.e. when its supertile scrolls out of range). Trees are
+// never deleted, so a supertile with a tree keeps its batch for the whole level.
+//
+// If a batched node gets hidden, or the batch reaches the auto-fade zone, the whole
+// supertile falls back to drawing its nodes one by one for that frame.
+
+#define	MAX_SCENERY_BATCH_CELLS		MAX_SUPERTILES	// supertiles with batched scenery at any one time
+#define	MAX_SCENERY_PER_CELL		128
+#define	MAX_SCENERY_BATCH_MESHES	8			// distinct textures per supertile
+
+// Moves a freshly-created display group node into its supertile's batch.
+// The node's transform must never change afterwards.
+// Returns false if the node can't be batched (it keeps drawing itself).
+Boolean AddToSceneryBatch(ObjNode *theNode);
+
+// Called by DetachObject.
+void RemoveFromSceneryBatch(ObjNode *theNode);
+
+// Rebuilds dirty batches, culls them and submits them. Must be called before DrawObjects.
+void DrawSceneryBatches(const QD3DSetupOutputType *setupInfo);
+
+// True if DrawObjects should skip theNode because its batch took care of it this frame.
+Boolean IsDrawnBySceneryBatch(const ObjNode *theNode);
+
+void DisposeSceneryBatches(void);
@@ -0,0 +1,89 @@
+//
+// simd.h
+// Minimal 4-wide float vector helpers.
+// Maps to SSE2 on x86, NEON on ARM, and plain structs everywhere else (e.g. PowerPC).
+// Define BUGDOM_NO_SIMD to force the portable fallback.
+//
+
+#pragma once
+
+#if !defined(BUGDOM_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define SIMD_SSE2 1
+	#include <emmintrin.h>
+	typedef __m128 Vec4f;
+#elif !defined(BUGDOM_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64))
+	#define SIMD_NEON 1
+	#include <arm_neon.h>
+	typedef float32x4_t Vec4f;
+#else
+	#define SIMD_SCALAR 1
+	typedef struct { float v[4]; } Vec4f;
+#endif
+
+#if SIMD_SSE2
+
+static inline Vec4f Vec4f_Load(const float* p)				{ return _mm_loadu_ps(p); }
+static inline void  Vec4f_Store(float* p, Vec4f a)			{ _mm_storeu_ps(p, a); }
+static inline Vec4f Vec4f_Set1(float x)						{ return _mm_set1_ps(x); }
+static inline Vec4f Vec4f_Set(float x, float y, float z, float w)	{ return _mm_setr_ps(x, y, z, w); }
+static inline Vec4f Vec4f_Add(Vec4f a, Vec4f b)				{ return _mm_add_ps(a, b); }
+static inline Vec4f Vec4f_Sub(Vec4f a, Vec4f b)				{ return _mm_sub_ps(a, b); }
+static inline Vec4f Vec4f_Mul(Vec4f a, Vec4f b)				{ return _mm_mul_ps(a, b); }
+static inline Vec4f Vec4f_Div(Vec4f a, Vec4f b)				{ return _mm_div_ps(a, b); }
+static inline Vec4f Vec4f_MulAdd(Vec4f a, Vec4f b, Vec4f c)	{ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline Vec4f Vec4f_Min(Vec4f a, Vec4f b)				{ return _mm_min_ps(a, b); }
+static inline Vec4f Vec4f_Max(Vec4f a, Vec4f b)				{ return _mm_max_ps(a, b); }
+
+#elif SIMD_NEON
+
+static inline Vec4f Vec4f_Load(const float* p)				{ return vld1q_f32(p); }
+static inline void  Vec4f_Store(float* p, Vec4f a)			{ vst1q_f32(p, a); }
+static inline Vec4f Vec4f_Set1(float x)						{ return vdupq_n_f32(x); }
+static inline Vec4f Vec4f_Set(float x, float y, float z, float w)	{ const float t[4] = {x, y, z, w}; return vld1q_f32(t); }
+static inline Vec4f Vec4f_Add(Vec4f a, Vec4f b)				{ return vaddq_f32(a, b); }
+static inline Vec4f Vec4f_Sub(Vec4f a, Vec4f b)				{ return vsubq_f32(a, b); }
+static inline Vec4f Vec4f_Mul(Vec4f a, Vec4f b)				{ return vmulq_f32(a, b); }
+#if defined(__aarch64__) || defined(_M_ARM64)
+static inline Vec4f Vec4f_Div(Vec4f a, Vec4f b)				{ return vdivq_f32(a, b); }
+#else
+// ARMv7 NEON has no exact divide; do it per lane so results match scalar code
+static inline Vec4f Vec4f_Div(Vec4f a, Vec4f b)
+{
+	float ta[4], tb[4];
+	vst1q_f32(ta, a);
+	vst1q_f32(tb, b);
+	for (int i = 0; i < 4; i++) ta[i] /= tb[i];
+	return vld1q_f32(ta);
+}
+#endif
+static inline Vec4f Vec4f_MulAdd(Vec4f a, Vec4f b, Vec4f c)	{ return vmlaq_f32(c, a, b); }
+static inline Vec4f Vec4f_Min(Vec4f a, Vec4f b)				{ return vminq_f32(a, b); }
+static inline Vec4f Vec4f_Max(Vec4f a, Vec4f b)				{ return vmaxq_f32(a, b); }
+
+#else
+
+static inline Vec4f Vec4f_Load(const float* p)				{ Vec4f r = {{p[0], p[1], p[2], p[3]}}; return r; }
+static inline void  Vec4f_Store(float* p, Vec4f a)			{ p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+static inline Vec4f Vec4f_Set1(float x)						{ Vec4f r = {{x, x, x, x}}; return r; }
+static inline Vec4f Vec4f_Set(float x, float y, float z, float w)	{ Vec4f r = {{x, y, z, w}}; return r; }
+
+#define SIMD_SCALAR_OP(name, expr)								\
+	static inline Vec4f name(Vec4f a, Vec4f b)					\
+	{															\
+		Vec4f r;												\
+		for (int i = 0; i < 4; i++) r.v[i] = (expr);			\
+		return r;												\
+	}
+
+SIMD_SCALAR_OP(Vec4f_Add, a.v[i] + b.v[i])
+SIMD_SCALAR_OP(Vec4f_Sub, a.v[i] - b.v[i])
+SIMD_SCALAR_OP(Vec4f_Mul, a.v[i] * b.v[i])
+SIMD_SCALAR_OP(Vec4f_Div, a.v[i] / b.v[i])
+SIMD_SCALAR_OP(Vec4f_Min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+SIMD_SCALAR_OP(Vec4f_Max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+
+#undef SIMD_SCALAR_OP
+
+static inline Vec4f Vec4f_MulAdd(Vec4f a, Vec4f b, Vec4f c)	{ return Vec4f_Add(Vec4f_Mul(a, b), c); }
+
+#endif
@@ -9,8 +9,22 @@ typedef struct
 	short	effectNum;
 	float	volumeAdjust;
 	float	leftVolume, rightVolume;
+	Boolean	isBusy;					// cached playback state, so we don't need to poll the mixer
+	uint32_t startStamp;			// when the effect was started (higher == more recent)
+	Boolean	hasEmitterUpdate;		// emitterCoord was set this frame
+	TQ3Point3D emitterCoord;
+	uint16_t generation;			// bumped whenever the voice starts or stops an effect (see channel handles in Sound.c)
 }ChannelInfoType;
 
+typedef struct VoiceStats
+{
+	int			voicesBusy;			// effect channels playing at the end of the last frame
+	int			voicesTotal;
+	int			started;			// effects started during the last frame
+	int			stolen;				// ...of which took over a busy channel
+	int			dropped;			// effects that couldn't get a channel during the last frame
+} VoiceStats;
+
 #define		FULL_CHANNEL_VOLUME		kFullVolume
 
 
@@ -118,6 +132,7 @@ extern void	DoSoundMaintenance(void);
 void LoadSoundEffect(int effectNum);
 void DisposeSoundEffect(int effectNum);
 void LoadSoundBank(int bankNum);
+void LoadResidentSoundBank(int bankNum);
 void DisposeSoundBank(int bankNum);
 void DisposeAllSoundBanks(void);
 void PauseAllChannels(Boolean pause);
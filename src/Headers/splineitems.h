@@ -15,6 +15,9 @@ Boolean RemoveFromSplineObjectList(ObjNode *theNode);
 void EmptySplineObjectList(void);
 float IncreaseSplineIndex(ObjNode *theNode, float speed);
 float IncreaseSplineIndexZigZag(ObjNode *theNode, float speed);
+float IncreaseSplineDistance(ObjNode *theNode, float unitsPerSecond);
+float GetSplineDistanceAtPlacement(const SplineDefType* spline, float placement);
+float GetSplinePlacementAtDistance(const SplineDefType* spline, float distance);
 void DrawSplines(void);
 
 void PatchSplineLoop(SplineDefType* spline);
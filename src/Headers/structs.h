@@ -65,6 +65,11 @@ typedef struct
 	SplineItemType	**itemList;			// handle to spline items
 	
 	Rect			bBox;				// bounding box of spline area
+
+	float			*arcLengths;		// distance from point 0 to each point, [numPoints] = length of whole loop (built by PrimeSplines)
+	short			numSuperTiles;		// # of distinct supertiles that the spline passes through
+	Byte			(*superTiles)[2];	// row & col of each of those supertiles
+	Boolean			isOnActiveSuperTile;	// set each frame by MoveSplineObjects
 }SplineDefType;
 
 
@@ -288,6 +293,7 @@ struct ObjNode
 	bool					OwnsMeshTexture[MAX_DECOMPOSED_TRIMESHES];		// if true, DeleteObject will call glDeleteTextures on the corresponding mesh's texture (if any)
 	bool					OwnsMeshMemory[MAX_DECOMPOSED_TRIMESHES];		// if true, DeleteObject will call Q3TriMeshData_Dispose on the corresponding mesh
 	RenderModifiers			RenderModifiers;
+	struct SceneryBatchCell	*SceneryBatch;			// supertile batch that draws this node (nil if it draws itself)
 
 	SkeletonObjDataType	*Skeleton;				// pointer to skeleton record data	
 
@@ -297,7 +303,7 @@ struct ObjNode
 	float				SplinePlacement;		// 0.0->.9999 for placement on spline
 	short				SplineObjectIndex;		// index into gSplineObjectList of this ObjNode
 
-	short				EffectChannel;			// effect sound channel index (-1 = none)
+	short				EffectChannel;			// effect sound channel handle (-1 = none)
 	int32_t				ParticleGroup;
 };
 typedef struct ObjNode ObjNode;
@@ -342,4 +348,6 @@ typedef struct
 	int		fullscreenRefreshRate;
 	int		msaa;
 	int		vsync;
+	int		pointSpriteParticles;
+	int		numEffectVoices;
 } CommandLineOptions;
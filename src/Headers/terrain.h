@@ -72,7 +72,7 @@ enum
 
 #define	TERRAIN_SUPERTILE_UNIT_SIZE	(SUPERTILE_SIZE*TERRAIN_POLYGON_SIZE)		// world unit size of a supertile
 
-#define	MAX_SUPERTILE_ACTIVE_RANGE	5					// max value of gSuperTileActiveRange
+#define	MAX_SUPERTILE_ACTIVE_RANGE	8					// max value of gSuperTileActiveRange (distant supertiles are decimated, see DrawTerrain)
 // The largest map in the game (Night.ter) is 50x40 supertiles == 2000 supertiles.
 // Therefore, the maximum useful value for MAX_SUPERTILE_ACTIVE_RANGE is 23 (because (23*2)**2 == 2116 supertiles)
 
@@ -107,6 +107,7 @@ struct SuperTileMemoryType
 	uint32_t			glTextureName[MAX_LAYERS][MAX_LODS];	// OpenGL texture name for floor & ceiling at all LODs
 	uint16_t*			textureData[MAX_LAYERS][MAX_LODS];		// pixel data for floor & ceiling at all LODs
 	TQ3TriMeshData*		triMeshDataPtrs[MAX_LAYERS];			// trimesh's data for the supertile (floor & ceiling)
+	uint16_t			triangleIndices[MAX_LAYERS][NUM_TRIS_IN_SUPERTILE*3];	// 16-bit index list that's actually drawn (floor & ceiling)
 	float				radius[MAX_LAYERS];						// radius of this supertile (floor & ceiling)
 };
 typedef struct SuperTileMemoryType SuperTileMemoryType;
@@ -164,12 +165,15 @@ extern	void GetSuperTileInfo(long x, long z, long *superCol, long *superRow, lon
 extern	void InitTerrainManager(void);
 extern	void ClearScrollBuffer(void);
 float	GetTerrainHeightAtCoord(float x, float z, long layer);
+void	GetTerrainHeightsAtCoords(int n, const float* xs, const float* zs, long layer, float* outY);
+void	BuildTerrainPlaneTable(void);
 void InitCurrentScrollSettings(void);
 
 
 
 extern 	void BuildTerrainItemList(void);
 extern 	void ScanForPlayfieldItems(long top, long bottom, long left, long right);
+void DisposeTerrainItemGrid(void);
 
 Boolean IsPositionOutOfRange(float x, float z);
 Boolean IsPositionOutOfRange_Far(float x, float z, float range);
@@ -11,6 +11,7 @@
 /****************************/
 
 #include "game.h"
+#include "simd.h"
 
 
 /****************************/
@@ -18,7 +19,8 @@
 /****************************/
 
 
-static void MoveRipple(ObjNode *theNode);
+static void FlushFreeParticleBlocks(void);
+static void DeleteAllRipples(void);
 
 
 
@@ -27,16 +29,71 @@ static void MoveRipple(ObjNode *theNode);
 /****************************/
 
 #define	MAX_PARTICLE_GROUPS		50
-#define	MAX_PARTICLES			200		// (note change Byte below if > 255)
+#define	MAX_PARTICLES			4096	// per group
 #define	NUM_PARTICLE_TEXTURES	8
 
-_Static_assert(MAX_PARTICLES <= 255, "rewrite ParticleGroupType to support > 255 particles");
+		/* PARTICLE ARENA */
+		//
+		// Groups draw their particle storage from a shared arena of blocks in
+		// power-of-two capacity classes (16, 32, ... MAX_PARTICLES particles).
+		// A group moves up to the next class when it fills up, and its old block
+		// goes back to the arena's free list for that class.
+		//
+
+#define	MIN_PARTICLE_CAPACITY			16
+#define	NUM_PARTICLE_CAPACITY_CLASSES	9
+#define	NUM_PARTICLE_FIELDS				8		// x, y, z, dx, dy, dz, scale, alpha
+#define	PARTICLE_ARENA_BUDGET			(2*1024*1024)	// bytes
+
+_Static_assert((MIN_PARTICLE_CAPACITY << (NUM_PARTICLE_CAPACITY_CLASSES-1)) == MAX_PARTICLES, "largest capacity class must hold MAX_PARTICLES");
+
+		/* GRAVITOID INTERACTION */
+		//
+		// Gravitoid particles are binned into a pyramid of cubic grids over the group's
+		// bounds: 1 cell at the top level, then 2x2x2, 4x4x4... down to the finest grid.
+		// Each cell knows its mass (# of particles) and center of gravity.
+		//
+		// A particle walks the pyramid from the top (Barnes-Hut style). A cell that is far
+		// enough away pulls as a single mass; otherwise its 8 children are visited.
+		// Finest cells that are still too close pull particle by particle.
+		//
+		// GRAVITOID_ACCURACY is the opening threshold: a cell is treated as a single
+		// mass when (cell size / distance to its center of gravity) < GRAVITOID_ACCURACY.
+		// 0 forces exact pairwise interaction; larger values are faster but coarser.
+		//
+
+#define	GRAVITOID_ACCURACY				0.8f
+#define	GRAVITOID_PARTICLES_PER_CELL	4
+#define	MAX_GRAVITOID_LEVELS			5		// grids of 1, 2, 4, 8, 16 cells per axis
+#define	MAX_GRAVITOID_GRID_SIZE			(1 << (MAX_GRAVITOID_LEVELS - 1))
+#define	MAX_GRAVITOID_CELLS				(MAX_GRAVITOID_GRID_SIZE * MAX_GRAVITOID_GRID_SIZE * MAX_GRAVITOID_GRID_SIZE)
+#define	MAX_GRAVITOID_PYRAMID_CELLS		(((1 << (3 * MAX_GRAVITOID_LEVELS)) - 1) / 7)		// 1 + 8 + 64 + ...
+#define	GRAVITOID_LEVEL_OFFSET(level)	(((1 << (3 * (level))) - 1) / 7)					// index of level's first cell in pyramid
+
+		/* RIPPLES */
+		//
+		// Ripples are kept in a fixed pool (no ObjNodes), and all live ripples
+		// are drawn as a single mesh.
+		//
+
+#define	MAX_RIPPLES				64
+#define	MAX_RIPPLE_MESHES		4		// meshes in the ripple model
+#define	RIPPLE_START_ALPHA		.8f
+#define	RIPPLE_FADE_RATE		.8f		// alpha lost per second
+#define	RIPPLE_GROWTH_RATE		6.0f	// scale gained per second
+
 _Static_assert(MAX_PARTICLE_GROUPS <= 255, "particle group IDs currently assume the group index will fit in 8 bits");
 
+typedef struct ParticleBlock
+{
+	struct ParticleBlock*	next;				// next free block in the same capacity class
+	int						capacityClass;
+	float					data[];				// NUM_PARTICLE_FIELDS arrays of the class's capacity
+}ParticleBlock;
+
 typedef struct
 {
 	int32_t			magicNum;
-	Pool			*pool;
 	Byte			type;
 	uint8_t			flags;
 	Byte			particleTextureNum;
@@ -45,14 +102,25 @@ typedef struct
 	float			baseScale;
 	float			decayRate;			// shrink speed
 	float			fadeRate;
-	
-	float			alpha[MAX_PARTICLES];
-	float			scale[MAX_PARTICLES];
-	TQ3Point3D		coord[MAX_PARTICLES];
-	TQ3Vector3D		delta[MAX_PARTICLES];
+
+	int				numParticles;		// live particles are packed in [0, numParticles)
+	int				capacity;
+	ParticleBlock	*block;
+	float			*x, *y, *z;			// SoA views into block
+	float			*dx, *dy, *dz;
+	float			*scale;
+	float			*alpha;
+
+	int				meshCapacity;
 	TQ3TriMeshData	*mesh;
 }ParticleGroupType;
 
+typedef struct
+{
+	Byte			level;
+	Byte			cx, cy, cz;
+}GravitoidCellRef;							// a cell of the gravitoid pyramid
+
 static inline ParticleGroupType* GetValidParticleGroup(int32_t groupID);
 
 
@@ -68,65 +136,263 @@ static int32_t				gParticleGroupMagicAllocator = 0;
 static GLuint				gParticleTextureNames[NUM_PARTICLE_TEXTURES];
 static bool					gParticleTexturesLoaded = false;
 
-static float	gGravitoidDistBuffer[MAX_PARTICLES][MAX_PARTICLES];
+static ParticleBlock*		gFreeParticleBlocks[NUM_PARTICLE_CAPACITY_CLASSES];
+
+int							gNumLiveParticles = 0;
+int							gNumDroppedParticles = 0;
+int							gParticleArenaBytes = 0;
+
+		/* GRAVITOID PYRAMID (REBUILT FOR EACH GROUP) */
+
+static int			gGravitoidCellOf[MAX_PARTICLES];					// finest cell of each particle
+static int			gGravitoidSortedParticles[MAX_PARTICLES];			// particle indices sorted by finest cell
+static int			gGravitoidCellStart[MAX_GRAVITOID_CELLS + 1];		// range of each finest cell in gGravitoidSortedParticles
+static float		gGravitoidCellMass[MAX_GRAVITOID_PYRAMID_CELLS];
+static TQ3Point3D	gGravitoidCellCenterOfGravity[MAX_GRAVITOID_PYRAMID_CELLS];
+static int			gGravitoidFarCells[MAX_GRAVITOID_PYRAMID_CELLS];	// cells pulling the current finest cell as one mass
+static int			gGravitoidNearCells[MAX_GRAVITOID_CELLS];			// finest cells pulling it particle by particle
+static float		gGravitoidPullX[MAX_PARTICLES];						// sum of pulls on each particle
+static float		gGravitoidPullY[MAX_PARTICLES];
+static float		gGravitoidPullZ[MAX_PARTICLES];
 
 static RenderModifiers kParticleGroupRenderingMods;
+static RenderModifiers gParticleSpriteRenderingMods[MAX_PARTICLE_GROUPS];
+
+		/* VISIBLE PARTICLES OF THE GROUP BEING DRAWN */
+
+static float	gVisibleParticleX[MAX_PARTICLES];
+static float	gVisibleParticleY[MAX_PARTICLES];
+static float	gVisibleParticleZ[MAX_PARTICLES];
+static float	gVisibleParticleSize[MAX_PARTICLES];
+static float	gVisibleParticleAlpha[MAX_PARTICLES];
+
+float			gParticleDrawMilliseconds = 0;
+
+		/* RIPPLE POOL */
+
+static float			gRippleX[MAX_RIPPLES];
+static float			gRippleY[MAX_RIPPLES];
+static float			gRippleZ[MAX_RIPPLES];
+static float			gRippleScale[MAX_RIPPLES];
+static float			gRippleAlpha[MAX_RIPPLES];
+int						gNumRipples = 0;
+
+static TQ3TriMeshData	*gRippleBatchMeshes[MAX_RIPPLE_MESHES];
+
+static const RenderModifiers kRippleRenderMods =
+{
+	.statusBits = STATUS_BIT_NOFOG | STATUS_BIT_GLOW | STATUS_BIT_NOZWRITE | STATUS_BIT_DONTCULL,
+	.diffuseColor = {1,1,1,1},
+	.autoFadeFactor = 1.0f,
+	.drawOrder = kDrawOrder_Ripples,					// draw ripples after water
+};
 
 
 #pragma mark -
 
 
 /************************* MAKE RIPPLE *********************************/
+//
+// Ripples live in a fixed pool rather than in ObjNodes.
+// If the pool is full, the most faded ripple gets recycled.
+//
 
-ObjNode *MakeRipple(float x, float y, float z, float startScale)
-{
-ObjNode	*newObj;
-
-	gNewObjectDefinition.group = GLOBAL1_MGroupNum_Ripple;	
-	gNewObjectDefinition.type = GLOBAL1_MObjType_Ripple;	
-	gNewObjectDefinition.coord.x = x;
-	gNewObjectDefinition.coord.y = y;
-	gNewObjectDefinition.coord.z = z;
-	gNewObjectDefinition.flags 	= STATUS_BIT_NOFOG|STATUS_BIT_GLOW|STATUS_BIT_NOZWRITE|STATUS_BIT_DONTCULL;
-	gNewObjectDefinition.slot 	= SLOT_OF_DUMB+2;
-	gNewObjectDefinition.moveCall = MoveRipple;
-	gNewObjectDefinition.rot = 0;
-	gNewObjectDefinition.scale = startScale;
-	newObj = MakeNewDisplayGroupObject(&gNewObjectDefinition);
-	if (newObj == nil)
-		return(nil);
-
-	newObj->RenderModifiers.drawOrder = kDrawOrder_Ripples;				// draw ripples after water
-
-	newObj->Health = .8;										// transparency value
-	
-	MakeObjectTransparent(newObj, newObj->Health);
-	
-	return(newObj);
-}
+void MakeRipple(float x, float y, float z, float startScale)
+{
+int		i;
+
+	if (gNumRipples < MAX_RIPPLES)
+	{
+		i = gNumRipples++;
+	}
+	else
+	{
+		i = 0;
+		for (int j = 1; j < MAX_RIPPLES; j++)
+		{
+			if (gRippleAlpha[j] < gRippleAlpha[i])
+				i = j;
+		}
+	}
 
+	gRippleX[i]		= x;
+	gRippleY[i]		= y;
+	gRippleZ[i]		= z;
+	gRippleScale[i]	= startScale;
+	gRippleAlpha[i]	= RIPPLE_START_ALPHA;
+}
 
 
-/******************** MOVE RIPPLE ************************/
+/******************** MOVE RIPPLES ************************/
 
-static void MoveRipple(ObjNode *theNode)
+void MoveRipples(void)
 {
 float	fps = gFramesPerSecondFrac;
 
-	theNode->Health -= fps * .8f;
-	if (theNode->Health < 0)
+	for (int i = 0; i < gNumRipples; )
+	{
+		gRippleAlpha[i] -= fps * RIPPLE_FADE_RATE;
+		if (gRippleAlpha[i] < 0)							// gone: move last ripple into this slot
+		{
+			int last = --gNumRipples;
+			gRippleX[i]		= gRippleX[last];
+			gRippleY[i]		= gRippleY[last];
+			gRippleZ[i]		= gRippleZ[last];
+			gRippleScale[i]	= gRippleScale[last];
+			gRippleAlpha[i]	= gRippleAlpha[last];
+			continue;
+		}
+
+		gRippleScale[i] += fps * RIPPLE_GROWTH_RATE;
+		i++;
+	}
+}
+
+
+/******************** GET RIPPLE BATCH MESH ************************/
+//
+// Returns a mesh big enough to hold MAX_RIPPLES copies of the given mesh of the ripple model.
+// UVs, normals and triangles are the same every frame, so they're filled in once here.
+//
+
+static TQ3TriMeshData* GetRippleBatchMesh(int meshNum, const TQ3TriMeshData* src)
+{
+TQ3TriMeshData	*mesh = gRippleBatchMeshes[meshNum];
+
+	if (mesh)
+		return mesh;
+
+	mesh = Q3TriMeshData_New(MAX_RIPPLES * src->numTriangles, MAX_RIPPLES * src->numPoints,
+							 kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexNormals | kQ3TriMeshDataFeatureVertexColors);
+
+	mesh->texturingMode		= src->texturingMode;
+	mesh->glTextureName		= src->glTextureName;
+	mesh->diffuseColor		= (TQ3ColorRGBA) { 1, 1, 1, 1 };
+
+	for (int i = 0; i < MAX_RIPPLES; i++)
 	{
-		DeleteObject(theNode);
+		int base = i * src->numPoints;
+
+		if (src->vertexUVs)
+			memcpy(&mesh->vertexUVs[base], src->vertexUVs, src->numPoints * sizeof(TQ3Param2D));
+
+		if (src->hasVertexNormals)
+			memcpy(&mesh->vertexNormals[base], src->vertexNormals, src->numPoints * sizeof(TQ3Vector3D));
+		else
+		{
+			for (int v = 0; v < src->numPoints; v++)
+				mesh->vertexNormals[base+v] = (TQ3Vector3D) { 0, 1, 0 };
+		}
+
+		for (int t = 0; t < src->numTriangles; t++)
+		{
+			TQ3TriMeshTriangleData* tri = &mesh->triangles[i * src->numTriangles + t];
+			tri->pointIndices[0] = src->triangles[t].pointIndices[0] + base;
+			tri->pointIndices[1] = src->triangles[t].pointIndices[1] + base;
+			tri->pointIndices[2] = src->triangles[t].pointIndices[2] + base;
+		}
+	}
+
+	gRippleBatchMeshes[meshNum] = mesh;
+	return mesh;
+}
+
+
+/******************** DRAW RIPPLES ************************/
+//
+// Expands every live ripple into world space and submits them all in one mesh
+// (per mesh in the ripple model).
+//
+
+void DrawRipples(void)
+{
+	if (gNumRipples == 0)
 		return;
+
+	const TQ3TriMeshFlatGroup* model = &gObjectGroupList[GLOBAL1_MGroupNum_Ripple][GLOBAL1_MObjType_Ripple];
+	GAME_ASSERT(model->numMeshes <= MAX_RIPPLE_MESHES);
+
+	for (int m = 0; m < model->numMeshes; m++)
+	{
+		const TQ3TriMeshData* src = model->meshes[m];
+		TQ3TriMeshData* mesh = GetRippleBatchMesh(m, src);
+
+		for (int i = 0; i < gNumRipples; i++)
+		{
+			const float x = gRippleX[i];
+			const float y = gRippleY[i];
+			const float z = gRippleZ[i];
+			const float s = gRippleScale[i];
+			int base = i * src->numPoints;
+
+					/* SCALE & MOVE POINTS */
+
+			for (int v = 0; v < src->numPoints; v++)
+			{
+				mesh->points[base+v].x = src->points[v].x * s + x;
+				mesh->points[base+v].y = src->points[v].y * s + y;
+				mesh->points[base+v].z = src->points[v].z * s + z;
+			}
+
+					/* FADE */
+					//
+					// Same math as the renderer's alpha pass: per-vertex colors ignore the diffuse colors.
+					//
+
+			if (src->hasVertexColors)
+			{
+				memcpy(&mesh->vertexColors[base], src->vertexColors, src->numPoints * sizeof(TQ3ColorRGBA));
+			}
+			else
+			{
+				TQ3ColorRGBA color = src->diffuseColor;
+				color.a *= gRippleAlpha[i];
+
+				for (int v = 0; v < src->numPoints; v++)
+					mesh->vertexColors[base+v] = color;
+			}
+		}
+
+		mesh->numPoints		= gNumRipples * src->numPoints;
+		mesh->numTriangles	= gNumRipples * src->numTriangles;
+
+				/* CALC BOUNDING BOX FOR DEPTH SORTING */
+
+		mesh->bBox.min = mesh->bBox.max = mesh->points[0];
+		for (int v = 1; v < mesh->numPoints; v++)
+		{
+			const TQ3Point3D* p = &mesh->points[v];
+			if (p->x < mesh->bBox.min.x) mesh->bBox.min.x = p->x;
+			if (p->y < mesh->bBox.min.y) mesh->bBox.min.y = p->y;
+			if (p->z < mesh->bBox.min.z) mesh->bBox.min.z = p->z;
+			if (p->x > mesh->bBox.max.x) mesh->bBox.max.x = p->x;
+			if (p->y > mesh->bBox.max.y) mesh->bBox.max.y = p->y;
+			if (p->z > mesh->bBox.max.z) mesh->bBox.max.z = p->z;
+		}
+		mesh->bBox.isEmpty = kQ3False;
+
+		Render_SubmitMesh(mesh, nil, &kRippleRenderMods, nil);
 	}
-	
-	MakeObjectTransparent(theNode, theNode->Health);
+}
 
-	theNode->Scale.x += fps*6.0f;
-	theNode->Scale.y += fps*6.0f;
-	theNode->Scale.z += fps*6.0f;
 
-	UpdateObjectTransforms(theNode);
+/******************** DELETE ALL RIPPLES ************************/
+//
+// The batch meshes copy the ripple model's texture, so they must go when the model does.
+//
+
+static void DeleteAllRipples(void)
+{
+	gNumRipples = 0;
+
+	for (int m = 0; m < MAX_RIPPLE_MESHES; m++)
+	{
+		if (gRippleBatchMeshes[m])
+		{
+			Q3TriMeshData_Dispose(gRippleBatchMeshes[m]);
+			gRippleBatchMeshes[m] = nil;
+		}
+	}
 }
 
 
@@ -137,47 +403,195 @@ float	fps = gFramesPerSecondFrac;
 #pragma mark -
 
 
-static void InitParticleGroup(ParticleGroupType* pg)
+/******************** CAPACITY OF PARTICLE CLASS **********************/
+
+static inline int GetParticleClassCapacity(int capacityClass)
 {
-			/* INITIALIZE THE GROUP */
+	return MIN_PARTICLE_CAPACITY << capacityClass;
+}
 
-	memset(pg, 0, sizeof(ParticleGroupType));
 
-	pg->pool = Pool_New(MAX_PARTICLES);
+/******************** ALLOCATE PARTICLE BLOCK **********************/
+//
+// Returns nil if the arena is over budget.
+//
 
-			/* INIT THE GROUP'S TRIMESH STRUCTURE */
+static ParticleBlock* AllocateParticleBlock(int capacityClass)
+{
+	GAME_ASSERT(capacityClass >= 0 && capacityClass < NUM_PARTICLE_CAPACITY_CLASSES);
 
-	pg->mesh = Q3TriMeshData_New(MAX_PARTICLES*2, MAX_PARTICLES*4, kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexColors);
+			/* REUSE A FREE BLOCK OF THIS CLASS */
+
+	ParticleBlock* block = gFreeParticleBlocks[capacityClass];
+	if (block)
+	{
+		gFreeParticleBlocks[capacityClass] = block->next;
+		block->next = nil;
+		return block;
+	}
+
+			/* MAKE ROOM IN ARENA */
+
+	int blockBytes = sizeof(ParticleBlock) + NUM_PARTICLE_FIELDS * GetParticleClassCapacity(capacityClass) * sizeof(float);
+
+	if (gParticleArenaBytes + blockBytes > PARTICLE_ARENA_BUDGET)
+	{
+		FlushFreeParticleBlocks();									// give back unused blocks of other classes
+
+		if (gParticleArenaBytes + blockBytes > PARTICLE_ARENA_BUDGET)
+			return nil;
+	}
+
+			/* ALLOCATE NEW BLOCK */
+
+	block = (ParticleBlock*) AllocPtr(blockBytes);
+	GAME_ASSERT(block);
+	block->next = nil;
+	block->capacityClass = capacityClass;
+
+	gParticleArenaBytes += blockBytes;
+	return block;
+}
 
-	pg->mesh->texturingMode = kQ3TexturingModeAlphaBlend;
-	pg->mesh->glTextureName = 0;
 
-	pg->mesh->bBox.isEmpty 			= kQ3False;
+/******************** RELEASE PARTICLE BLOCK **********************/
+
+static void ReleaseParticleBlock(ParticleBlock* block)
+{
+	block->next = gFreeParticleBlocks[block->capacityClass];
+	gFreeParticleBlocks[block->capacityClass] = block;
+}
+
+
+/******************** FLUSH FREE PARTICLE BLOCKS **********************/
+//
+// Returns the memory of all unused blocks to the system.
+//
+
+static void FlushFreeParticleBlocks(void)
+{
+	for (int c = 0; c < NUM_PARTICLE_CAPACITY_CLASSES; c++)
+	{
+		while (gFreeParticleBlocks[c])
+		{
+			ParticleBlock* block = gFreeParticleBlocks[c];
+			gFreeParticleBlocks[c] = block->next;
+
+			gParticleArenaBytes -= sizeof(ParticleBlock) + NUM_PARTICLE_FIELDS * GetParticleClassCapacity(c) * sizeof(float);
+			DisposePtr((Ptr) block);
+		}
+	}
+}
+
+
+/******************** NEW PARTICLE MESH **********************/
+
+static TQ3TriMeshData* NewParticleMesh(int capacity)
+{
+	TQ3TriMeshData* mesh = Q3TriMeshData_New(capacity*2, capacity*4, kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexColors);
+
+	mesh->texturingMode = kQ3TexturingModeAlphaBlend;
+	mesh->glTextureName = 0;
+
+	mesh->bBox.isEmpty 			= kQ3False;
 
 			/* INIT UV ARRAYS */
 
-	for (int j = 0; j < (MAX_PARTICLES*4); j += 4)
+	for (int j = 0; j < (capacity*4); j += 4)
 	{
-		pg->mesh->vertexUVs[j+0] = (TQ3Param2D) { 0, 1 };			// upper left
-		pg->mesh->vertexUVs[j+1] = (TQ3Param2D) { 0, 0 };			// lower left
-		pg->mesh->vertexUVs[j+2] = (TQ3Param2D) { 1, 0 };			// lower right
-		pg->mesh->vertexUVs[j+3] = (TQ3Param2D) { 1, 1 };			// upper right
+		mesh->vertexUVs[j+0] = (TQ3Param2D) { 0, 1 };			// upper left
+		mesh->vertexUVs[j+1] = (TQ3Param2D) { 0, 0 };			// lower left
+		mesh->vertexUVs[j+2] = (TQ3Param2D) { 1, 0 };			// lower right
+		mesh->vertexUVs[j+3] = (TQ3Param2D) { 1, 1 };			// upper right
 	}
 
 			/* INIT TRIANGLE ARRAYS */
 
-	for (int j = 0, k = 0; j < (MAX_PARTICLES*2); j += 2, k += 4)
+	for (int j = 0, k = 0; j < (capacity*2); j += 2, k += 4)
+	{
+		mesh->triangles[j].pointIndices[0] = k;				// triangle A
+		mesh->triangles[j].pointIndices[1] = k+1;
+		mesh->triangles[j].pointIndices[2] = k+2;
+
+		mesh->triangles[j+1].pointIndices[0] = k;				// triangle B
+		mesh->triangles[j+1].pointIndices[1] = k+2;
+		mesh->triangles[j+1].pointIndices[2] = k+3;
+	}
+
+	return mesh;
+}
+
+
+/******************** SET PARTICLE GROUP STORAGE **********************/
+//
+// Moves the group's particles into a block of the given capacity class.
+// Returns false if the arena couldn't provide the block.
+//
+
+static bool SetParticleGroupStorage(ParticleGroupType* pg, int capacityClass)
+{
+	int capacity = GetParticleClassCapacity(capacityClass);
+	GAME_ASSERT(pg->numParticles <= capacity);
+
+	ParticleBlock* block = AllocateParticleBlock(capacityClass);
+	if (!block)
+		return false;
+
+			/* COPY LIVE PARTICLES INTO NEW BLOCK */
+
+	float* fields = block->data;
+	float** views[NUM_PARTICLE_FIELDS] = { &pg->x, &pg->y, &pg->z, &pg->dx, &pg->dy, &pg->dz, &pg->scale, &pg->alpha };
+
+	for (int f = 0; f < NUM_PARTICLE_FIELDS; f++)
+	{
+		if (pg->numParticles > 0)
+			memcpy(fields, *views[f], pg->numParticles * sizeof(float));
+		*views[f] = fields;
+		fields += capacity;
+	}
+
+	if (pg->block)
+		ReleaseParticleBlock(pg->block);
+
+	pg->block = block;
+	pg->capacity = capacity;
+
+			/* MAKE SURE MESH CAN HOLD ALL PARTICLES */
+			//
+			// Meshes aren't given back to the arena; a group's mesh
+			// is reused by whichever group gets that slot next.
+			//
+
+	if (pg->meshCapacity < capacity)
 	{
-		pg->mesh->triangles[j].pointIndices[0] = k;				// triangle A
-		pg->mesh->triangles[j].pointIndices[1] = k+1;
-		pg->mesh->triangles[j].pointIndices[2] = k+2;
+		if (pg->mesh)
+			Q3TriMeshData_Dispose(pg->mesh);
 
-		pg->mesh->triangles[j+1].pointIndices[0] = k;				// triangle B
-		pg->mesh->triangles[j+1].pointIndices[1] = k+2;
-		pg->mesh->triangles[j+1].pointIndices[2] = k+3;
+		pg->mesh = NewParticleMesh(capacity);
+		pg->mesh->glTextureName = gParticleTextureNames[pg->particleTextureNum];
+		pg->meshCapacity = capacity;
 	}
+
+	return true;
 }
 
+
+/******************** RELEASE PARTICLE GROUP STORAGE **********************/
+
+static void ReleaseParticleGroupStorage(ParticleGroupType* pg)
+{
+	if (pg->block)
+		ReleaseParticleBlock(pg->block);
+
+	pg->block = nil;
+	pg->capacity = 0;
+	pg->numParticles = 0;
+	pg->x = pg->y = pg->z = nil;
+	pg->dx = pg->dy = pg->dz = nil;
+	pg->scale = pg->alpha = nil;
+}
+
+
 /************************ INIT PARTICLE SYSTEM **************************/
 
 void InitParticleSystem(void)
@@ -186,14 +600,14 @@ void InitParticleSystem(void)
 
 	if (!gParticleGroupsInitialized)
 	{
-		for (int i = 0; i < MAX_PARTICLE_GROUPS; i++)
-		{
-			InitParticleGroup(&gParticleGroups[i]);
-		}
+		memset(gParticleGroups, 0, sizeof(gParticleGroups));
 
 		gParticleGroupPool = Pool_New(MAX_PARTICLE_GROUPS);
 		gParticleGroupMagicAllocator = 0;
 		gParticleGroupsInitialized = true;
+
+		gNumLiveParticles = 0;
+		gNumDroppedParticles = 0;
 	}
 
 			/* LOAD PARTICLE TEXTURES */
@@ -233,13 +647,18 @@ void DeleteAllParticleGroups(void)
 			{
 				Q3TriMeshData_Dispose(gParticleGroups[i].mesh);
 				gParticleGroups[i].mesh = nil;
+				gParticleGroups[i].meshCapacity = 0;
 			}
 
-			// Free particle pool
-			Pool_Free(gParticleGroups[i].pool);
-			gParticleGroups[i].pool = NULL;
+			// Give particle storage back to arena
+			ReleaseParticleGroupStorage(&gParticleGroups[i]);
 		}
 
+		// Free arena memory
+		FlushFreeParticleBlocks();
+		GAME_ASSERT(gParticleArenaBytes == 0);
+		gNumLiveParticles = 0;
+
 		// Free particle group pool
 		Pool_Free(gParticleGroupPool);
 		gParticleGroupPool = NULL;
@@ -247,6 +666,8 @@ void DeleteAllParticleGroups(void)
 		gParticleGroupsInitialized = false;
 	}
 
+	DeleteAllRipples();
+
 	// Also delete textures
 	if (gParticleTexturesLoaded)
 	{
@@ -305,10 +726,13 @@ int32_t NewParticleGroup(
 	pg->magicNum = gParticleGroupMagicAllocator;
 	pg->particleTextureNum = particleTextureNum;
 
-			/* INIT THE GROUP'S TRIMESH STRUCTURE */
+			/* INIT THE GROUP'S TRIMESH STRUCTURE (IF IT HAS ONE YET) */
 
-	pg->mesh->texturingMode = kQ3TexturingModeAlphaBlend;
-	pg->mesh->glTextureName = gParticleTextureNames[particleTextureNum];
+	if (pg->mesh)
+	{
+		pg->mesh->texturingMode = kQ3TexturingModeAlphaBlend;
+		pg->mesh->glTextureName = gParticleTextureNames[particleTextureNum];
+	}
 
 			/* MAKE ID */
 
@@ -345,26 +769,355 @@ bool AddParticleToGroup(int32_t groupID, TQ3Point3D *where, TQ3Vector3D *delta,
 	}
 
 
-			/* SCAN FOR FREE SLOT */
-
-	int p = Pool_AllocateIndex(pg->pool);
+			/* GROW GROUP IF FULL */
 
-			/* NO FREE SLOTS */
+	if (pg->numParticles == pg->capacity)
+	{
+		int capacityClass = pg->block ? pg->block->capacityClass + 1 : 0;
 
-	if (p < 0)
-		return true;
+		if (capacityClass >= NUM_PARTICLE_CAPACITY_CLASSES		// group is at max size
+			|| !SetParticleGroupStorage(pg, capacityClass))		// or arena is full
+		{
+			gNumDroppedParticles++;
+			return true;
+		}
+	}
 
 			/* INIT PARAMETERS */
 
+	int p = pg->numParticles++;
+
 	pg->alpha[p] = alpha;
 	pg->scale[p] = scale;
-	pg->coord[p] = *where;
-	pg->delta[p] = *delta;
+	pg->x[p] = where->x;
+	pg->y[p] = where->y;
+	pg->z[p] = where->z;
+	pg->dx[p] = delta->x;
+	pg->dy[p] = delta->y;
+	pg->dz[p] = delta->z;
 
 	return(false);
 }
 
 
+/****************** ADD GRAVITOID PULL *********************/
+//
+// Pull of a mass at (x,y,z) on the particle at (fromX,fromY,fromZ), weighted by 'mass' particles.
+//
+
+static inline void AddGravitoidPull(float fromX, float fromY, float fromZ, float x, float y, float z, float mass,
+									float oneOverBaseScaleSquared, TQ3Vector3D* pull)
+{
+	float dx = x - fromX;
+	float dy = y - fromY;
+	float dz = z - fromZ;
+	float distSquared = dx*dx + dy*dy + dz*dz;
+
+	if (distSquared == 0.0f)								// no pull if on top of each other
+		return;
+
+	float oneOverDist = 1.0f / sqrtf(distSquared);
+	float force = oneOverDist * oneOverDist;				// calc 1/(dist2)
+	if (force > oneOverBaseScaleSquared)					// adjust if closer than radius
+		force = oneOverBaseScaleSquared;
+
+	force *= mass * oneOverDist;							// also normalizes the vector to the mass
+
+	pull->x += dx * force;
+	pull->y += dy * force;
+	pull->z += dz * force;
+}
+
+
+/****************** CALC GRAVITOID PULLS *********************/
+//
+// Fills gGravitoidPullX/Y/Z for every particle in the group.
+// Every particle has gravity pull on every other particle.
+//
+
+static void CalcGravitoidPulls(const ParticleGroupType* pg, float oneOverBaseScaleSquared)
+{
+	const int	numParticles = pg->numParticles;
+	const float	*px = pg->x;
+	const float	*py = pg->y;
+	const float	*pz = pg->z;
+	float		minX,minY,minZ,maxX,maxY,maxZ;
+
+	if (numParticles == 0)
+		return;
+
+				/* GET BOUNDS OF GROUP */
+
+	minX = minY = minZ = 1e9f;
+	maxX = maxY = maxZ = -minX;
+
+	for (int p = 0; p < numParticles; p++)
+	{
+		if (px[p] < minX) minX = px[p];
+		if (px[p] > maxX) maxX = px[p];
+		if (py[p] < minY) minY = py[p];
+		if (py[p] > maxY) maxY = py[p];
+		if (pz[p] < minZ) minZ = pz[p];
+		if (pz[p] > maxZ) maxZ = pz[p];
+	}
+
+				/* CHOOSE PYRAMID DEPTH */
+
+	int finestLevel = 0;
+	int gridSize = 1;
+	while (gridSize < MAX_GRAVITOID_GRID_SIZE
+		&& gridSize * gridSize * gridSize * GRAVITOID_PARTICLES_PER_CELL < numParticles)
+	{
+		gridSize *= 2;
+		finestLevel++;
+	}
+
+	float extent = maxX - minX;
+	if (maxY - minY > extent) extent = maxY - minY;
+	if (maxZ - minZ > extent) extent = maxZ - minZ;
+
+	const float cellSize = extent / gridSize + EPS;						// finest cells are cubes
+	const int numCells = gridSize * gridSize * gridSize;
+	const int finestOffset = GRAVITOID_LEVEL_OFFSET(finestLevel);
+
+				/* BIN PARTICLES INTO FINEST CELLS */
+
+	for (int c = 0; c <= numCells; c++)
+		gGravitoidCellStart[c] = 0;
+
+	for (int p = 0; p < numParticles; p++)
+	{
+		int cx = (int) ((px[p] - minX) / cellSize);
+		int cy = (int) ((py[p] - minY) / cellSize);
+		int cz = (int) ((pz[p] - minZ) / cellSize);
+		if (cx >= gridSize) cx = gridSize - 1;
+		if (cy >= gridSize) cy = gridSize - 1;
+		if (cz >= gridSize) cz = gridSize - 1;
+
+		int cell = (cz * gridSize + cy) * gridSize + cx;
+		gGravitoidCellOf[p] = cell;
+		gGravitoidCellStart[cell + 1]++;
+	}
+
+	for (int c = 0; c < numCells; c++)
+		gGravitoidCellStart[c + 1] += gGravitoidCellStart[c];			// turn counts into offsets
+
+	for (int p = 0; p < numParticles; p++)
+	{
+		int cell = gGravitoidCellOf[p];
+		int slot = gGravitoidCellStart[cell]++;
+		gGravitoidSortedParticles[slot] = p;
+	}
+
+	for (int c = numCells; c > 0; c--)									// undo the increments from the pass above
+		gGravitoidCellStart[c] = gGravitoidCellStart[c - 1];
+	gGravitoidCellStart[0] = 0;
+
+				/* SUM MASS & POSITIONS OF FINEST CELLS */
+
+	for (int c = 0; c < numCells; c++)
+	{
+		float x = 0, y = 0, z = 0;
+
+		for (int s = gGravitoidCellStart[c]; s < gGravitoidCellStart[c + 1]; s++)
+		{
+			int q = gGravitoidSortedParticles[s];
+			x += px[q];
+			y += py[q];
+			z += pz[q];
+		}
+
+		gGravitoidCellMass[finestOffset + c] = (float) (gGravitoidCellStart[c + 1] - gGravitoidCellStart[c]);
+		gGravitoidCellCenterOfGravity[finestOffset + c] = (TQ3Point3D) { x, y, z };
+	}
+
+				/* SUM EACH COARSER LEVEL FROM THE 8 CHILDREN BELOW IT */
+
+	for (int level = finestLevel - 1; level >= 0; level--)
+	{
+		const int size = 1 << level;
+		const int offset = GRAVITOID_LEVEL_OFFSET(level);
+		const int childOffset = GRAVITOID_LEVEL_OFFSET(level + 1);
+
+		for (int cz = 0; cz < size; cz++)
+		for (int cy = 0; cy < size; cy++)
+		for (int cx = 0; cx < size; cx++)
+		{
+			float mass = 0, x = 0, y = 0, z = 0;
+
+			for (int i = 0; i < 8; i++)
+			{
+				int child = childOffset
+						+ (((cz*2 + (i>>2)) * size*2) + (cy*2 + ((i>>1)&1))) * size*2
+						+ (cx*2 + (i&1));
+				mass += gGravitoidCellMass[child];
+				x += gGravitoidCellCenterOfGravity[child].x;
+				y += gGravitoidCellCenterOfGravity[child].y;
+				z += gGravitoidCellCenterOfGravity[child].z;
+			}
+
+			int cell = offset + (cz * size + cy) * size + cx;
+			gGravitoidCellMass[cell] = mass;
+			gGravitoidCellCenterOfGravity[cell] = (TQ3Point3D) { x, y, z };
+		}
+	}
+
+				/* TURN POSITION SUMS INTO CENTERS OF GRAVITY */
+
+	for (int cell = 0; cell < finestOffset + numCells; cell++)
+	{
+		float mass = gGravitoidCellMass[cell];
+		if (mass != 0.0f)
+		{
+			float oneOverMass = 1.0f / mass;
+			gGravitoidCellCenterOfGravity[cell].x *= oneOverMass;
+			gGravitoidCellCenterOfGravity[cell].y *= oneOverMass;
+			gGravitoidCellCenterOfGravity[cell].z *= oneOverMass;
+		}
+	}
+
+				/* ACCUMULATE PULLS ONE FINEST CELL AT A TIME */
+				//
+				// All particles in a cell share one walk of the pyramid, which sorts the other cells
+				// into far cells (pulling as one mass) and near cells (pulling particle by particle).
+				// Distances are measured from the edge of the cell's bounding sphere, so every particle
+				// in the cell sees the far cells at least as far away as the threshold requires.
+				//
+
+	const float accuracySquared = GRAVITOID_ACCURACY * GRAVITOID_ACCURACY;
+	const float cellRadius = cellSize * 0.8660254f;						// half diagonal of a finest cell
+
+	for (int ownCell = 0; ownCell < numCells; ownCell++)
+	{
+		const int firstParticle = gGravitoidCellStart[ownCell];
+		const int lastParticle = gGravitoidCellStart[ownCell + 1];
+
+		if (firstParticle == lastParticle)								// no particles to pull on
+			continue;
+
+		const int ownX = ownCell % gridSize;
+		const int ownY = (ownCell / gridSize) % gridSize;
+		const int ownZ = ownCell / (gridSize * gridSize);
+		const float centerX = minX + (ownX + .5f) * cellSize;
+		const float centerY = minY + (ownY + .5f) * cellSize;
+		const float centerZ = minZ + (ownZ + .5f) * cellSize;
+
+				/* WALK PYRAMID TO SORT OTHER CELLS INTO NEAR & FAR */
+
+		GravitoidCellRef stack[7 * MAX_GRAVITOID_LEVELS + 1];			// 7 siblings left behind per level
+		int stackSize = 0;
+		int numFarCells = 0;
+		int numNearCells = 0;
+
+		stack[stackSize++] = (GravitoidCellRef) { 0, 0, 0, 0 };		// start at the top cell (never empty)
+
+		while (stackSize > 0)
+		{
+			const GravitoidCellRef ref = stack[--stackSize];
+			const int level = ref.level;
+			const int size = 1 << level;
+			const int cell = GRAVITOID_LEVEL_OFFSET(level) + (ref.cz * size + ref.cy) * size + ref.cx;
+			const int shift = finestLevel - level;
+
+					/* SEE IF FAR ENOUGH TO TREAT CELL AS ONE MASS */
+
+			if ((ownX >> shift) != ref.cx || (ownY >> shift) != ref.cy || (ownZ >> shift) != ref.cz)
+			{
+				const TQ3Point3D* cog = &gGravitoidCellCenterOfGravity[cell];
+				float dx = cog->x - centerX;
+				float dy = cog->y - centerY;
+				float dz = cog->z - centerZ;
+				float dist = sqrtf(dx*dx + dy*dy + dz*dz) - cellRadius;
+				float levelCellSize = cellSize * (float) (1 << shift);
+
+				if (dist > 0.0f && levelCellSize * levelCellSize < accuracySquared * dist * dist)
+				{
+					gGravitoidFarCells[numFarCells++] = cell;
+					continue;
+				}
+			}
+
+					/* OTHERWISE OPEN IT */
+
+			if (level < finestLevel)
+			{
+				const int childSize = size * 2;
+				const int childOffset = GRAVITOID_LEVEL_OFFSET(level + 1);
+
+				for (int i = 0; i < 8; i++)
+				{
+					int cx = ref.cx*2 + (i&1);
+					int cy = ref.cy*2 + ((i>>1)&1);
+					int cz = ref.cz*2 + (i>>2);
+
+					if (gGravitoidCellMass[childOffset + (cz * childSize + cy) * childSize + cx] != 0.0f)		// skip empty cells
+						stack[stackSize++] = (GravitoidCellRef) { level + 1, cx, cy, cz };
+				}
+				continue;
+			}
+
+			gGravitoidNearCells[numNearCells++] = cell - finestOffset;	// finest cell that's too close
+		}
+
+				/* PULL EACH PARTICLE OF THE CELL */
+
+		for (int s = firstParticle; s < lastParticle; s++)
+		{
+			const int p = gGravitoidSortedParticles[s];
+			const float x = px[p];
+			const float y = py[p];
+			const float z = pz[p];
+			TQ3Vector3D pull = {0, 0, 0};
+
+			for (int i = 0; i < numFarCells; i++)
+			{
+				int cell = gGravitoidFarCells[i];
+				const TQ3Point3D* cog = &gGravitoidCellCenterOfGravity[cell];
+				AddGravitoidPull(x, y, z, cog->x, cog->y, cog->z, gGravitoidCellMass[cell], oneOverBaseScaleSquared, &pull);
+			}
+
+			for (int i = 0; i < numNearCells; i++)
+			{
+				int cell = gGravitoidNearCells[i];
+
+				for (int t = gGravitoidCellStart[cell]; t < gGravitoidCellStart[cell + 1]; t++)
+				{
+					int q = gGravitoidSortedParticles[t];
+					if (q == p)											// don't check against self
+						continue;
+
+					AddGravitoidPull(x, y, z, px[q], py[q], pz[q], 1.0f, oneOverBaseScaleSquared, &pull);
+				}
+			}
+
+			gGravitoidPullX[p] = pull.x;
+			gGravitoidPullY[p] = pull.y;
+			gGravitoidPullZ[p] = pull.z;
+		}
+	}
+}
+
+
+/****************** DELETE PARTICLE *********************/
+//
+// Keeps particles packed by moving the last particle into the hole.
+//
+
+static void DeleteParticle(ParticleGroupType* pg, int p)
+{
+	int last = --pg->numParticles;
+
+	pg->x[p] = pg->x[last];
+	pg->y[p] = pg->y[last];
+	pg->z[p] = pg->z[last];
+	pg->dx[p] = pg->dx[last];
+	pg->dy[p] = pg->dy[last];
+	pg->dz[p] = pg->dz[last];
+	pg->scale[p] = pg->scale[last];
+	pg->alpha[p] = pg->alpha[last];
+}
+
+
 /****************** MOVE PARTICLE GROUPS *********************/
 
 void MoveParticleGroups(void)
@@ -373,12 +1126,12 @@ Byte		flags;
 float		fps = gFramesPerSecondFrac;
 float		y,baseScale,oneOverBaseScaleSquared,gravity;
 float		decayRate,magnetism,fadeRate;
-TQ3Point3D	*coord;
-TQ3Vector3D	*delta;
 
 	if (!gParticleGroupsInitialized)
 		return;
 
+	int numLiveParticles = 0;
+
 	int g = Pool_First(gParticleGroupPool);
 	while (g >= 0)
 	{
@@ -388,6 +1141,17 @@ TQ3Vector3D	*delta;
 
 		int nextGroupIndex = Pool_Next(gParticleGroupPool, g);
 
+				/* SEE IF GROUP WAS EMPTY, THEN DELETE */
+
+		int n = pg->numParticles;
+		if (n == 0)
+		{
+			ReleaseParticleGroupStorage(pg);
+			Pool_ReleaseIndex(gParticleGroupPool, g);
+			g = nextGroupIndex;
+			continue;
+		}
+
 		baseScale 	= pg->baseScale;					// get base scale
 		oneOverBaseScaleSquared = 1.0f/(baseScale*baseScale);
 		gravity 	= pg->gravity;						// get gravity
@@ -396,100 +1160,63 @@ TQ3Vector3D	*delta;
 		magnetism 	= pg->magnetism;					// get magnetism
 		flags 		= pg->flags;
 
-		int n = 0;										// init counter
-		int p = Pool_First(pg->pool);
-		while (p >= 0)
-		{
-			GAME_ASSERT(Pool_IsUsed(pg->pool, p));
-			int nextParticleIndex = Pool_Next(pg->pool, p);
-
-			n++;										// inc counter
-			delta = &pg->delta[p];						// get ptr to deltas
-			coord = &pg->coord[p];						// get ptr to coords
-
-							/* ADD GRAVITY */
+		if (pg->type == PARTICLE_TYPE_GRAVITOIDS)
+			CalcGravitoidPulls(pg, oneOverBaseScaleSquared);
 
-			delta->y -= gravity * fps;									// add gravity
-
-			switch (pg->type)
+		{
+			float* restrict px = pg->x;
+			float* restrict py = pg->y;
+			float* restrict pz = pg->z;
+			float* restrict dx = pg->dx;
+			float* restrict dy = pg->dy;
+			float* restrict dz = pg->dz;
+			float* restrict scale = pg->scale;
+			float* restrict alpha = pg->alpha;
+
+					/* GRAVITOIDS */
+					//
+					// Every particle has gravity pull on other particle
+					//
+
+			if (pg->type == PARTICLE_TYPE_GRAVITOIDS)
 			{
-							/* FALLING SPARKS */
-
-				case	PARTICLE_TYPE_FALLINGSPARKS:
-						coord->x += delta->x * fps;						// move it
-						coord->y += delta->y * fps;
-						coord->z += delta->z * fps;
-						break;
-
-
-							/* GRAVITOIDS */
-							//
-							// Every particle has gravity pull on other particle
-							//
-
-				case	PARTICLE_TYPE_GRAVITOIDS:
-						for (int q = Pool_Last(pg->pool); q >= 0; q = Pool_Prev(pg->pool, q))
-						{
-							GAME_ASSERT(Pool_IsUsed(pg->pool, q));
-
-							float		dist;
-							float		x,z;
-							TQ3Vector3D	v;
-
-							if (p == q)									// don't check against self
-								continue;
-
-							x = pg->coord[q].x;
-							y = pg->coord[q].y;
-							z = pg->coord[q].z;
-
-									/* calc 1/(dist2) */
+				const float pullFactor = magnetism * fps;
+				for (int p = 0; p < n; p++)
+				{
+					dx[p] += gGravitoidPullX[p] * pullFactor;		// apply gravity to particle
+					dy[p] += gGravitoidPullY[p] * pullFactor;
+					dz[p] += gGravitoidPullZ[p] * pullFactor;
+				}
+			}
 
-							if (p < q)									// see if calc or get from buffer
-							{
-								float dx = coord->x - x;
-								float dy = coord->y - y;
-								float dz = coord->z - z;
-								dist = sqrtf(dx*dx + dy*dy + dz*dz);
-								if (dist != 0.0f)
-									dist = 1.0f / (dist*dist);
+					/* ADD GRAVITY, MOVE, SHRINK & FADE */
 
-								if (dist > oneOverBaseScaleSquared)		// adjust if closer than radius
-									dist = oneOverBaseScaleSquared;
+			const float gravityStep = gravity * fps;
+			const float decayStep = decayRate * fps;
+			const float fadeStep = fadeRate * fps;
 
-								gGravitoidDistBuffer[p][q] = dist;		// remember it
-							}
-							else
-							{
-								dist = gGravitoidDistBuffer[q][p];		// use from buffer
-							}
-
-										/* calc vector to particle */
-
-							if (dist != 0.0f)
-							{
-								x = x - coord->x;
-								y = y - coord->y;
-								z = z - coord->z;
-								FastNormalizeVector(x, y, z, &v);
-							}
-							else
-							{
-								v.x = v.y = v.z = 0;
-							}
+			for (int p = 0; p < n; p++)
+			{
+				dy[p] -= gravityStep;								// add gravity
 
-							delta->x += v.x * (dist * magnetism * fps);		// apply gravity to particle
-							delta->y += v.y * (dist * magnetism * fps);
-							delta->z += v.z * (dist * magnetism * fps);
-						}
+				px[p] += dx[p] * fps;								// move it
+				py[p] += dy[p] * fps;
+				pz[p] += dz[p] * fps;
 
-						coord->x += delta->x * fps;						// move it
-						coord->y += delta->y * fps;
-						coord->z += delta->z * fps;
-						break;
+				scale[p] -= decayStep;								// shrink it
+				alpha[p] -= fadeStep;								// fade it
 			}
+		}
 
+					/* COLLISIONS & DELETION */
+					//
+					// Walk backwards so that deleting a particle doesn't skip the one
+					// moved into its slot. The group's arrays are re-read from pg because
+					// hurting the player may spawn particles and grow this group.
+					//
 
+		for (int p = n - 1; p >= 0; p--)
+		{
 			if (gFloorMap)					// only do these checks if there's a terrain floor
 			{
 					/*****************/
@@ -498,16 +1225,16 @@ TQ3Vector3D	*delta;
 
 				if (flags & PARTICLE_FLAGS_BOUNCE)
 				{
-					if (delta->y < 0.0f)							// if moving down, see if hit floor
+					if (pg->dy[p] < 0.0f)							// if moving down, see if hit floor
 					{
-						y = GetTerrainHeightAtCoord(coord->x, coord->z, FLOOR)+10.0f;	// see if hit floor
-						if (coord->y < y)
+						y = GetTerrainHeightAtCoord(pg->x[p], pg->z[p], FLOOR)+10.0f;	// see if hit floor
+						if (pg->y[p] < y)
 						{
-							coord->y = y;
-							delta->y *= -.4f;
+							pg->y[p] = y;
+							pg->dy[p] *= -.4f;
 
-							delta->x += gRecentTerrainNormal[FLOOR].x * 300.0f;	// reflect off of surface
-							delta->z += gRecentTerrainNormal[FLOOR].z * 300.0f;
+							pg->dx[p] += gRecentTerrainNormal[FLOOR].x * 300.0f;	// reflect off of surface
+							pg->dz[p] += gRecentTerrainNormal[FLOOR].z * 300.0f;
 						}
 					}
 				}
@@ -519,9 +1246,13 @@ TQ3Vector3D	*delta;
 
 				if (flags & PARTICLE_FLAGS_HURTPLAYER)
 				{
-					if (DoSimpleBoxCollisionAgainstPlayer(coord->y+30.0f,coord->y-30.0f,
-														coord->x-30.0f, coord->x+30.0f,
-														coord->z+30.0f, coord->z-30.0f))
+					float x = pg->x[p];
+					float z = pg->z[p];
+					y = pg->y[p];
+
+					if (DoSimpleBoxCollisionAgainstPlayer(y+30.0f, y-30.0f,
+														x-30.0f, x+30.0f,
+														z+30.0f, z-30.0f))
 					{
 						if (flags & PARTICLE_FLAGS_HURTPLAYERBAD)					// hurt really bad!
 						{
@@ -546,14 +1277,14 @@ TQ3Vector3D	*delta;
 
 				if (flags & PARTICLE_FLAGS_ROOF)
 				{
-					if (delta->y > 0.0f)							// if moving up, see if hit ceiling
+					if (pg->dy[p] > 0.0f)							// if moving up, see if hit ceiling
 					{
-						y = GetTerrainHeightAtCoord(coord->x, coord->z, CEILING)-10.0f;	// see if hit ceiling
-						if (coord->y > y)
+						y = GetTerrainHeightAtCoord(pg->x[p], pg->z[p], CEILING)-10.0f;	// see if hit ceiling
+						if (pg->y[p] > y)
 						{
-							coord->y = y;
-							delta->x += gRecentTerrainNormal[FLOOR].x * 1000.0f;	// reflect off of surface
-							delta->z += gRecentTerrainNormal[FLOOR].z * 1000.0f;
+							pg->y[p] = y;
+							pg->dx[p] += gRecentTerrainNormal[FLOOR].x * 1000.0f;	// reflect off of surface
+							pg->dz[p] += gRecentTerrainNormal[FLOOR].z * 1000.0f;
 						}
 					}
 				}
@@ -563,146 +1294,275 @@ TQ3Vector3D	*delta;
 				/* SEE IF GONE */
 				/***************/
 
-					/* DO SCALE */
+			if (pg->scale[p] <= 0.0f || pg->alpha[p] <= 0.0f)
+				DeleteParticle(pg, p);
+		}
 
-			pg->scale[p] -= decayRate * fps;			// shrink it
-			if (pg->scale[p] <= 0.0f)					// see if gone
-				goto deleteParticle;
+		numLiveParticles += pg->numParticles;
 
-					/* DO FADE */
+		g = nextGroupIndex;
+	}
 
-			pg->alpha[p] -= fadeRate * fps;				// fade it
-			if (pg->alpha[p] <= 0.0f)					// see if gone
-				goto deleteParticle;
+	gNumLiveParticles = numLiveParticles;
+}
 
 
-			goto nextParticle;
+/**************** EXPAND PARTICLE QUADS *********************/
+//
+// Writes 4 vertices per visible particle into the group's trimesh,
+// along with their vertex colors and the mesh's bounding box.
+//
+// rightX/rightZ is the quad's horizontal axis; the vertical axis is always world up.
+//
 
-					/* IF GONE RELEASE INDEX */
+static void ExpandParticleQuads(int n, float rightX, float rightZ, TQ3TriMeshData* tm)
+{
+			/* AXIS WEIGHTS FOR THE 12 FLOATS (4 VERTICES * XYZ) OF A QUAD */
 
-deleteParticle:
-			Pool_ReleaseIndex(pg->pool, p);
+	const Vec4f axisA = Vec4f_Set( rightX,	1,			 rightZ,	 rightX);	// v0.xyz, v1.x
+	const Vec4f axisB = Vec4f_Set(-1,		rightZ,		-rightX,	-1);		// v1.yz, v2.xy
+	const Vec4f axisC = Vec4f_Set(-rightZ,	-rightX,	1,			-rightZ);	// v2.z, v3.xyz
+	const Vec4f extentAxis = Vec4f_Set(fabsf(rightX), 1, fabsf(rightZ), 0);
 
+	Vec4f bboxMin = Vec4f_Set1(1e9f);
+	Vec4f bboxMax = Vec4f_Set1(-1e9f);
 
-nextParticle:
-			p = nextParticleIndex;
-		}
+	float* outPoints = &tm->points[0].x;
+	float* outColors = &tm->vertexColors[0].r;
 
+	for (int i = 0; i < n; i++)
+	{
+		const float x = gVisibleParticleX[i];
+		const float y = gVisibleParticleY[i];
+		const float z = gVisibleParticleZ[i];
+		const Vec4f size = Vec4f_Set1(gVisibleParticleSize[i]);
 
-				/* SEE IF GROUP WAS EMPTY, THEN DELETE */
+					/* POSITIONS */
 
-		if (n == 0)
-		{
-			Pool_ReleaseIndex(gParticleGroupPool, g);
-		}
+		Vec4f_Store(outPoints + 0, Vec4f_MulAdd(size, axisA, Vec4f_Set(x, y, z, x)));
+		Vec4f_Store(outPoints + 4, Vec4f_MulAdd(size, axisB, Vec4f_Set(y, z, x, y)));
+		Vec4f_Store(outPoints + 8, Vec4f_MulAdd(size, axisC, Vec4f_Set(z, x, y, z)));
+		outPoints += 12;
 
+					/* FACE TRANSPARENCY */
 
-		g = nextGroupIndex;
+		const Vec4f color = Vec4f_Set(1, 1, 1, gVisibleParticleAlpha[i]);
+		Vec4f_Store(outColors + 0, color);
+		Vec4f_Store(outColors + 4, color);
+		Vec4f_Store(outColors + 8, color);
+		Vec4f_Store(outColors + 12, color);
+		outColors += 16;
+
+					/* BBOX */
+
+		const Vec4f center = Vec4f_Set(x, y, z, 0);
+		const Vec4f extent = Vec4f_Mul(size, extentAxis);
+		bboxMin = Vec4f_Min(bboxMin, Vec4f_Sub(center, extent));
+		bboxMax = Vec4f_Max(bboxMax, Vec4f_Add(center, extent));
 	}
+
+	float minXYZ[4];
+	float maxXYZ[4];
+	Vec4f_Store(minXYZ, bboxMin);
+	Vec4f_Store(maxXYZ, bboxMax);
+
+	tm->numTriangles = n * 2;
+	tm->numPoints = n * 4;
+	tm->bBox.min = (TQ3Point3D) { minXYZ[0], minXYZ[1], minXYZ[2] };
+	tm->bBox.max = (TQ3Point3D) { maxXYZ[0], maxXYZ[1], maxXYZ[2] };
 }
 
 
-/**************** DRAW PARTICLE GROUPS *********************/
+/**************** BUILD PARTICLE SPRITES *********************/
+//
+// Point sprite alternative to ExpandParticleQuads: one vertex per particle.
+// Fixed-function GL can only size sprites per draw call, so every particle in
+// the group is drawn at the group's average size.
+//
+// Returns the sprite diameter in pixels.
+//
 
-void DrawParticleGroup(const QD3DSetupOutputType *setupInfo)
+static float BuildParticleSprites(int n, const QD3DSetupOutputType* setupInfo, TQ3TriMeshData* tm)
 {
-float			baseScale;
-TQ3TriMeshData	*tm;
-TQ3Point3D		v[4],*coord;
-TQ3Matrix4x4	m;
-static const TQ3Vector3D up = {0,1,0};
+	float minX,minY,minZ,maxX,maxY,maxZ;
+	float totalSize = 0;
+
+	minX = minY = minZ = 1e9f;
+	maxX = maxY = maxZ = -minX;
 
+	for (int i = 0; i < n; i++)
+	{
+		const float x = gVisibleParticleX[i];
+		const float y = gVisibleParticleY[i];
+		const float z = gVisibleParticleZ[i];
 
-	(void) setupInfo;
+		tm->points[i] = (TQ3Point3D) { x, y, z };
+		tm->vertexColors[i] = (TQ3ColorRGBA) { 1, 1, 1, gVisibleParticleAlpha[i] };
 
-	if (!gParticleGroupsInitialized)
-		return;
+		if (x < minX) minX = x;
+		if (x > maxX) maxX = x;
+		if (y < minY) minY = y;
+		if (y > maxY) maxY = y;
+		if (z < minZ) minZ = z;
+		if (z > maxZ) maxZ = z;
 
-	const TQ3Point3D* camCoords = &gGameViewInfoPtr->currentCameraCoords;
+		totalSize += gVisibleParticleSize[i];
+	}
 
-	for (int g = Pool_First(gParticleGroupPool); g >= 0; g = Pool_Next(gParticleGroupPool, g))
-	{
-		GAME_ASSERT(Pool_IsUsed(gParticleGroupPool, g));
+	tm->numTriangles = 0;
+	tm->numPoints = n;
+	tm->bBox.min = (TQ3Point3D) { minX, minY, minZ };
+	tm->bBox.max = (TQ3Point3D) { maxX, maxY, maxZ };
 
-		float	minX,minY,minZ,maxX,maxY,maxZ;
+			/* PROJECT AVERAGE QUAD SIZE AT GROUP CENTER ONTO SCREEN */
 
-		ParticleGroupType* pg = &gParticleGroups[g];
+	const TQ3Point3D* camCoords = &setupInfo->currentCameraCoords;
+	const TQ3Point3D* camLookAt = &setupInfo->currentCameraLookAt;
+	TQ3Vector3D forward;
+	FastNormalizeVector(camLookAt->x - camCoords->x, camLookAt->y - camCoords->y, camLookAt->z - camCoords->z, &forward);
 
-		tm = pg->mesh;									// get pointer to trimesh data
-		baseScale = pg->baseScale;						// get base scale
+	float depth = (0.5f * (minX + maxX) - camCoords->x) * forward.x
+				+ (0.5f * (minY + maxY) - camCoords->y) * forward.y
+				+ (0.5f * (minZ + maxZ) - camCoords->z) * forward.z;
+	if (depth < setupInfo->hither)
+		depth = setupInfo->hither;
 
-					/********************************/
-					/* ADD ALL PARTICLES TO TRIMESH */
-					/********************************/
+	float quadHeight = 2.0f * totalSize / (float) n;
+	float f = 1.0f / tanf(setupInfo->fov * 0.5f);
 
-		minX = minY = minZ = 1e9f;						// init bbox
-		maxX = maxY = maxZ = -minX;
+	return quadHeight * f * 0.5f * (float) gWindowHeight / depth;
+}
 
-		int numParticlesDrawn = 0;
-		for (int p = Pool_First(pg->pool); p >= 0; p = Pool_Next(pg->pool, p))
-		{
-			GAME_ASSERT(Pool_IsUsed(pg->pool, p));
 
-					/* TRANSFORM PARTICLE POSITION */
+/**************** DRAW PARTICLE GROUPS *********************/
+//
+// Particles are camera-facing quads that stay upright.
+// The quads' horizontal axis is derived once per frame from the camera's
+// forward vector, instead of building a look-at matrix for every particle.
+//
 
-			coord = &pg->coord[p];
-			SetLookAtMatrixAndTranslate(&m, &up, coord, camCoords);
+void DrawParticleGroup(const QD3DSetupOutputType *setupInfo)
+{
+	if (!gParticleGroupsInitialized)
+		return;
 
-					/* CULL PARTICLE TO AVOID OVERDRAW (SOURCE PORT ADD) */
+	if (!setupInfo)
+		setupInfo = gGameViewInfoPtr;
 
-			if (!IsSphereInFrustum_XYZ(coord, pg->baseScale))
-				continue;
+	uint64_t startTime = GetProfilingTimestamp();
 
-					/* TRANSFORM PARTICLE VERTICES & ADD TO TRIMESH */
+			/* CALC BILLBOARD AXIS FOR THIS FRAME */
+			//
+			// This is the X axis that SetLookAtMatrix would build from a
+			// world-space up vector of (0,1,0) and the camera's line of sight.
+			//
 
-			const float S = baseScale * pg->scale[p];
-			v[0] = (TQ3Point3D) {  S, S, 0 };
-			v[1] = (TQ3Point3D) {  S,-S, 0 };
-			v[2] = (TQ3Point3D) { -S,-S, 0 };
-			v[3] = (TQ3Point3D) { -S, S, 0 };
+	const TQ3Point3D* camCoords = &setupInfo->currentCameraCoords;
+	const TQ3Point3D* camLookAt = &setupInfo->currentCameraLookAt;
+	TQ3Vector3D lookAt;
+	FastNormalizeVector(camLookAt->x - camCoords->x, camLookAt->y - camCoords->y, camLookAt->z - camCoords->z, &lookAt);
 
-			Q3Point3D_To3DTransformArray(&v[0], &m, &tm->points[numParticlesDrawn * 4], 4);
+	const float rightX = lookAt.z;
+	const float rightZ = -lookAt.x;
 
-					/* UPDATE BBOX */
+	for (int g = Pool_First(gParticleGroupPool); g >= 0; g = Pool_Next(gParticleGroupPool, g))
+	{
+		GAME_ASSERT(Pool_IsUsed(gParticleGroupPool, g));
 
-			for (int i = 0; i < 4; i++)
-			{
-				const TQ3Point3D* pt = &tm->points[numParticlesDrawn * 4 + i];
-				if (pt->x < minX) minX = pt->x;
-				if (pt->x > maxX) maxX = pt->x;
-				if (pt->y < minY) minY = pt->y;
-				if (pt->y > maxY) maxY = pt->y;
-				if (pt->z < minZ) minZ = pt->z;
-				if (pt->z > maxZ) maxZ = pt->z;
-			}
+		ParticleGroupType* pg = &gParticleGroups[g];
+		TQ3TriMeshData* tm = pg->mesh;
+		const float baseScale = pg->baseScale;
 
-					/* UPDATE FACE TRANSPARENCY */
+					/* GATHER VISIBLE PARTICLES */
 
-			tm->vertexColors[numParticlesDrawn * 4 + 0].a = pg->alpha[p];
-			tm->vertexColors[numParticlesDrawn * 4 + 1].a = pg->alpha[p];
-			tm->vertexColors[numParticlesDrawn * 4 + 2].a = pg->alpha[p];
-			tm->vertexColors[numParticlesDrawn * 4 + 3].a = pg->alpha[p];
+		int n = 0;
+		for (int p = 0; p < pg->numParticles; p++)
+		{
+			TQ3Point3D coord = { pg->x[p], pg->y[p], pg->z[p] };
 
-			numParticlesDrawn++;										// inc particle count
+					/* CULL PARTICLE TO AVOID OVERDRAW (SOURCE PORT ADD) */
+
+			if (!IsSphereInFrustum_XYZ(&coord, baseScale))
+				continue;
+
+			gVisibleParticleX[n] = coord.x;
+			gVisibleParticleY[n] = coord.y;
+			gVisibleParticleZ[n] = coord.z;
+			gVisibleParticleSize[n] = baseScale * pg->scale[p];
+			gVisibleParticleAlpha[n] = pg->alpha[p];
+			n++;
 		}
 
-		if (numParticlesDrawn == 0)										// if no particles, then skip
+		if (n == 0)										// if no particles, then skip
 			continue;
 
-				/* UPDATE FINAL VALUES */
+					/* BUILD GEOMETRY & DRAW IT */
 
-		tm->numTriangles = numParticlesDrawn * 2;
-		tm->numPoints = numParticlesDrawn * 4;
-		tm->bBox.min.x = minX;
-		tm->bBox.min.y = minY;
-		tm->bBox.min.z = minZ;
-		tm->bBox.max.x = maxX;
-		tm->bBox.max.y = maxY;
-		tm->bBox.max.z = maxZ;
+		if (gCommandLine.pointSpriteParticles)
+		{
+			RenderModifiers* mods = &gParticleSpriteRenderingMods[g];
+			*mods = kParticleGroupRenderingMods;
+			mods->pointSize = BuildParticleSprites(n, setupInfo, tm);
+			Render_SubmitMesh(tm, nil, mods, nil);
+		}
+		else
+		{
+			ExpandParticleQuads(n, rightX, rightZ, tm);
+			Render_SubmitMesh(tm, nil, &kParticleGroupRenderingMods, nil);
+		}
+	}
+
+	gParticleDrawMilliseconds = GetMillisecondsSince(startTime);
+}
 
-					/* DRAW IT */
 
-		Render_SubmitMesh(tm, nil, &kParticleGroupRenderingMods, nil);
+/**************** STRESS TEST PARTICLE GROUPS *********************/
+//
+// Debug aid: fills every free particle group around the given point.
+// Use with --stats to see how long the particle geometry takes to build.
+//
+
+void StressTestParticleGroups(const TQ3Point3D* where)
+{
+	static const Byte textures[] =
+	{
+		PARTICLE_TEXTURE_FIRE, PARTICLE_TEXTURE_WHITE, PARTICLE_TEXTURE_PATCHY, PARTICLE_TEXTURE_ORANGESPOT,
+	};
+
+	for (int i = 0; ; i++)
+	{
+		int32_t pg = NewParticleGroup(
+								PARTICLE_TYPE_FALLINGSPARKS,	// type
+								0,								// flags
+								0,								// gravity
+								0,								// magnetism
+								20,								// base scale
+								0,								// decay rate
+								.2,								// fade rate
+								textures[i % 4]);				// texture
+
+		if (pg == -1)											// all groups in use
+			break;
+
+		for (int p = 0; p < MAX_PARTICLES / 4; p++)
+		{
+			TQ3Point3D pt =
+			{
+				where->x + (RandomFloat()-.5f) * 1000.0f,
+				where->y + RandomFloat() * 500.0f,
+				where->z + (RandomFloat()-.5f) * 1000.0f,
+			};
+
+			TQ3Vector3D delta =
+			{
+				(RandomFloat()-.5f) * 100.0f,
+				(RandomFloat()-.5f) * 100.0f,
+				(RandomFloat()-.5f) * 100.0f,
+			};
+
+			if (AddParticleToGroup(pg, &pt, &delta, RandomFloat() + 1.0f, FULL_ALPHA))
+				break;
+		}
 	}
 }
 
@@ -753,17 +1613,17 @@ bool ParticleHitObject(ObjNode *theNode, uint8_t inFlags)
 		if (inFlags && !(inFlags & pg->flags))				// see if check flags
 			continue;
 
-		for (int p = Pool_First(pg->pool); p >= 0; p = Pool_Next(pg->pool, p))
+		for (int p = 0; p < pg->numParticles; p++)
 		{
-			GAME_ASSERT(Pool_IsUsed(pg->pool, p));
-
 			if (pg->alpha[p] < .4f)							// if particle is too decayed, then skip
 				continue;
 
-			const TQ3Point3D* coord = &pg->coord[p];		// get ptr to coords
-			if (DoSimpleBoxCollisionAgainstObject(coord->y+40.0f,coord->y-40.0f,
-												coord->x-40.0f, coord->x+40.0f,
-												coord->z+40.0f, coord->z-40.0f,
+			float x = pg->x[p];
+			float y = pg->y[p];
+			float z = pg->z[p];
+			if (DoSimpleBoxCollisionAgainstObject(y+40.0f, y-40.0f,
+												x-40.0f, x+40.0f,
+												z+40.0f, z-40.0f,
 												theNode))
 			{
 				return(true);
@@ -186,6 +186,8 @@ float	s;
 							-200.0f*s,200.0f*s,
 							200.0f*s,-200.0f*s);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -247,6 +249,8 @@ ObjNode	*newObj;
 								-500*GRASS_SCALE,500*GRASS_SCALE,
 								500*GRASS_SCALE,-500*GRASS_SCALE);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -282,6 +286,8 @@ ObjNode	*newObj;
 								-570*WEED_SCALE,570*WEED_SCALE,
 								570*WEED_SCALE,-570*WEED_SCALE);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -314,6 +320,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,600,0,-40,40,40,-40);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -349,6 +357,8 @@ ObjNode	*newObj;
 	SetObjectCollisionBounds(newObj,700*COSMO_SCALE,0,
 							-160*COSMO_SCALE,160*COSMO_SCALE,
 							160*COSMO_SCALE,-160*COSMO_SCALE);
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -380,6 +390,8 @@ ObjNode	*newObj;
 	SetObjectCollisionBounds(newObj,1900*POPPY_SCALE,0,
 							-300*POPPY_SCALE,300*POPPY_SCALE,
 							300*POPPY_SCALE,-300*POPPY_SCALE);
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -421,6 +433,8 @@ ObjNode	*newObj;
 	else
 		SetObjectCollisionBounds(newObj,500,0,-170,170,170,-170);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -533,6 +547,8 @@ CollisionBoxType *boxPtr;
 	boxPtr[6].front 	= z + (283*TREE_SCALE);
 
 	KeepOldCollisionBoxes(newObj);							// set old stuff
+
+	AddToSceneryBatch(newObj);								// never moves, so draw it with its supertile
 	
 	return(true);											// item was added
 }
@@ -836,6 +852,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,300,0,-20,20,20,-20);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -871,6 +889,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,1000,0,-20,20,20,-20);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -905,6 +925,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,100,-100,-150,150,150,-150);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -941,6 +963,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,15,-900,-400,400,400,-400);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -978,6 +1002,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,1000,0,-20,20,20,-20);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -1019,6 +1045,8 @@ ObjNode	*newObj;
 	else
 		SetObjectCollisionBounds(newObj,1000,0,-90,90,90,-90);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
@@ -1259,6 +1287,8 @@ ObjNode	*newObj;
 	newObj->CBits = CBITS_ALLSOLID;
 	SetObjectCollisionBounds(newObj,5000,-300,-550,550,550,-550);
 
+	AddToSceneryBatch(newObj);										// never moves, so draw it with its supertile
+
 	return(true);													// item was added
 }
 
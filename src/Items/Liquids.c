@@ -18,6 +18,7 @@
 
 static void DrawWaterPatch(ObjNode *theNode);
 static void DrawWaterPatchTesselated(ObjNode *theNode);
+static void BuildWaterPatchMeshTesselated(ObjNode *theNode);
 static void UpdateWaterTextureAnimation(void);
 static void UpdateHoneyTextureAnimation(void);
 static void UpdateSlimeTextureAnimation(void);
@@ -26,7 +27,11 @@ static void UpdateLavaTextureAnimation(void);
 static Boolean AddLiquidPatch(TerrainItemEntryType *itemPtr, long x, long z, int kind);
 static void MoveLiquidPatch(ObjNode *theNode);
 static void DrawSolidLiquidPatchTesselated(ObjNode *theNode);
+static void BuildSolidLiquidPatchMesh(ObjNode *theNode);
 static void ApplyJitterToLiquidVertex(TQ3Point3D* p, int type);
+static void RegisterLiquidPatch(ObjNode *theNode);
+static void UnregisterLiquidPatch(ObjNode *theNode);
+static ObjNode* FindLiquidPatchAtCoord(float x, float z);
 
 
 /****************************/
@@ -78,6 +83,7 @@ const float gLiquidCollisionTopOffset[NUM_LIQUID_TYPES] =
 #define PatchMeshID		SpecialL[3]
 #define	TesselatePatch	Flag[0]
 #define	PatchHasRisen	Flag[1]				// true when water has flooded up
+#define	PatchMeshY		SpecialF[0]			// y that the patch's mesh was built at
 
 
 static TQ3TriMeshData	*gLiquidMeshPtrs[MAX_LIQUID_MESHES];
@@ -88,6 +94,19 @@ static GLuint			gLiquidShaders[NUM_LIQUID_TYPES];
 static TQ3Param2D		gLiquidUVOffsets[NUM_LIQUID_TYPES];
 static TQ3Param2D		gWaterUVOffset2;		// extra uv offsets for second plane of non-tesselated water
 
+			/* PATCH GRID */
+			//
+			// Every live patch owns a liquid mesh, so the mesh ID doubles as a slot number.
+			// Each supertile keeps a mask of the slots whose collision box overlaps it.
+			//
+
+_Static_assert(MAX_LIQUID_MESHES <= 32, "patch masks below are 32-bit");
+
+static ObjNode			*gLiquidPatchNodes[MAX_LIQUID_MESHES];
+static uint32_t			gLiquidPatchSerials[MAX_LIQUID_MESHES];		// creation order, i.e. order in the ObjNode list
+static uint32_t			gNextLiquidPatchSerial = 0;
+static uint32_t			gLiquidPatchCellMasks[MAX_SUPERTILES_DEEP][MAX_SUPERTILES_WIDE];
+
 /****************** HELPER: DELETE TEXTURE **********************/
 
 static void DeleteTexture(GLuint* textureName)
@@ -137,6 +156,10 @@ void InitLiquids(void)
 {
 	gNumActiveLiquidMeshes = 0;
 
+	memset(gLiquidPatchNodes, 0, sizeof(gLiquidPatchNodes));
+	memset(gLiquidPatchCellMasks, 0, sizeof(gLiquidPatchCellMasks));
+	gNextLiquidPatchSerial = 0;
+
 	// Initialize trimeshes
 	for (int i = 0; i < MAX_LIQUID_MESHES; i++)
 	{
@@ -198,6 +221,9 @@ void DisposeLiquids(void)
 	}
 
 	gNumActiveLiquidMeshes = 0;
+
+	memset(gLiquidPatchNodes, 0, sizeof(gLiquidPatchNodes));		// the patches' ObjNodes are gone by now
+	memset(gLiquidPatchCellMasks, 0, sizeof(gLiquidPatchCellMasks));
 }
 
 /*************** UPDATE LIQUID ANIMATION ****************/
@@ -213,40 +239,143 @@ void UpdateLiquidAnimation(void)
 
 
 
-/***************** FIND LIQUID Y **********************/
+/***************** CLAMP LIQUID PATCH CELL **********************/
 
-Boolean FindLiquidY(float x, float z, float* y)
+static inline int ClampLiquidPatchCell(int cell, long numCells)
 {
-	ObjNode* thisNodePtr = gFirstNodePtr;
-	do
+	if (cell < 0)
+		return 0;
+	if (cell >= numCells)
+		return (int) numCells - 1;
+	return cell;
+}
+
+
+/***************** GET LIQUID PATCH CELL RANGE **********************/
+//
+// Converts a world-space x/z span to a range of supertiles, clamped to the map
+// so that patches hanging off the edge are still found.
+//
+
+static void GetLiquidPatchCellRange(float minX, float maxX, float minZ, float maxZ,
+									int* col0, int* col1, int* row0, int* row1)
+{
+	*col0 = (int) floorf(minX * (1.0f / TERRAIN_SUPERTILE_UNIT_SIZE));
+	*col1 = (int) floorf(maxX * (1.0f / TERRAIN_SUPERTILE_UNIT_SIZE));
+	*row0 = (int) floorf(minZ * (1.0f / TERRAIN_SUPERTILE_UNIT_SIZE));
+	*row1 = (int) floorf(maxZ * (1.0f / TERRAIN_SUPERTILE_UNIT_SIZE));
+
+	*col0 = ClampLiquidPatchCell(*col0, gNumSuperTilesWide);
+	*col1 = ClampLiquidPatchCell(*col1, gNumSuperTilesWide);
+	*row0 = ClampLiquidPatchCell(*row0, gNumSuperTilesDeep);
+	*row1 = ClampLiquidPatchCell(*row1, gNumSuperTilesDeep);
+}
+
+
+/***************** REGISTER LIQUID PATCH **********************/
+//
+// Patches never move sideways (rising water only changes y), so the cells they cover
+// are set once here.
+//
+
+static void RegisterLiquidPatch(ObjNode *theNode)
+{
+int		slot = theNode->PatchMeshID;
+int		col0,col1,row0,row1;
+
+	GAME_ASSERT(slot >= 0 && slot < MAX_LIQUID_MESHES);
+	GAME_ASSERT(gLiquidPatchNodes[slot] == nil);
+	GAME_ASSERT(theNode->CollisionBoxes);
+
+	gLiquidPatchNodes[slot] = theNode;
+	gLiquidPatchSerials[slot] = gNextLiquidPatchSerial++;
+
+	const CollisionBoxType* box = &theNode->CollisionBoxes[0];
+	GetLiquidPatchCellRange(box->left, box->right, box->back, box->front, &col0, &col1, &row0, &row1);
+
+	for (int row = row0; row <= row1; row++)
+		for (int col = col0; col <= col1; col++)
+			gLiquidPatchCellMasks[row][col] |= 1u << slot;
+}
+
+
+/***************** UNREGISTER LIQUID PATCH **********************/
+
+static void UnregisterLiquidPatch(ObjNode *theNode)
+{
+int		slot = theNode->PatchMeshID;
+int		col0,col1,row0,row1;
+
+	GAME_ASSERT(slot >= 0 && slot < MAX_LIQUID_MESHES);
+	GAME_ASSERT(gLiquidPatchNodes[slot] == theNode);
+
+	const CollisionBoxType* box = &theNode->CollisionBoxes[0];
+	GetLiquidPatchCellRange(box->left, box->right, box->back, box->front, &col0, &col1, &row0, &row1);
+
+	for (int row = row0; row <= row1; row++)
+		for (int col = col0; col <= col1; col++)
+			gLiquidPatchCellMasks[row][col] &= ~(1u << slot);
+
+	gLiquidPatchNodes[slot] = nil;
+}
+
+
+/***************** FIND LIQUID PATCH AT COORD **********************/
+//
+// If several patches overlap the point, returns the one that's earliest in the
+// ObjNode list (they all live in the same slot, so that's the oldest one).
+//
+
+static ObjNode* FindLiquidPatchAtCoord(float x, float z)
+{
+ObjNode		*found = nil;
+uint32_t	foundSerial = 0;
+int			col,row,unused;
+
+	if (gNumActiveLiquidMeshes == 0)
+		return nil;
+
+	GetLiquidPatchCellRange(x, x, z, z, &col, &unused, &row, &unused);
+
+	uint32_t mask = gLiquidPatchCellMasks[row][col];
+
+	for (int slot = 0; mask != 0; slot++, mask >>= 1)
 	{
-		if (thisNodePtr->CType & CTYPE_LIQUID)
+		if (!(mask & 1))
+			continue;
+
+		ObjNode* thisNodePtr = gLiquidPatchNodes[slot];
+		const CollisionBoxType* box = &thisNodePtr->CollisionBoxes[0];
+
+		if (x < box->left || x > box->right || z > box->front || z < box->back)
+			continue;
+
+		if (!found || gLiquidPatchSerials[slot] < foundSerial)
 		{
-			if (thisNodePtr->CollisionBoxes)
-			{
-				if (x < thisNodePtr->CollisionBoxes[0].left)
-					goto next;
-				if (x > thisNodePtr->CollisionBoxes[0].right)
-					goto next;
-				if (z > thisNodePtr->CollisionBoxes[0].front)
-					goto next;
-				if (z < thisNodePtr->CollisionBoxes[0].back)
-					goto next;
-
-				if (y)
-				{
-					*y = thisNodePtr->CollisionBoxes[0].top;
-					*y += gLiquidCollisionTopOffset[thisNodePtr->Kind];
-				}
-				return true;
-			}
-		}		
-next:					
-		thisNodePtr = (ObjNode *)thisNodePtr->NextNode;		// next node
+			found = thisNodePtr;
+			foundSerial = gLiquidPatchSerials[slot];
+		}
 	}
-	while (thisNodePtr != nil);
 
-	return false;
+	return found;
+}
+
+
+/***************** FIND LIQUID Y **********************/
+
+Boolean FindLiquidY(float x, float z, float* y)
+{
+	ObjNode* thisNodePtr = FindLiquidPatchAtCoord(x, z);
+
+	if (!thisNodePtr)
+		return false;
+
+	if (y)
+	{
+		*y = thisNodePtr->CollisionBoxes[0].top;
+		*y += gLiquidCollisionTopOffset[thisNodePtr->Kind];
+	}
+	return true;
 }
 
 
@@ -406,6 +535,8 @@ static const float	yTable2[] = {-540,-540,-540,-540,-370,-540,-540,-540};
 							depth*.5f * TERRAIN_POLYGON_SIZE,
 							-(depth*.5f) * TERRAIN_POLYGON_SIZE);
 
+	RegisterLiquidPatch(newObj);
+
 			/* SET MESH PROPERTIES */
 
 	TQ3TriMeshData* tmd = gLiquidMeshPtrs[newObj->PatchMeshID];
@@ -420,6 +551,9 @@ static const float	yTable2[] = {-540,-540,-540,-540,-370,-540,-540,-540};
 	tmd->texturingMode = kQ3TexturingModeAlphaBlend;
 	tmd->glTextureName = gLiquidShaders[LIQUID_WATER];
 
+	if (tesselateFlag)												// build static mesh
+		BuildWaterPatchMeshTesselated(newObj);
+
 	return(true);													// item was added
 }
 
@@ -430,6 +564,7 @@ static void MoveLiquidPatch(ObjNode *theNode)
 {
 	if (TrackTerrainItem(theNode))						// just check to see if it's gone
 	{
+		UnregisterLiquidPatch(theNode);
 		DisposeLiquidMesh(theNode);
 		DeleteObject(theNode);
 		return;
@@ -602,12 +737,13 @@ TQ3Point3D		*p;
 	Render_SubmitMesh(tmd, nil, &theNode->RenderModifiers, &theNode->Coord);
 }
 
-/********************* DRAW WATER PATCH TESSELATED **********************/
+/********************* BUILD WATER PATCH MESH TESSELATED **********************/
 //
 // This version tesselates the water patch so fog will look better on it.
+// The mesh is built once; the texture scrolling is done by the renderer (see DrawWaterPatchTesselated).
 //
 
-static void DrawWaterPatchTesselated(ObjNode *theNode)
+static void BuildWaterPatchMeshTesselated(ObjNode *theNode)
 {
 float			x,y,z,left,back, right, front;
 float			u,v;
@@ -622,7 +758,6 @@ TQ3TriMeshTriangleData	*t;
 
 	TQ3TriMeshData* tmd = gLiquidMeshPtrs[theNode->PatchMeshID];
 
-	const TQ3Param2D uvScroll = gLiquidUVOffsets[LIQUID_WATER];
 
 			/************************/
 			/* CALC BOUNDS OF WATER */
@@ -633,7 +768,7 @@ TQ3TriMeshTriangleData	*t;
 	z = theNode->Coord.z;
 	
 	if ((theNode->PatchWidth & 1) || (theNode->PatchDepth & 1))		// widths cannot be odd!
-		DoFatalAlert("DrawWaterPatchTesselated: water patches cannot be odd sizes! Must be even numbers.");
+		DoFatalAlert("BuildWaterPatchMeshTesselated: water patches cannot be odd sizes! Must be even numbers.");
 	
 	width2 = theNode->PatchWidth/2;
 	depth2 = theNode->PatchDepth/2;
@@ -680,8 +815,8 @@ TQ3TriMeshTriangleData	*t;
 
 				/* SET UV */
 
-			tmd->vertexUVs[i].u = uvScroll.u + u;
-			tmd->vertexUVs[i].v = uvScroll.v + v;
+			tmd->vertexUVs[i].u = u;
+			tmd->vertexUVs[i].v = v;
 
 			i++;
 			x += TERRAIN_POLYGON_SIZE*2.0f;	
@@ -734,11 +869,20 @@ TQ3TriMeshTriangleData	*t;
 	tmd->numTriangles = i;						// set # triangles in geometry
 
 
-			/*************/
-			/* SUBMIT IT */
-			/*************/
+	theNode->PatchMeshY = theNode->Coord.y;
+}
 
-	Render_SubmitMesh(tmd, nil, &theNode->RenderModifiers, &theNode->Coord);
+
+/********************* DRAW WATER PATCH TESSELATED **********************/
+
+static void DrawWaterPatchTesselated(ObjNode *theNode)
+{
+	if (theNode->Coord.y != theNode->PatchMeshY)					// water has risen since the mesh was built
+		BuildWaterPatchMeshTesselated(theNode);
+
+	theNode->RenderModifiers.uvOffset = gLiquidUVOffsets[LIQUID_WATER];
+
+	Render_SubmitMesh(gLiquidMeshPtrs[theNode->PatchMeshID], nil, &theNode->RenderModifiers, &theNode->Coord);
 }
 
 
@@ -896,6 +1040,8 @@ float				width,depth;
 							(depth*.5f) * TERRAIN_POLYGON_SIZE,
 							-(depth*.5f) * TERRAIN_POLYGON_SIZE);
 
+	RegisterLiquidPatch(newObj);
+
 			/* SET MESH PROPERTIES */
 
 	TQ3TriMeshData* tmd = gLiquidMeshPtrs[newObj->PatchMeshID];
@@ -904,16 +1050,18 @@ float				width,depth;
 	tmd->texturingMode = kQ3TexturingModeOpaque;
 	tmd->glTextureName = gLiquidShaders[kind];
 
+	BuildSolidLiquidPatchMesh(newObj);								// build static mesh
 
 	return(true);													// item was added
 }
 
-/********************* DRAW LIQUID PATCH TESSELATED **********************/
+/********************* BUILD SOLID LIQUID PATCH MESH **********************/
 //
 // This version tesselates the water patch so fog will look better on it.
+// The mesh is built once; the texture scrolling is done by the renderer (see DrawSolidLiquidPatchTesselated).
 //
 
-static void DrawSolidLiquidPatchTesselated(ObjNode *theNode)
+static void BuildSolidLiquidPatchMesh(ObjNode *theNode)
 {
 float			x,y,z,left,back, right, front;
 float			u,v;
@@ -928,7 +1076,6 @@ TQ3TriMeshTriangleData	*t;
 
 	TQ3TriMeshData* tmd = gLiquidMeshPtrs[theNode->PatchMeshID];
 
-	const TQ3Param2D uvOffset = gLiquidUVOffsets[theNode->Kind];
 
 			/*************************/
 			/* CALC BOUNDS OF LIQUID */
@@ -983,8 +1130,8 @@ TQ3TriMeshTriangleData	*t;
 
 				/* SET UV */
 
-			tmd->vertexUVs[i].u = uvOffset.u + u;
-			tmd->vertexUVs[i].v = uvOffset.v + v;
+			tmd->vertexUVs[i].u = u;
+			tmd->vertexUVs[i].v = v;
 
 			i++;
 			x += TERRAIN_POLYGON_SIZE;
@@ -1036,11 +1183,20 @@ TQ3TriMeshTriangleData	*t;
 	tmd->numTriangles = i;						// set # triangles in geometry
 
 
-			/*************/
-			/* SUBMIT IT */
-			/*************/
+	theNode->PatchMeshY = theNode->Coord.y;
+}
 
-	Render_SubmitMesh(tmd, nil, &theNode->RenderModifiers, &theNode->Coord);
+
+/********************* DRAW LIQUID PATCH TESSELATED **********************/
+
+static void DrawSolidLiquidPatchTesselated(ObjNode *theNode)
+{
+	if (theNode->Coord.y != theNode->PatchMeshY)
+		BuildSolidLiquidPatchMesh(theNode);
+
+	theNode->RenderModifiers.uvOffset = gLiquidUVOffsets[theNode->Kind];
+
+	Render_SubmitMesh(gLiquidMeshPtrs[theNode->PatchMeshID], nil, &theNode->RenderModifiers, &theNode->Coord);
 }
 
 
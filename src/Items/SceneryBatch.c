@@ -0,0 +1,582 @@
+// SCENERYBATCH.C
+// Merges static scenery into per-supertile meshes. See scenerybatch.h.
+
+#include "game.h"
+
+enum
+{
+	SCENERY_DRAW_CULLED,					// whole supertile is off screen
+	SCENERY_DRAW_BATCH,						// batch meshes drawn this frame
+	SCENERY_DRAW_INDIVIDUALLY,				// nodes draw themselves this frame
+};
+
+#define	SCENERY_BATCH_STATUS_MASK	(STATUS_BIT_NULLSHADER | STATUS_BIT_NOFOG | STATUS_BIT_NOZWRITE | STATUS_BIT_KEEPBACKFACES)
+
+		/* STATUS BITS THAT RULE OUT BATCHING */
+		//
+		// (They either change how the mesh is drawn per node or mean the node is expected to change.)
+		//
+
+#define	SCENERY_UNBATCHABLE_STATUS_BITS	(STATUS_BIT_HIDDEN | STATUS_BIT_REFLECTIONMAP | STATUS_BIT_GLOW | STATUS_BIT_CLONE \
+										| STATUS_BIT_KEEPBACKFACES_2PASS | STATUS_BIT_ONSPLINE | STATUS_BIT_DETACHED)
+
+typedef struct
+{
+	uint32_t			glTextureName;
+	TQ3TexturingMode	texturingMode;
+	uint32_t			statusBits;
+	int					numPoints;
+	int					numTriangles;
+	TQ3TriMeshData		*mesh;
+	RenderModifiers		renderMods;
+}SceneryBatchMesh;
+
+typedef struct SceneryBatchCell
+{
+	Boolean				inUse;
+	Boolean				isDirty;				// must rebuild meshes before drawing
+	Byte				drawMode;				// how the cell is drawn this frame
+	short				row,col;				// supertile
+
+	int					numNodes;
+	ObjNode				*nodes[MAX_SCENERY_PER_CELL];
+
+	int					numMeshes;
+	SceneryBatchMesh	meshes[MAX_SCENERY_BATCH_MESHES];
+
+	TQ3Point3D			center;					// bounds of all nodes' bounding spheres
+	float				radius;
+}SceneryBatchCell;
+
+
+/*********************/
+/*    VARIABLES      */
+/*********************/
+
+static SceneryBatchCell		gSceneryBatchCells[MAX_SCENERY_BATCH_CELLS];
+static SceneryBatchCell		*gSceneryBatchCellMap[MAX_SUPERTILES_DEEP][MAX_SUPERTILES_WIDE];
+
+int							gNumSceneryBatchDraws = 0;		// # of batch meshes submitted this frame
+int							gNumBatchedSceneryNodes = 0;	// # of nodes drawn through a batch this frame
+
+
+/******************** GET SCENERY BATCH CELL ************************/
+//
+// Returns the cell for the supertile, putting it in use if needed.
+// Returns nil if all cells are taken.
+//
+
+static SceneryBatchCell* GetSceneryBatchCell(long row, long col)
+{
+	SceneryBatchCell* cell = gSceneryBatchCellMap[row][col];
+	if (cell)
+		return cell;
+
+	for (int i = 0; i < MAX_SCENERY_BATCH_CELLS; i++)
+	{
+		cell = &gSceneryBatchCells[i];
+		if (!cell->inUse)
+		{
+			memset(cell, 0, sizeof(*cell));
+			cell->inUse	= true;
+			cell->row	= row;
+			cell->col	= col;
+			gSceneryBatchCellMap[row][col] = cell;
+			return cell;
+		}
+	}
+
+	return nil;
+}
+
+
+/******************** DISPOSE SCENERY BATCH MESHES ************************/
+
+static void DisposeSceneryBatchMeshes(SceneryBatchCell* cell)
+{
+	for (int m = 0; m < cell->numMeshes; m++)
+	{
+		if (cell->meshes[m].mesh)
+		{
+			Q3TriMeshData_Dispose(cell->meshes[m].mesh);
+			cell->meshes[m].mesh = nil;
+		}
+	}
+
+	cell->numMeshes = 0;
+}
+
+
+/******************** FREE SCENERY BATCH CELL ************************/
+
+static void FreeSceneryBatchCell(SceneryBatchCell* cell)
+{
+	GAME_ASSERT(cell->numNodes == 0);
+
+	DisposeSceneryBatchMeshes(cell);
+
+	gSceneryBatchCellMap[cell->row][cell->col] = nil;
+	cell->inUse = false;
+}
+
+
+#pragma mark -
+
+/******************** CAN BATCH NODE ************************/
+//
+// The batch bakes each node's colors & transform once, and is drawn in the opaque pass,
+// so only opaque display groups that look the same every frame qualify.
+//
+
+static Boolean CanBatchNode(const ObjNode* theNode)
+{
+	const RenderModifiers* mods = &theNode->RenderModifiers;
+
+	if (theNode->Genre != DISPLAY_GROUP_GENRE || theNode->NumMeshes == 0)
+		return false;
+
+	if (theNode->StatusBits & SCENERY_UNBATCHABLE_STATUS_BITS)
+		return false;
+
+	if (theNode->CustomDrawFunction)
+		return false;
+
+	if (mods->drawOrder != kDrawOrder_Default
+		|| mods->diffuseColor.a < .999f
+		|| mods->uvOffset.u != 0
+		|| mods->uvOffset.v != 0)
+		return false;
+
+	for (int i = 0; i < theNode->NumMeshes; i++)
+	{
+		const TQ3TriMeshData* mesh = theNode->MeshList[i];
+
+		if (mesh->texturingMode == kQ3TexturingModeAlphaBlend			// would need depth sorting
+			|| mesh->diffuseColor.a < .999f)
+			return false;
+
+		if (!(theNode->StatusBits & STATUS_BIT_NULLSHADER)				// lit meshes need their normals
+			&& !(mesh->texturingMode & kQ3TexturingModeExt_NullShaderFlag)
+			&& !mesh->hasVertexNormals)
+			return false;
+	}
+
+	return true;
+}
+
+
+/******************** ADD TO SCENERY BATCH ************************/
+
+Boolean AddToSceneryBatch(ObjNode *theNode)
+{
+	GAME_ASSERT(!theNode->SceneryBatch);
+
+	if (!CanBatchNode(theNode))
+		return false;
+
+			/* FIND SUPERTILE */
+
+	long row = theNode->Coord.z / TERRAIN_SUPERTILE_UNIT_SIZE;
+	long col = theNode->Coord.x / TERRAIN_SUPERTILE_UNIT_SIZE;
+
+	if (theNode->Coord.z < 0 || theNode->Coord.x < 0
+		|| row >= gNumSuperTilesDeep || col >= gNumSuperTilesWide)
+		return false;
+
+	SceneryBatchCell* cell = GetSceneryBatchCell(row, col);
+	if (!cell)
+		return false;
+
+	if (cell->numNodes >= MAX_SCENERY_PER_CELL)
+		return false;
+
+	cell->nodes[cell->numNodes++] = theNode;
+	cell->isDirty = true;
+
+	theNode->SceneryBatch = cell;
+	return true;
+}
+
+
+/******************** REMOVE FROM SCENERY BATCH ************************/
+
+void RemoveFromSceneryBatch(ObjNode *theNode)
+{
+	SceneryBatchCell* cell = theNode->SceneryBatch;
+	if (!cell)
+		return;
+
+	theNode->SceneryBatch = nil;
+
+	for (int i = 0; i < cell->numNodes; i++)
+	{
+		if (cell->nodes[i] == theNode)
+		{
+			cell->nodes[i] = cell->nodes[--cell->numNodes];
+			break;
+		}
+	}
+
+	if (cell->numNodes == 0)								// supertile scrolled out (or its last item is gone)
+		FreeSceneryBatchCell(cell);
+	else
+		cell->isDirty = true;
+}
+
+
+#pragma mark -
+
+/******************** FIND BATCH MESH FOR ************************/
+//
+// Returns the slot of the cell's batch that takes meshes like this one, or -1 if there's none yet.
+//
+
+static int FindBatchMeshFor(const SceneryBatchCell* cell, const TQ3TriMeshData* srcMesh, uint32_t statusBits)
+{
+	for (int m = 0; m < cell->numMeshes; m++)
+	{
+		const SceneryBatchMesh* bm = &cell->meshes[m];
+		if (bm->glTextureName == srcMesh->glTextureName
+			&& bm->texturingMode == srcMesh->texturingMode
+			&& bm->statusBits == statusBits)
+		{
+			return m;
+		}
+	}
+
+	return -1;
+}
+
+
+/******************** NODE FITS IN BATCH ************************/
+//
+// Checks that the cell has enough free slots left for all the textures of the node
+// that it doesn't batch yet.
+//
+
+static Boolean NodeFitsInBatch(const SceneryBatchCell* cell, const ObjNode* theNode, uint32_t statusBits)
+{
+int		numNewSlots = 0;
+
+	for (int i = 0; i < theNode->NumMeshes; i++)
+	{
+		const TQ3TriMeshData* srcMesh = theNode->MeshList[i];
+
+		if (FindBatchMeshFor(cell, srcMesh, statusBits) >= 0)
+			continue;
+
+		Boolean sharesEarlierSlot = false;							// another mesh of this node may use the same texture
+		for (int j = 0; j < i; j++)
+		{
+			if (theNode->MeshList[j]->glTextureName == srcMesh->glTextureName
+				&& theNode->MeshList[j]->texturingMode == srcMesh->texturingMode)
+			{
+				sharesEarlierSlot = true;
+				break;
+			}
+		}
+
+		if (!sharesEarlierSlot)
+			numNewSlots++;
+	}
+
+	return cell->numMeshes + numNewSlots <= MAX_SCENERY_BATCH_MESHES;
+}
+
+
+/******************** GET BATCH MESH FOR ************************/
+//
+// Returns the slot of the cell's batch that takes meshes like this one, claiming a new slot if needed.
+// Check NodeFitsInBatch first.
+//
+
+static int GetBatchMeshFor(SceneryBatchCell* cell, const TQ3TriMeshData* srcMesh, uint32_t statusBits)
+{
+	int m = FindBatchMeshFor(cell, srcMesh, statusBits);
+	if (m >= 0)
+		return m;
+
+	GAME_ASSERT(cell->numMeshes < MAX_SCENERY_BATCH_MESHES);
+
+	SceneryBatchMesh* bm = &cell->meshes[cell->numMeshes];
+	memset(bm, 0, sizeof(*bm));
+	bm->glTextureName	= srcMesh->glTextureName;
+	bm->texturingMode	= srcMesh->texturingMode;
+	bm->statusBits		= statusBits;
+
+	Render_SetDefaultModifiers(&bm->renderMods);
+	bm->renderMods.statusBits = statusBits;
+
+	return cell->numMeshes++;
+}
+
+
+/******************** REBUILD SCENERY BATCH ************************/
+//
+// Bakes every node of the cell into world-space meshes, 1 per texture.
+// Nodes that don't fit (too many textures) are dropped from the batch and draw themselves.
+//
+
+static void RebuildSceneryBatch(SceneryBatchCell* cell)
+{
+Byte	meshSlots[MAX_SCENERY_PER_CELL][MAX_DECOMPOSED_TRIMESHES];
+
+	DisposeSceneryBatchMeshes(cell);
+
+			/************************************/
+			/* PASS 1: ASSIGN MESHES TO BATCHES */
+			/************************************/
+
+	for (int n = 0; n < cell->numNodes; )
+	{
+		ObjNode* theNode = cell->nodes[n];
+		uint32_t statusBits = theNode->StatusBits & SCENERY_BATCH_STATUS_MASK;
+
+		if (!NodeFitsInBatch(cell, theNode, statusBits))			// too many textures: let it draw itself
+		{
+			theNode->SceneryBatch = nil;
+			cell->nodes[n] = cell->nodes[--cell->numNodes];
+			continue;
+		}
+
+		for (int i = 0; i < theNode->NumMeshes; i++)
+		{
+			int m = GetBatchMeshFor(cell, theNode->MeshList[i], statusBits);
+			meshSlots[n][i] = m;
+			cell->meshes[m].numPoints += theNode->MeshList[i]->numPoints;
+			cell->meshes[m].numTriangles += theNode->MeshList[i]->numTriangles;
+		}
+		n++;
+	}
+
+			/* ALLOCATE MESHES */
+
+	for (int m = 0; m < cell->numMeshes; m++)
+	{
+		SceneryBatchMesh* bm = &cell->meshes[m];
+		Boolean lit = !(bm->statusBits & STATUS_BIT_NULLSHADER) && !(bm->texturingMode & kQ3TexturingModeExt_NullShaderFlag);
+
+		bm->mesh = Q3TriMeshData_New(bm->numTriangles, bm->numPoints,
+						kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexColors
+						| (lit ? kQ3TriMeshDataFeatureVertexNormals : kQ3TriMeshDataFeatureNone));
+
+		bm->mesh->texturingMode	= bm->texturingMode;
+		bm->mesh->glTextureName	= bm->glTextureName;
+		bm->mesh->diffuseColor	= (TQ3ColorRGBA) { 1, 1, 1, 1 };
+		bm->mesh->numPoints		= 0;						// used as fill cursors below
+		bm->mesh->numTriangles	= 0;
+	}
+
+			/**********************************/
+			/* PASS 2: BAKE NODES INTO MESHES */
+			/**********************************/
+
+	TQ3BoundingBox bounds = { {0,0,0}, {0,0,0}, kQ3True };
+
+	for (int n = 0; n < cell->numNodes; n++)
+	{
+		const ObjNode* theNode = cell->nodes[n];
+		const RenderModifiers* mods = &theNode->RenderModifiers;
+
+		for (int i = 0; i < theNode->NumMeshes; i++)
+		{
+			const TQ3TriMeshData* src = theNode->MeshList[i];
+			TQ3TriMeshData* dst = cell->meshes[meshSlots[n][i]].mesh;
+			int base = dst->numPoints;
+
+			TransformPointsAffine(src->points, &theNode->BaseTransformMatrix, &dst->points[base], src->numPoints);
+
+			if (dst->hasVertexNormals)
+				TransformVectors(src->vertexNormals, &theNode->BaseTransformMatrix, &dst->vertexNormals[base], src->numPoints);	// renderer normalizes them
+
+			if (src->vertexUVs)
+				memcpy(&dst->vertexUVs[base], src->vertexUVs, src->numPoints * sizeof(TQ3Param2D));
+			else
+				memset(&dst->vertexUVs[base], 0, src->numPoints * sizeof(TQ3Param2D));
+
+					/* BAKE COLORS */
+					//
+					// Same math as the renderer's opaque pass: per-vertex colors ignore the diffuse colors.
+					//
+
+			if (src->hasVertexColors)
+			{
+				memcpy(&dst->vertexColors[base], src->vertexColors, src->numPoints * sizeof(TQ3ColorRGBA));
+			}
+			else
+			{
+				TQ3ColorRGBA color =
+				{
+					src->diffuseColor.r * mods->diffuseColor.r,
+					src->diffuseColor.g * mods->diffuseColor.g,
+					src->diffuseColor.b * mods->diffuseColor.b,
+					1.0f,
+				};
+
+				for (int v = 0; v < src->numPoints; v++)
+					dst->vertexColors[base+v] = color;
+			}
+
+			for (int t = 0; t < src->numTriangles; t++)
+			{
+				TQ3TriMeshTriangleData* tri = &dst->triangles[dst->numTriangles++];
+				tri->pointIndices[0] = src->triangles[t].pointIndices[0] + base;
+				tri->pointIndices[1] = src->triangles[t].pointIndices[1] + base;
+				tri->pointIndices[2] = src->triangles[t].pointIndices[2] + base;
+			}
+
+			dst->numPoints += src->numPoints;
+		}
+
+				/* GROW BOUNDS */
+
+		float r = theNode->BoundingSphere.radius;
+		TQ3Point3D c =
+		{
+			theNode->Coord.x + theNode->BoundingSphere.origin.x,
+			theNode->Coord.y + theNode->BoundingSphere.origin.y,
+			theNode->Coord.z + theNode->BoundingSphere.origin.z,
+		};
+
+		if (bounds.isEmpty)
+		{
+			bounds.min = (TQ3Point3D) { c.x - r, c.y - r, c.z - r };
+			bounds.max = (TQ3Point3D) { c.x + r, c.y + r, c.z + r };
+			bounds.isEmpty = kQ3False;
+		}
+		else
+		{
+			bounds.min.x = c.x - r < bounds.min.x ? c.x - r : bounds.min.x;
+			bounds.min.y = c.y - r < bounds.min.y ? c.y - r : bounds.min.y;
+			bounds.min.z = c.z - r < bounds.min.z ? c.z - r : bounds.min.z;
+			bounds.max.x = c.x + r > bounds.max.x ? c.x + r : bounds.max.x;
+			bounds.max.y = c.y + r > bounds.max.y ? c.y + r : bounds.max.y;
+			bounds.max.z = c.z + r > bounds.max.z ? c.z + r : bounds.max.z;
+		}
+	}
+
+	for (int m = 0; m < cell->numMeshes; m++)
+	{
+		GAME_ASSERT(cell->meshes[m].mesh->numPoints == cell->meshes[m].numPoints);
+		cell->meshes[m].mesh->bBox = bounds;
+	}
+
+	cell->center.x = (bounds.min.x + bounds.max.x) * .5f;
+	cell->center.y = (bounds.min.y + bounds.max.y) * .5f;
+	cell->center.z = (bounds.min.z + bounds.max.z) * .5f;
+	cell->radius = .5f * Q3Point3D_Distance(&bounds.min, &bounds.max);
+
+	cell->isDirty = false;
+
+	if (cell->numNodes == 0)										// nothing fit
+		FreeSceneryBatchCell(cell);
+}
+
+
+#pragma mark -
+
+/******************** NEEDS INDIVIDUAL DRAW ************************/
+//
+// A batch can't fade or hide single nodes, so if any of them needs it,
+// the nodes must draw themselves this frame.
+//
+
+static Boolean NeedsIndividualDraw(const SceneryBatchCell* cell, float cameraX, float cameraZ)
+{
+	for (int n = 0; n < cell->numNodes; n++)
+	{
+		const ObjNode* theNode = cell->nodes[n];
+
+		if (theNode->StatusBits & STATUS_BIT_HIDDEN)
+			return true;
+
+		if (gDoAutoFade && (theNode->StatusBits & STATUS_BIT_AUTOFADE)
+			&& CalcQuickDistance(cameraX, cameraZ, theNode->Coord.x, theNode->Coord.z) >= gAutoFadeStartDist)
+			return true;
+	}
+
+	return false;
+}
+
+
+/******************** DRAW SCENERY BATCHES ************************/
+
+void DrawSceneryBatches(const QD3DSetupOutputType *setupInfo)
+{
+float	cameraX = setupInfo->currentCameraCoords.x;
+float	cameraZ = setupInfo->currentCameraCoords.z;
+
+	gNumSceneryBatchDraws = 0;
+	gNumBatchedSceneryNodes = 0;
+
+	for (int i = 0; i < MAX_SCENERY_BATCH_CELLS; i++)
+	{
+		SceneryBatchCell* cell = &gSceneryBatchCells[i];
+		if (!cell->inUse)
+			continue;
+
+		if (cell->isDirty)
+		{
+			RebuildSceneryBatch(cell);
+			if (!cell->inUse)
+				continue;
+		}
+
+				/* CULL WHOLE SUPERTILE */
+
+		if (!IsSphereInFrustum_XZ(&cell->center, cell->radius))
+		{
+			cell->drawMode = SCENERY_DRAW_CULLED;
+			continue;
+		}
+
+		if (NeedsIndividualDraw(cell, cameraX, cameraZ))
+		{
+			cell->drawMode = SCENERY_DRAW_INDIVIDUALLY;
+			continue;
+		}
+
+				/* SUBMIT BATCH */
+
+		cell->drawMode = SCENERY_DRAW_BATCH;
+
+		for (int m = 0; m < cell->numMeshes; m++)
+		{
+			Render_SubmitMesh(cell->meshes[m].mesh, nil, &cell->meshes[m].renderMods, &cell->center);
+			gNumSceneryBatchDraws++;
+		}
+
+		gNumBatchedSceneryNodes += cell->numNodes;
+	}
+}
+
+
+/******************** IS DRAWN BY SCENERY BATCH ************************/
+
+Boolean IsDrawnBySceneryBatch(const ObjNode *theNode)
+{
+	return theNode->SceneryBatch && theNode->SceneryBatch->drawMode != SCENERY_DRAW_INDIVIDUALLY;
+}
+
+
+/******************** DISPOSE SCENERY BATCHES ************************/
+//
+// All batched nodes should be gone by now (DeleteAllObjects), which frees every cell.
+// This just makes sure nothing lingers into the next level.
+//
+
+void DisposeSceneryBatches(void)
+{
+	for (int i = 0; i < MAX_SCENERY_BATCH_CELLS; i++)
+	{
+		SceneryBatchCell* cell = &gSceneryBatchCells[i];
+		if (!cell->inUse)
+			continue;
+
+		for (int n = 0; n < cell->numNodes; n++)
+			cell->nodes[n]->SceneryBatch = nil;
+		cell->numNodes = 0;
+
+		FreeSceneryBatchCell(cell);
+	}
+}
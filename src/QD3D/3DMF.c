@@ -16,11 +16,18 @@
 /*    PROTOTYPES            */
 /****************************/
 
+static void RegisterGroupObjects(Byte groupNum);
+static void DisposeResidentModelGroup(void* payload);
 
 /****************************/
 /*    CONSTANTS             */
 /****************************/
 
+typedef struct
+{
+	TQ3MetaFile*	file;
+	GLuint*			textures;
+} ResidentModelGroup;
 
 /*********************/
 /*    VARIABLES      */
@@ -33,6 +40,8 @@ TQ3BoundingSphere	gObjectGroupRadiusList[MAX_3DMF_GROUPS][MAX_OBJECTS_IN_GROUP];
 TQ3BoundingBox 		gObjectGroupBBoxList[MAX_3DMF_GROUPS][MAX_OBJECTS_IN_GROUP];
 short				gNumObjectsInGroupList[MAX_3DMF_GROUPS];
 
+static ResidentModelGroup*	gObjectGroupResident[MAX_3DMF_GROUPS];		// non-nil if the group is borrowed from the resident asset cache
+
 
 /******************* INIT 3DMF MANAGER *************************/
 
@@ -42,6 +51,7 @@ void Init3DMFManager(void)
 	{
 		gObjectGroupFile[i] = nil;
 		gObjectGroupTextures[i] = nil;
+		gObjectGroupResident[i] = nil;
 		gNumObjectsInGroupList[i] = 0;
 	}
 }
@@ -79,6 +89,69 @@ void LoadGrouped3DMF(FSSpec *spec, Byte groupNum)
 
 			/* BUILD OBJECT LIST */
 
+	RegisterGroupObjects(groupNum);
+}
+
+
+/******************** LOAD RESIDENT GROUPED 3DMF ***********************/
+//
+// Same as LoadGrouped3DMF, but the geometry and its GPU textures are kept in the
+// resident asset cache when the group is freed, so that the next level can reuse them
+// without touching the disk.
+//
+
+void LoadResidentGrouped3DMF(FSSpec *spec, Byte groupNum)
+{
+char	key[MAX_RESIDENT_KEY_LENGTH];
+
+	GAME_ASSERT(groupNum < MAX_3DMF_GROUPS);
+
+	GAME_ASSERT_MESSAGE(gNumObjectsInGroupList[groupNum] == 0, "3DMF group was not freed before reuse");
+	GAME_ASSERT_MESSAGE(!gObjectGroupFile[groupNum], "3DMF group file not freed before reuse");
+	GAME_ASSERT_MESSAGE(!gObjectGroupTextures[groupNum], "3DMF group textures not freed before reuse");
+
+	snprintf(key, sizeof(key), "3DMF:%s", spec->cName);
+
+	ResidentModelGroup* resident = AcquireResidentAsset(key);
+
+			/* NOT CACHED YET: LOAD IT FOR REAL */
+
+	if (!resident)
+	{
+		long heapBefore = Pomme_GetHeapSize();
+
+		LoadGrouped3DMF(spec, groupNum);
+
+		resident = (ResidentModelGroup*) AllocPtr(sizeof(ResidentModelGroup));
+		resident->file = gObjectGroupFile[groupNum];
+		resident->textures = gObjectGroupTextures[groupNum];
+
+		InsertResidentAsset(key, resident, (long) Pomme_GetHeapSize() - heapBefore, DisposeResidentModelGroup);
+	}
+
+			/* ALREADY CACHED: JUST ATTACH IT */
+
+	else
+	{
+		gObjectGroupFile[groupNum] = resident->file;
+		gObjectGroupTextures[groupNum] = resident->textures;
+		RegisterGroupObjects(groupNum);
+	}
+
+	gObjectGroupResident[groupNum] = resident;
+}
+
+
+/******************** REGISTER GROUP OBJECTS ***********************/
+//
+// Builds the object list for a group whose 3DMF file is already set up.
+//
+
+static void RegisterGroupObjects(Byte groupNum)
+{
+	TQ3MetaFile* the3DMFFile = gObjectGroupFile[groupNum];
+	GAME_ASSERT(the3DMFFile);
+
 	int nObjects = the3DMFFile->numTopLevelGroups;
 	GAME_ASSERT(nObjects > 0);
 	GAME_ASSERT(nObjects <= MAX_OBJECTS_IN_GROUP);
@@ -106,6 +179,16 @@ void LoadGrouped3DMF(FSSpec *spec, Byte groupNum)
 
 void Free3DMFGroup(Byte groupNum)
 {
+			/* IF BORROWED FROM THE RESIDENT CACHE, JUST HAND IT BACK */
+
+	if (gObjectGroupResident[groupNum] != nil)
+	{
+		ReleaseResidentAsset(gObjectGroupResident[groupNum]);
+		gObjectGroupResident[groupNum] = nil;
+		gObjectGroupTextures[groupNum] = nil;
+		gObjectGroupFile[groupNum] = nil;
+	}
+
 	if (gObjectGroupTextures[groupNum] != nil)
 	{
 		GAME_ASSERT(gObjectGroupFile[groupNum] != nil);
@@ -126,6 +209,22 @@ void Free3DMFGroup(Byte groupNum)
 }
 
 
+/**************** DISPOSE RESIDENT MODEL GROUP ********************/
+//
+// Called by the resident asset cache when it evicts a group.
+//
+
+static void DisposeResidentModelGroup(void* payload)
+{
+	ResidentModelGroup* resident = (ResidentModelGroup*) payload;
+
+	glDeleteTextures(resident->file->numTextures, resident->textures);
+	DisposePtr((Ptr) resident->textures);
+	Q3MetaFile_Dispose(resident->file);
+	DisposePtr((Ptr) resident);
+}
+
+
 /******************* DELETE ALL 3DMF GROUPS ************************/
 
 void DeleteAll3DMFGroups(void)
@@ -10,6 +10,7 @@
 /****************************/
 
 #include "game.h"
+#include "simd.h"
 
 
 /****************************/
@@ -17,6 +18,9 @@
 /****************************/
 
 static inline float MaskAngle(float angle);
+#if _DEBUG
+static void VerifyMatrixMultiply(const TQ3Matrix4x4 *a, const TQ3Matrix4x4 *b, const TQ3Matrix4x4 *result, Boolean isAffine);
+#endif
 
 
 /****************************/
@@ -43,30 +47,181 @@ enum
 // Multiply matrix Mat1 by matrix Mat2, return result in Result.
 //
 // NOTE: a or b cannot == result!!!
+// (Source port note: the SIMD implementation is actually safe for this, but
+// callers should keep honoring the original contract.)
 //
 
 void MatrixMultiplyFast(TQ3Matrix4x4 *a, TQ3Matrix4x4 *b, TQ3Matrix4x4 *result)
 {
-Byte	i,j;
-
 	GAME_ASSERT(a != result);
 	GAME_ASSERT(b != result);
 
-			/* DO IT */
+	MatrixMultiply(a, b, result);
+}
+
+
+/********************* MATRIX MULTIPLY AFFINE *******************/
+//
+// Same as MatrixMultiply, but assumes that both matrices are affine, i.e. that their
+// last column is (0,0,0,1). That's the case for any combination of scale, rotation
+// and translation, which covers object and joint transforms.
+//
+// a or b may == result.
+//
+
+void MatrixMultiplyAffine(const TQ3Matrix4x4 *a, const TQ3Matrix4x4 *b, TQ3Matrix4x4 *result)
+{
+#if _DEBUG
+	const TQ3Matrix4x4 aCopy = *a;									// result may alias a or b
+	const TQ3Matrix4x4 bCopy = *b;
+#endif
+
+	const Vec4f b0 = Vec4f_Load(b->value[0]);
+	const Vec4f b1 = Vec4f_Load(b->value[1]);
+	const Vec4f b2 = Vec4f_Load(b->value[2]);
+	const Vec4f b3 = Vec4f_Load(b->value[3]);
 
-	for (i = 0; i < 4; i++)
+	Vec4f r[4];
+
+	for (int i = 0; i < 3; i++)
 	{
-		for (j = 0; j < 4; j++)
-		{
-			result->value[i][j] = 	a->value[i][0] * b->value[0][j] +
-									a->value[i][1] * b->value[1][j] +
-								 	a->value[i][2] * b->value[2][j] +
-								 	a->value[i][3] * b->value[3][j];
-		}
+		const float* row = a->value[i];
+		r[i] = Vec4f_Mul(Vec4f_Set1(row[0]), b0);
+		r[i] = Vec4f_MulAdd(Vec4f_Set1(row[1]), b1, r[i]);
+		r[i] = Vec4f_MulAdd(Vec4f_Set1(row[2]), b2, r[i]);
+	}
+
+	const float* row = a->value[3];									// translation row: implicit w=1
+	r[3] = Vec4f_MulAdd(Vec4f_Set1(row[0]), b0, b3);
+	r[3] = Vec4f_MulAdd(Vec4f_Set1(row[1]), b1, r[3]);
+	r[3] = Vec4f_MulAdd(Vec4f_Set1(row[2]), b2, r[3]);
+
+	for (int i = 0; i < 4; i++)
+		Vec4f_Store(result->value[i], r[i]);
+
+#if _DEBUG
+	VerifyMatrixMultiply(&aCopy, &bCopy, result, true);
+#endif
+}
+
+
+/********************* TRANSFORM POINTS AFFINE *******************/
+//
+// Applies an affine matrix to an array of points (w is assumed to be 1).
+// in may == out.
+//
+
+void TransformPointsAffine(const TQ3Point3D *in, const TQ3Matrix4x4 *m, TQ3Point3D *out, int numPoints)
+{
+	const Vec4f m0 = Vec4f_Load(m->value[0]);
+	const Vec4f m1 = Vec4f_Load(m->value[1]);
+	const Vec4f m2 = Vec4f_Load(m->value[2]);
+	const Vec4f m3 = Vec4f_Load(m->value[3]);
+
+	for (int i = 0; i < numPoints; i++)
+	{
+		float v[4];
+
+		Vec4f r = Vec4f_MulAdd(Vec4f_Set1(in[i].x), m0, m3);
+		r = Vec4f_MulAdd(Vec4f_Set1(in[i].y), m1, r);
+		r = Vec4f_MulAdd(Vec4f_Set1(in[i].z), m2, r);
+		Vec4f_Store(v, r);
+
+		out[i] = (TQ3Point3D) { v[0], v[1], v[2] };
 	}
 }
 
 
+/********************* TRANSFORM VECTORS *******************/
+//
+// Applies the upper 3x3 part of a matrix to an array of vectors (no translation).
+// in may == out.
+//
+
+void TransformVectors(const TQ3Vector3D *in, const TQ3Matrix4x4 *m, TQ3Vector3D *out, int numVectors)
+{
+	const Vec4f m0 = Vec4f_Load(m->value[0]);
+	const Vec4f m1 = Vec4f_Load(m->value[1]);
+	const Vec4f m2 = Vec4f_Load(m->value[2]);
+
+	for (int i = 0; i < numVectors; i++)
+	{
+		float v[4];
+
+		Vec4f r = Vec4f_Mul(Vec4f_Set1(in[i].x), m0);
+		r = Vec4f_MulAdd(Vec4f_Set1(in[i].y), m1, r);
+		r = Vec4f_MulAdd(Vec4f_Set1(in[i].z), m2, r);
+		Vec4f_Store(v, r);
+
+		out[i] = (TQ3Vector3D) { v[0], v[1], v[2] };
+	}
+}
+
+
+/********************* SET INVERSE TRANSPOSE MATRIX *******************/
+//
+// Builds the matrix that transforms normals for the affine matrix m:
+// the inverse-transpose of m's upper 3x3 part, with no translation.
+//
+// Cheaper than Q3Matrix4x4_Invert + Q3Matrix4x4_Transpose because the
+// inverse of a 3x3 matrix is just its cofactors divided by the determinant.
+//
+// A degenerate matrix (e.g. an object scaled to 0 as it pops in or out) has no
+// inverse, so it gets the identity matrix: normals are left as they are.
+//
+
+void SetInverseTransposeMatrix(const TQ3Matrix4x4 *m, TQ3Matrix4x4 *result)
+{
+	const float a = m->value[0][0], b = m->value[0][1], c = m->value[0][2];
+	const float d = m->value[1][0], e = m->value[1][1], f = m->value[1][2];
+	const float g = m->value[2][0], h = m->value[2][1], i = m->value[2][2];
+
+			/* COFACTORS */
+
+	const float c00 = e*i - f*h;
+	const float c01 = f*g - d*i;
+	const float c02 = d*h - e*g;
+	const float c10 = c*h - b*i;
+	const float c11 = a*i - c*g;
+	const float c12 = b*g - a*h;
+	const float c20 = b*f - c*e;
+	const float c21 = c*d - a*f;
+	const float c22 = a*e - b*d;
+
+	const float det = a*c00 + b*c01 + c*c02;
+
+	if (fabsf(det) < FLT_MIN)											// can't invert it
+	{
+		Q3Matrix4x4_SetIdentity(result);
+		return;
+	}
+
+	const float oneOverDet = 1.0f / det;
+
+			/* INVERSE-TRANSPOSE = COFACTOR MATRIX / DETERMINANT */
+
+	result->value[0][0] = c00 * oneOverDet;
+	result->value[0][1] = c01 * oneOverDet;
+	result->value[0][2] = c02 * oneOverDet;
+	result->value[0][3] = 0;
+
+	result->value[1][0] = c10 * oneOverDet;
+	result->value[1][1] = c11 * oneOverDet;
+	result->value[1][2] = c12 * oneOverDet;
+	result->value[1][3] = 0;
+
+	result->value[2][0] = c20 * oneOverDet;
+	result->value[2][1] = c21 * oneOverDet;
+	result->value[2][2] = c22 * oneOverDet;
+	result->value[2][3] = 0;
+
+	result->value[3][0] = 0;
+	result->value[3][1] = 0;
+	result->value[3][2] = 0;
+	result->value[3][3] = 1;
+}
+
+
 
 
 
@@ -656,41 +811,82 @@ float IntersectionOfYAndPlane_Func(float x, float z, TQ3PlaneEquation *p)
 
 void MatrixMultiply(TQ3Matrix4x4 *a, TQ3Matrix4x4 *b, TQ3Matrix4x4 *result)
 {
-TQ3Matrix4x4	*r2,temp;
-unsigned short	i,j;
+#if _DEBUG
+	const TQ3Matrix4x4 aCopy = *a;
+	const TQ3Matrix4x4 bCopy = *b;
+#endif
+
+			/* LOAD ALL OF B UP FRONT TO ALLOW RESULT TO BE A SOURCE MATRIX */
+			//
+			// Each row of the result is a linear combination of b's rows,
+			// weighted by the matching row of a.
+			//
+
+	const Vec4f b0 = Vec4f_Load(b->value[0]);
+	const Vec4f b1 = Vec4f_Load(b->value[1]);
+	const Vec4f b2 = Vec4f_Load(b->value[2]);
+	const Vec4f b3 = Vec4f_Load(b->value[3]);
 
-		/* CODE TO ALLOW RESULT TO BE A SOURCE MATRIX */
-		
-	if (result == a)
+			/* DO IT */
+
+	for (int i = 0; i < 4; i++)
 	{
-		r2 = a;
-		result = &temp;
+		const float* row = a->value[i];
+
+		Vec4f r = Vec4f_Mul(Vec4f_Set1(row[0]), b0);
+		r = Vec4f_MulAdd(Vec4f_Set1(row[1]), b1, r);
+		r = Vec4f_MulAdd(Vec4f_Set1(row[2]), b2, r);
+		r = Vec4f_MulAdd(Vec4f_Set1(row[3]), b3, r);
+
+		Vec4f_Store(result->value[i], r);			// row i of a isn't needed after this
 	}
-	else
-	if (result == b)
+
+#if _DEBUG
+	VerifyMatrixMultiply(&aCopy, &bCopy, result, false);
+#endif
+}
+
+
+#if _DEBUG
+/********************* VERIFY MATRIX MULTIPLY *******************/
+//
+// Checks the result of the SIMD multiply against the plain scalar product.
+// a and b must be copies taken before the multiply, since result may alias them.
+// If isAffine, a's last column must be (0,0,0,1), because MatrixMultiplyAffine ignores it.
+//
+
+static void VerifyMatrixMultiply(const TQ3Matrix4x4 *a, const TQ3Matrix4x4 *b, const TQ3Matrix4x4 *result, Boolean isAffine)
+{
+	if (isAffine)
 	{
-		r2 = b;
-		result = &temp;
+		GAME_ASSERT_MESSAGE(a->value[0][3] == 0 && a->value[1][3] == 0 && a->value[2][3] == 0 && a->value[3][3] == 1,
+							"MatrixMultiplyAffine: matrix isn't affine");
 	}
-	else
-		r2 = nil;
 
-			/* DO IT */
-			
-	for (i = 0; i < 4; i++)
+	for (int i = 0; i < 4; i++)
 	{
-		for (j = 0; j < 4; j++)
+		for (int j = 0; j < 4; j++)
 		{
-			result->value[i][j] = 	a->value[i][0] * b->value[0][j] +
-									a->value[i][1] * b->value[1][j] +
-								 	a->value[i][2] * b->value[2][j] +
-								 	a->value[i][3] * b->value[3][j];
+			float sum = 0;
+			float magnitude = 0;
+
+			for (int k = 0; k < 4; k++)
+			{
+				sum += a->value[i][k] * b->value[k][j];
+				magnitude += fabsf(a->value[i][k] * b->value[k][j]);
+			}
+
+			if (!isfinite(sum))									// NaN/inf inputs just pass through, like they always did
+				continue;
+
+					/* ALLOW FOR ROUNDING (FUSED MULTIPLY-ADD, DIFFERENT ORDER) */
+
+			GAME_ASSERT_MESSAGE(fabsf(result->value[i][j] - sum) <= magnitude * 1e-5f + 1e-6f,
+								"SIMD matrix multiply doesn't match scalar reference");
 		}
 	}
-				
-	if (r2)								// see if copy over input matrix
-		*r2 = temp;			
 }
+#endif
 
 
 /********************* SET LOOKAT MATRIX ********************/
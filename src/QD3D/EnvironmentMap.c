@@ -29,6 +29,9 @@
 
 TQ3Param2D				gEnvMapUVs[ENVMAP_MAX_VERTICES_PER_MESH];
 
+static TQ3Vector3D		gEnvMapNormals[ENVMAP_MAX_VERTICES_PER_MESH];
+static TQ3Vector3D		gEnvMapEyeVectors[ENVMAP_MAX_VERTICES_PER_MESH];
+
 /****************************** ENVIRONMENT MAP TRI MESH *****************************************/
 //
 // After calling this function, draw your trimesh using gEnvMapUVs as texture coordinates
@@ -47,8 +50,12 @@ void EnvironmentMapTriMesh(
 	GAME_ASSERT(transform);
 	GAME_ASSERT(mesh->numPoints <= ENVMAP_MAX_VERTICES_PER_MESH);
 
-	Q3Matrix4x4_Invert(transform, &invTranspose);						// calc inverse-transpose matrix
-	Q3Matrix4x4_Transpose(&invTranspose, &invTranspose);
+	SetInverseTransposeMatrix(transform, &invTranspose);				// calc inverse-transpose matrix
+
+			/* TRANSFORM ALL NORMALS & VERTICES IN ONE GO */
+
+	TransformVectors(mesh->vertexNormals, &invTranspose, gEnvMapNormals, mesh->numPoints);
+	TransformVectors((const TQ3Vector3D*) mesh->points, transform, gEnvMapEyeVectors, mesh->numPoints);
 
 		/****************************/
 		/* CALC UVS FOR EACH VERTEX */
@@ -58,15 +65,13 @@ void EnvironmentMapTriMesh(
 	{
 		TQ3Vector3D surfaceNormal;
 
-					/* TRANSFORM VERTEX NORMAL */
+					/* NORMALIZE TRANSFORMED VERTEX NORMAL */
 
-		Q3Vector3D_Transform(&mesh->vertexNormals[vertNum], &invTranspose, &surfaceNormal);
-		Q3Vector3D_Normalize(&surfaceNormal, &surfaceNormal);
+		Q3Vector3D_Normalize(&gEnvMapNormals[vertNum], &surfaceNormal);
 
 					/* CALC VECTOR TO VERTEX */
 
-		TQ3Vector3D eyeVector;
-		Q3Vector3D_Transform((const TQ3Vector3D*)&mesh->points[vertNum], transform, &eyeVector);
+		TQ3Vector3D eyeVector = gEnvMapEyeVectors[vertNum];
 		eyeVector.x -= camCoord->x;
 		eyeVector.y -= camCoord->y;
 		eyeVector.z -= camCoord->z;
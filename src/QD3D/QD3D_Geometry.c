@@ -38,13 +38,63 @@ static const TQ3Matrix4x4 kIdentity4x4 =
 	{0, 0, 0, 1},
 }};
 
+#define SHARD_GRAVITY			(1700.0f / 3)
+#define SHARD_GRAVITY_HEAVY		(1700.0f / 2)
+
+
 /*********************/
 /*    VARIABLES      */
 /*********************/
 
-static ShardType			gShards[MAX_SHARDS];
+typedef struct
+{
+	TQ3Point3D				points[3];				// relative to shard center
+	TQ3Vector3D				normals[3];
+	TQ3Param2D				uvs[3];
+	TQ3ColorRGBA			colors[3];
+	Byte					mode;
+	Byte					material;
+}ShardGeometry;
+
+typedef struct
+{
+	int						refCount;				// number of live shards using this material
+	GLuint					glTextureName;
+	int						internalTextureID;
+	TQ3TexturingMode		texturingMode;
+	TQ3ColorRGBA			diffuseColor;
+	bool					hasVertexColors;
+	TQ3TriMeshData			*mesh;					// all shards using this material get batched into this mesh
+}ShardMaterial;
+
+		/* LIVE SHARDS ARE PACKED INTO INDICES 0..gNumShards-1 */
+		//
+		// The physics state is stored as separate arrays so MoveShards
+		// can integrate all shards in tight loops that the compiler vectorizes.
+		//
+
+static int					gNumShards = 0;
+
+static float				gShardX[MAX_SHARDS];
+static float				gShardY[MAX_SHARDS];
+static float				gShardZ[MAX_SHARDS];
+static float				gShardDX[MAX_SHARDS];
+static float				gShardDY[MAX_SHARDS];
+static float				gShardDZ[MAX_SHARDS];
+static float				gShardRotX[MAX_SHARDS];
+static float				gShardRotY[MAX_SHARDS];
+static float				gShardRotZ[MAX_SHARDS];
+static float				gShardRotDX[MAX_SHARDS];
+static float				gShardRotDY[MAX_SHARDS];
+static float				gShardRotDZ[MAX_SHARDS];
+static float				gShardScale[MAX_SHARDS];
+static float				gShardDecaySpeed[MAX_SHARDS];
+static float				gShardGravity[MAX_SHARDS];
+
+static ShardGeometry		gShardGeometry[MAX_SHARDS];
+
+static ShardMaterial		gShardMaterials[MAX_SHARD_MATERIALS];
 static RenderModifiers		kShardRenderMods;
-Pool						*gShardPool = NULL;
 
 
 /*************** QD3D: CALC OBJECT BOUNDING BOX ************************/
@@ -147,17 +197,11 @@ void QD3D_CalcObjectBoundingSphere(int numMeshes, TQ3TriMeshData** meshList, TQ3
 
 void QD3D_InitShards(void)
 {
-	if (!gShardPool)
-		gShardPool = Pool_New(MAX_SHARDS);
-	else
-		Pool_Reset(gShardPool);
+	gNumShards = 0;
 
-	for (int i = 0; i < MAX_SHARDS; i++)
+	for (int i = 0; i < MAX_SHARD_MATERIALS; i++)
 	{
-		ShardType* shard = &gShards[i];
-		shard->mesh = Q3TriMeshData_New(1, 3, kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexNormals);
-		for (int v = 0; v < 3; v++)
-			shard->mesh->triangles[0].pointIndices[v] = v;
+		gShardMaterials[i].refCount = 0;				// batch meshes get allocated on demand
 	}
 
 	Render_SetDefaultModifiers(&kShardRenderMods);
@@ -170,18 +214,18 @@ void QD3D_InitShards(void)
 
 void QD3D_DisposeShards(void)
 {
-	for (int i = 0; i < MAX_SHARDS; i++)
+	for (int i = 0; i < MAX_SHARD_MATERIALS; i++)
 	{
-		ShardType* shard = &gShards[i];
-		if (shard->mesh)
+		ShardMaterial* material = &gShardMaterials[i];
+		if (material->mesh)
 		{
-			Q3TriMeshData_Dispose(shard->mesh);
-			shard->mesh = NULL;
+			Q3TriMeshData_Dispose(material->mesh);
+			material->mesh = NULL;
 		}
+		material->refCount = 0;
 	}
 
-	Pool_Free(gShardPool);
-	gShardPool = NULL;
+	gNumShards = 0;
 }
 
 
@@ -252,10 +296,73 @@ void QD3D_MirrorMeshesZ(ObjNode* theNode)
 }
 
 
+/******************** FIND SHARD MATERIAL *****************************/
+//
+// Returns the index of a shard material matching the mesh's appearance,
+// allocating a new one if needed. Returns -1 if all materials are in use.
+//
+
+static int FindShardMaterial(const TQ3TriMeshData* inMesh)
+{
+	int freeSlot = -1;
+
+	for (int i = 0; i < MAX_SHARD_MATERIALS; i++)
+	{
+		ShardMaterial* material = &gShardMaterials[i];
+
+		if (material->refCount <= 0)
+		{
+			if (freeSlot < 0)
+				freeSlot = i;
+			continue;
+		}
+
+		if (material->texturingMode == inMesh->texturingMode
+			&& material->hasVertexColors == inMesh->hasVertexColors
+			&& (material->texturingMode == kQ3TexturingModeOff || material->glTextureName == inMesh->glTextureName)
+			&& material->diffuseColor.r == inMesh->diffuseColor.r
+			&& material->diffuseColor.g == inMesh->diffuseColor.g
+			&& material->diffuseColor.b == inMesh->diffuseColor.b
+			&& material->diffuseColor.a == inMesh->diffuseColor.a)
+		{
+			return i;
+		}
+	}
+
+	if (freeSlot < 0)
+		return -1;
+
+			/* SET UP NEW MATERIAL */
+
+	ShardMaterial* material = &gShardMaterials[freeSlot];
+
+	material->refCount			= 0;
+	material->texturingMode		= inMesh->texturingMode;
+	material->glTextureName		= inMesh->glTextureName;
+	material->internalTextureID	= inMesh->internalTextureID;
+	material->diffuseColor		= inMesh->diffuseColor;
+	material->hasVertexColors	= inMesh->hasVertexColors;
+
+	if (!material->mesh)
+	{
+		material->mesh = Q3TriMeshData_New(MAX_SHARDS, MAX_SHARDS*3,
+				kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexNormals | kQ3TriMeshDataFeatureVertexColors);
+
+		for (int t = 0; t < MAX_SHARDS; t++)
+		{
+			for (int v = 0; v < 3; v++)
+				material->mesh->triangles[t].pointIndices[v] = t*3 + v;
+		}
+	}
+
+	return freeSlot;
+}
+
+
 /********************** EXPLODE TRIMESH *******************************/
 //
-// INPUT: 	theTriMesh = trimesh object if input is object (nil if inData)
-//			inData = trimesh data if input is raw data (nil if above)
+// INPUT: 	inMesh = trimesh data to break up into shards
+//			transform = matrix to apply to the mesh's points
 //
 
 static void ExplodeTriMesh(
@@ -266,6 +373,19 @@ static void ExplodeTriMesh(
 		int shardDensity,
 		float shardDecaySpeed)
 {
+	GAME_ASSERT(inMesh->hasVertexNormals);
+
+	if (inMesh->texturingMode != kQ3TexturingModeOff)
+		GAME_ASSERT(inMesh->vertexUVs);
+
+			/* ALL SHARDS FROM THIS MESH SHARE A MATERIAL */
+
+	int materialNum = FindShardMaterial(inMesh);
+	if (materialNum < 0)
+		return;
+
+	ShardMaterial* material = &gShardMaterials[materialNum];
+
 			/*******************************/
 			/* SCAN THRU ALL TRIMESH FACES */
 			/*******************************/
@@ -274,212 +394,312 @@ static void ExplodeTriMesh(
 	{
 				/* GET FREE SHARD INDEX */
 
-		int shardIndex = Pool_AllocateIndex(gShardPool);
-		if (shardIndex < 0)												// see if all out
+		if (gNumShards >= MAX_SHARDS)									// see if all out
 			break;
 
-		ShardType* shard = &gShards[shardIndex];
+		int i = gNumShards++;
 
-		TQ3TriMeshData* sMesh = shard->mesh;
+		ShardGeometry* geom = &gShardGeometry[i];
 
 		const uint32_t* ind = inMesh->triangles[t].pointIndices;		// get indices of 3 points
 
-				/*********************/
-				/* INIT TRIMESH DATA */
-				/*********************/
- 
 				/* DO POINTS */
 
 		for (int v = 0; v < 3; v++)
 		{
-			Q3Point3D_Transform(&inMesh->points[ind[v]], transform, &sMesh->points[v]);		// transform points
+			Q3Point3D_Transform(&inMesh->points[ind[v]], transform, &geom->points[v]);		// transform points
 		}
 
 		TQ3Point3D centerPt =
 		{
-			(sMesh->points[0].x + sMesh->points[1].x + sMesh->points[2].x) * 0.3333f,		// calc center of polygon
-			(sMesh->points[0].y + sMesh->points[1].y + sMesh->points[2].y) * 0.3333f,
-			(sMesh->points[0].z + sMesh->points[1].z + sMesh->points[2].z) * 0.3333f,
+			(geom->points[0].x + geom->points[1].x + geom->points[2].x) * 0.3333f,		// calc center of polygon
+			(geom->points[0].y + geom->points[1].y + geom->points[2].y) * 0.3333f,
+			(geom->points[0].z + geom->points[1].z + geom->points[2].z) * 0.3333f,
 		};
 
 		for (int v = 0; v < 3; v++)
 		{
-			sMesh->points[v].x -= centerPt.x;											// offset coords to be around center
-			sMesh->points[v].y -= centerPt.y;
-			sMesh->points[v].z -= centerPt.z;
+			geom->points[v].x -= centerPt.x;											// offset coords to be around center
+			geom->points[v].y -= centerPt.y;
+			geom->points[v].z -= centerPt.z;
 		}
 
-		sMesh->bBox.min = sMesh->bBox.max = centerPt;
-		sMesh->bBox.isEmpty = kQ3False;
-
-
 				/* DO VERTEX NORMALS */
 
-		GAME_ASSERT(inMesh->hasVertexNormals);
 		for (int v = 0; v < 3; v++)
 		{
-			Q3Vector3D_Transform(&inMesh->vertexNormals[ind[v]], transform, &sMesh->vertexNormals[v]);		// transform normals
-			Q3Vector3D_Normalize(&sMesh->vertexNormals[v], &sMesh->vertexNormals[v]);						// normalize normals
+			Q3Vector3D_Transform(&inMesh->vertexNormals[ind[v]], transform, &geom->normals[v]);		// transform normals
+			Q3Vector3D_Normalize(&geom->normals[v], &geom->normals[v]);								// normalize normals
 		}
 
 				/* DO VERTEX UV'S */
 
-		sMesh->texturingMode = inMesh->texturingMode;
 		if (inMesh->texturingMode != kQ3TexturingModeOff)				// see if also has UV
 		{
-			GAME_ASSERT(inMesh->vertexUVs);
 			for (int v = 0; v < 3; v++)									// get vertex u/v's
 			{
-				sMesh->vertexUVs[v] = inMesh->vertexUVs[ind[v]];
+				geom->uvs[v] = inMesh->vertexUVs[ind[v]];
 			}
-			sMesh->glTextureName = inMesh->glTextureName;
-			sMesh->internalTextureID = inMesh->internalTextureID;
 		}
 
 				/* DO VERTEX COLORS */
 
-		sMesh->diffuseColor = inMesh->diffuseColor;
-
-		sMesh->hasVertexColors = inMesh->hasVertexColors;				// has per-vertex colors?
 		if (inMesh->hasVertexColors)
 		{
 			for (int v = 0; v < 3; v++)									// get per-vertex colors
 			{
-				sMesh->vertexColors[v] = inMesh->vertexColors[ind[v]];
+				geom->colors[v] = inMesh->vertexColors[ind[v]];
 			}
 		}
 
+		geom->mode = shardMode;
+		geom->material = materialNum;
+		material->refCount++;
+
 			/*********************/
 			/* SET PHYSICS STUFF */
 			/*********************/
 
-		shard->coord = centerPt;
-		shard->rot = (TQ3Vector3D) {0, 0, 0};
-		shard->scale = 1.0f;
+		gShardX[i] = centerPt.x;
+		gShardY[i] = centerPt.y;
+		gShardZ[i] = centerPt.z;
+
+		gShardRotX[i] = 0;
+		gShardRotY[i] = 0;
+		gShardRotZ[i] = 0;
+
+		gShardScale[i] = 1.0f;
 
-		shard->coordDelta.x = (RandomFloat() - 0.5f) * boomForce;
-		shard->coordDelta.y = (RandomFloat() - 0.5f) * boomForce;
-		shard->coordDelta.z = (RandomFloat() - 0.5f) * boomForce;
+		gShardDX[i] = (RandomFloat() - 0.5f) * boomForce;
+		gShardDY[i] = (RandomFloat() - 0.5f) * boomForce;
+		gShardDZ[i] = (RandomFloat() - 0.5f) * boomForce;
 		if (shardMode & SHARD_MODE_UPTHRUST)
-			shard->coordDelta.y += 1.5f * boomForce;
+			gShardDY[i] += 1.5f * boomForce;
 
-		shard->rotDelta.x = (RandomFloat() - 0.5f) * 4.0f;			// random rotation deltas
-		shard->rotDelta.y = (RandomFloat() - 0.5f) * 4.0f;
-		shard->rotDelta.z = (RandomFloat() - 0.5f) * 4.0f;
+		gShardRotDX[i] = (RandomFloat() - 0.5f) * 4.0f;			// random rotation deltas
+		gShardRotDY[i] = (RandomFloat() - 0.5f) * 4.0f;
+		gShardRotDZ[i] = (RandomFloat() - 0.5f) * 4.0f;
 
-		shard->decaySpeed = shardDecaySpeed;
-		shard->mode = shardMode;
+		gShardDecaySpeed[i] = shardDecaySpeed;
+		gShardGravity[i] = (shardMode & SHARD_MODE_HEAVYGRAVITY) ? SHARD_GRAVITY_HEAVY : SHARD_GRAVITY;
 	}
 }
 
 
-/************************** QD3D: MOVE SHARDS ****************************/
+/************************** DELETE SHARD ****************************/
+//
+// Moves the last live shard into the given slot to keep the arrays packed.
+//
 
-void QD3D_MoveShards(void)
+static void DeleteShard(int i)
 {
-float	ty,y,fps,x,z;
-TQ3Matrix4x4	matrix,matrix2;
+	GAME_ASSERT(i >= 0 && i < gNumShards);
+
+	gShardMaterials[gShardGeometry[i].material].refCount--;
 
-	if (!gShardPool || Pool_Empty(gShardPool))					// quick check if any shards at all
+	int last = --gNumShards;
+	if (i == last)
 		return;
 
-	fps = gFramesPerSecondFrac;
-	ty = -100.0f;												// pin point to "floor" if no terrain
+	gShardX[i]			= gShardX[last];
+	gShardY[i]			= gShardY[last];
+	gShardZ[i]			= gShardZ[last];
+	gShardDX[i]			= gShardDX[last];
+	gShardDY[i]			= gShardDY[last];
+	gShardDZ[i]			= gShardDZ[last];
+	gShardRotX[i]		= gShardRotX[last];
+	gShardRotY[i]		= gShardRotY[last];
+	gShardRotZ[i]		= gShardRotZ[last];
+	gShardRotDX[i]		= gShardRotDX[last];
+	gShardRotDY[i]		= gShardRotDY[last];
+	gShardRotDZ[i]		= gShardRotDZ[last];
+	gShardScale[i]		= gShardScale[last];
+	gShardDecaySpeed[i]	= gShardDecaySpeed[last];
+	gShardGravity[i]	= gShardGravity[last];
+	gShardGeometry[i]	= gShardGeometry[last];
+}
 
-	int i = Pool_First(gShardPool);
-	while (i >= 0)
-	{
-		GAME_ASSERT(Pool_IsUsed(gShardPool, i));
 
-		int nextIndex = Pool_Next(gShardPool, i);
+/************************** QD3D: MOVE SHARDS ****************************/
 
-		ShardType* shard = &gShards[i];
+void QD3D_MoveShards(void)
+{
+	const int n = gNumShards;
+	const float fps = gFramesPerSecondFrac;
 
-				/* ROTATE IT */
+	if (n == 0)													// quick check if any shards at all
+		return;
 
-		shard->rot.x += shard->rotDelta.x * fps;
-		shard->rot.y += shard->rotDelta.y * fps;
-		shard->rot.z += shard->rotDelta.z * fps;
+			/*************************************/
+			/* INTEGRATE ALL SHARDS IN ONE SWEEP */
+			/*************************************/
+			//
+			// Keep these loops free of branches and calls so they vectorize.
+			//
 
-					/* MOVE IT */
+	for (int i = 0; i < n; i++)									// rotate
+	{
+		gShardRotX[i] += gShardRotDX[i] * fps;
+		gShardRotY[i] += gShardRotDY[i] * fps;
+		gShardRotZ[i] += gShardRotDZ[i] * fps;
+	}
 
-		if (shard->mode & SHARD_MODE_HEAVYGRAVITY)
-			shard->coordDelta.y -= fps * 1700.0f / 2;			// gravity
-		else
-			shard->coordDelta.y -= fps * 1700.0f / 3;			// gravity
+	for (int i = 0; i < n; i++)									// gravity & move
+	{
+		gShardDY[i] -= gShardGravity[i] * fps;
+		gShardX[i] += gShardDX[i] * fps;
+		gShardY[i] += gShardDY[i] * fps;
+		gShardZ[i] += gShardDZ[i] * fps;
+	}
 
-		x = (shard->coord.x += shard->coordDelta.x * fps);
-		y = (shard->coord.y += shard->coordDelta.y * fps);
-		z = (shard->coord.z += shard->coordDelta.z * fps);
+	for (int i = 0; i < n; i++)									// shrink
+	{
+		gShardScale[i] -= gShardDecaySpeed[i] * fps;
+	}
 
+			/*****************************/
+			/* SEE IF BOUNCE OR GONE     */
+			/*****************************/
+			//
+			// Walk backwards so that DeleteShard only ever pulls in shards we've already visited.
+			//
 
-					/* SEE IF BOUNCE */
+	for (int i = n - 1; i >= 0; i--)
+	{
+		float ty = -100.0f;										// pin point to "floor" if no terrain
 
 		if (gFloorMap)
-			ty = GetTerrainHeightAtCoord(x,z, FLOOR);			// get terrain height here
+			ty = GetTerrainHeightAtCoord(gShardX[i], gShardZ[i], FLOOR);		// get terrain height here
 
-		if (y <= ty)
+		if (gShardY[i] <= ty)
 		{
-			if (shard->mode & SHARD_MODE_BOUNCE)
+			if (gShardGeometry[i].mode & SHARD_MODE_BOUNCE)
 			{
-				shard->coord.y  = ty;
-				shard->coordDelta.y *= -0.5f;
-				shard->coordDelta.x *= 0.9f;
-				shard->coordDelta.z *= 0.9f;
+				gShardY[i] = ty;
+				gShardDY[i] *= -0.5f;
+				gShardDX[i] *= 0.9f;
+				gShardDZ[i] *= 0.9f;
 			}
 			else
-				goto del;
+			{
+				DeleteShard(i);
+				continue;
+			}
 		}
 
-					/* SCALE IT */
-
-		shard->scale -= shard->decaySpeed * fps;
-		if (shard->scale <= 0.0f)
+		if (gShardScale[i] <= 0.0f)
 		{
-				/* DEACTIVATE THIS SHARD */
-	del:
-			Pool_ReleaseIndex(gShardPool, i);
-			goto next;
+			DeleteShard(i);
 		}
+	}
+}
+
+
+/************************* QD3D: DRAW SHARDS ****************************/
+//
+// Transforms every live shard into world space and appends it to the
+// batch mesh of its material, then submits one mesh per material.
+//
+
+void QD3D_DrawShards(const QD3DSetupOutputType *setupInfo)
+{
+	(void) setupInfo;
 
-			/***************************/
-			/* UPDATE TRANSFORM MATRIX */
-			/***************************/
+	if (gNumShards == 0)							// quick check if any shards at all
+		return;
 
+			/* RESET BATCHES */
 
-				/* SET SCALE MATRIX */
+	for (int m = 0; m < MAX_SHARD_MATERIALS; m++)
+	{
+		ShardMaterial* material = &gShardMaterials[m];
+		if (material->refCount <= 0)
+			continue;
+
+		TQ3TriMeshData* mesh = material->mesh;
+		mesh->numTriangles		= 0;
+		mesh->numPoints			= 0;
+		mesh->texturingMode		= material->texturingMode;
+		mesh->glTextureName		= material->glTextureName;
+		mesh->internalTextureID	= material->internalTextureID;
+		mesh->diffuseColor		= material->diffuseColor;
+		mesh->hasVertexColors	= material->hasVertexColors;
+		mesh->hasVertexNormals	= true;
+		mesh->bBox.isEmpty		= kQ3False;
+		mesh->bBox.min			= (TQ3Point3D) { 1e9f, 1e9f, 1e9f };
+		mesh->bBox.max			= (TQ3Point3D) { -1e9f, -1e9f, -1e9f };
+	}
 
-		Q3Matrix4x4_SetScale(&shard->matrix, shard->scale, shard->scale, shard->scale);
+			/* APPEND EACH SHARD TO ITS BATCH */
 
-					/* NOW ROTATE IT */
+	for (int i = 0; i < gNumShards; i++)
+	{
+		const ShardGeometry* geom = &gShardGeometry[i];
+		ShardMaterial* material = &gShardMaterials[geom->material];
+		TQ3TriMeshData* mesh = material->mesh;
 
-		Q3Matrix4x4_SetRotate_XYZ(&matrix, shard->rot.x, shard->rot.y, shard->rot.z);
-		MatrixMultiplyFast(&shard->matrix, &matrix, &matrix2);
+		GAME_ASSERT(material->refCount > 0);
+		GAME_ASSERT(mesh->numTriangles < MAX_SHARDS);
 
-					/* NOW TRANSLATE IT */
+		TQ3Matrix4x4 rm;
+		Q3Matrix4x4_SetRotate_XYZ(&rm, gShardRotX[i], gShardRotY[i], gShardRotZ[i]);
+#define R(row,col) rm.value[row][col]
 
-		Q3Matrix4x4_SetTranslate(&matrix, shard->coord.x, shard->coord.y, shard->coord.z);
-		MatrixMultiplyFast(&matrix2,&matrix, &shard->matrix);
+		const float s = gShardScale[i];
+		const int base = mesh->numPoints;
 
-next:
-		i = nextIndex;
-	}
-}
+		for (int v = 0; v < 3; v++)
+		{
+			const TQ3Point3D* p = &geom->points[v];
+			const TQ3Vector3D* n = &geom->normals[v];
+			TQ3Point3D* out = &mesh->points[base + v];
 
+			// Same as scale * rotate * translate matrix, but without building it
+			out->x = s * (p->x*R(0,0) + p->y*R(1,0) + p->z*R(2,0)) + gShardX[i];
+			out->y = s * (p->x*R(0,1) + p->y*R(1,1) + p->z*R(2,1)) + gShardY[i];
+			out->z = s * (p->x*R(0,2) + p->y*R(1,2) + p->z*R(2,2)) + gShardZ[i];
 
-/************************* QD3D: DRAW SHARDS ****************************/
+			mesh->vertexNormals[base + v] = (TQ3Vector3D)
+			{
+				n->x*R(0,0) + n->y*R(1,0) + n->z*R(2,0),
+				n->x*R(0,1) + n->y*R(1,1) + n->z*R(2,1),
+				n->x*R(0,2) + n->y*R(1,2) + n->z*R(2,2),
+			};
+
+			if (out->x < mesh->bBox.min.x) mesh->bBox.min.x = out->x;
+			if (out->y < mesh->bBox.min.y) mesh->bBox.min.y = out->y;
+			if (out->z < mesh->bBox.min.z) mesh->bBox.min.z = out->z;
+			if (out->x > mesh->bBox.max.x) mesh->bBox.max.x = out->x;
+			if (out->y > mesh->bBox.max.y) mesh->bBox.max.y = out->y;
+			if (out->z > mesh->bBox.max.z) mesh->bBox.max.z = out->z;
+		}
+#undef R
 
-void QD3D_DrawShards(const QD3DSetupOutputType *setupInfo)
-{
-	(void) setupInfo;
+		if (material->texturingMode != kQ3TexturingModeOff)
+		{
+			for (int v = 0; v < 3; v++)
+				mesh->vertexUVs[base + v] = geom->uvs[v];
+		}
 
-	if (!gShardPool || Pool_Empty(gShardPool))		// quick check if any shards at all
-		return;
+		if (material->hasVertexColors)
+		{
+			for (int v = 0; v < 3; v++)
+				mesh->vertexColors[base + v] = geom->colors[v];
+		}
+
+		mesh->numPoints += 3;
+		mesh->numTriangles++;
+	}
 
-	for (int i = Pool_First(gShardPool); i >= 0; i = Pool_Next(gShardPool, i))
+			/* SUBMIT ONE MESH PER MATERIAL */
+
+	for (int m = 0; m < MAX_SHARD_MATERIALS; m++)
 	{
-		ShardType* shard = &gShards[i];
-		Render_SubmitMesh(shard->mesh, &shard->matrix, &kShardRenderMods, &shard->coord);
+		const ShardMaterial* material = &gShardMaterials[m];
+		if (material->refCount > 0 && material->mesh->numTriangles > 0)
+		{
+			Render_SubmitMesh(material->mesh, nil, &kShardRenderMods, nil);
+		}
 	}
 }
 
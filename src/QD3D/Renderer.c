@@ -37,11 +37,13 @@ typedef struct RendererState
 	bool		hasState_GL_BLEND;
 	bool		hasState_GL_LIGHTING;
 	bool		hasState_GL_FOG;
+	bool		hasState_GL_POINT_SPRITE;
 	bool		hasFlag_glDepthMask;
 	bool		blendFuncIsAdditive;
 	bool		sceneHasFog;
 	GLboolean	wantColorMask;
 	const TQ3Matrix4x4*	currentTransform;
+	TQ3Param2D	currentUVOffset;
 } RendererState;
 
 typedef struct MeshQueueEntry
@@ -49,6 +51,8 @@ typedef struct MeshQueueEntry
 	const TQ3TriMeshData*	mesh;
 	const TQ3Matrix4x4*		transform;	// may be NULL
 	const RenderModifiers*	mods;		// may be NULL
+	const uint16_t*			shortIndices;	// if non-NULL, drawn instead of mesh->triangles
+	int						numShortTriangles;
 	float					depth;		// used to determine draw order
 	bool					meshIsTransparent;
 } MeshQueueEntry;
@@ -269,6 +273,7 @@ void Render_InitState(const TQ3ColorRGBA* clearColor)
 	SetInitialState(GL_BLEND,			false);
 	SetInitialState(GL_LIGHTING,		true);
 	SetInitialState(GL_FOG,				false);
+	SetInitialState(GL_POINT_SPRITE,	false);
 
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	gState.blendFuncIsAdditive = false;		// must match glBlendFunc call above!
@@ -284,6 +289,7 @@ void Render_InitState(const TQ3ColorRGBA* clearColor)
 	gState.boundTexture = 0;
 	gState.sceneHasFog = false;
 	gState.currentTransform = NULL;
+	gState.currentUVOffset = (TQ3Param2D) {0, 0};
 
 	glClearColor(clearColor->r, clearColor->g, clearColor->b, 1.0f);
 	
@@ -291,6 +297,7 @@ void Render_InitState(const TQ3ColorRGBA* clearColor)
 	glAlphaFunc(GL_GREATER, 0.4999f);
 	glFrontFace(GL_CCW);
 	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+	glTexEnvi(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);		// only takes effect when GL_POINT_SPRITE is enabled
 
 	// Set up mesh queue
 	gMeshQueueSize = 0;
@@ -540,6 +547,7 @@ void Render_StartFrame(void)
 	glClear(clearWhat);
 
 	GAME_ASSERT(gState.currentTransform == NULL);
+	GAME_ASSERT(gState.currentUVOffset.u == 0 && gState.currentUVOffset.v == 0);
 
 	GAME_ASSERT(!gFrameStarted);
 	gFrameStarted = true;
@@ -639,6 +647,15 @@ void Render_FlushQueue(void)
 		glPopMatrix();
 		gState.currentTransform = NULL;
 	}
+
+	// Clear texture matrix
+	if (gState.currentUVOffset.u != 0 || gState.currentUVOffset.v != 0)
+	{
+		glMatrixMode(GL_TEXTURE);
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+		gState.currentUVOffset = (TQ3Param2D) {0, 0};
+	}
 }
 
 void Render_EndFrame(void)
@@ -705,6 +722,7 @@ static MeshQueueEntry* NewMeshQueueEntry(void)
 	MeshQueueEntry* entry = &gMeshQueueEntryPool[gMeshQueueSize];
 	gMeshQueuePtrs[gMeshQueueSize] = entry;
 	gMeshQueueSize++;
+	entry->shortIndices = NULL;
 	return entry;
 }
 
@@ -761,6 +779,27 @@ void Render_SubmitMesh(
 	GAME_ASSERT(!(entry->mods->statusBits & STATUS_BIT_HIDDEN));
 }
 
+void Render_SubmitMeshWithShortIndices(
+		const TQ3TriMeshData*	mesh,
+		int						numTriangles,
+		const uint16_t*			indices,
+		const TQ3Matrix4x4*		transform,
+		const RenderModifiers*	mods,
+		const TQ3Point3D*		centerCoord)
+{
+	GAME_ASSERT(indices);
+	GAME_ASSERT(numTriangles > 0);
+	GAME_ASSERT(mesh->numPoints <= 0xFFFF);
+
+	Render_SubmitMesh(mesh, transform, mods, centerCoord);
+
+	MeshQueueEntry* entry = gMeshQueuePtrs[gMeshQueueSize-1];
+	entry->shortIndices			= indices;
+	entry->numShortTriangles	= numTriangles;
+
+	gRenderStats.triangles += numTriangles - mesh->numTriangles;
+}
+
 #pragma mark -
 
 static int DrawOrderComparator(const void* a_void, const void* b_void)
@@ -846,8 +885,43 @@ static void SendGeometry(const MeshQueueEntry* entry)
 		gState.currentTransform = entry->transform;
 	}
 
+	// Submit texture coordinate offset
+	const TQ3Param2D uvOffset = entry->mods->uvOffset;
+	if (gState.currentUVOffset.u != uvOffset.u || gState.currentUVOffset.v != uvOffset.v)
+	{
+		glMatrixMode(GL_TEXTURE);
+		glLoadIdentity();
+		glTranslatef(uvOffset.u, uvOffset.v, 0);
+		glMatrixMode(GL_MODELVIEW);
+
+		gState.currentUVOffset = uvOffset;
+	}
+
+	// Draw vertices as point sprites
+	if (entry->mods->pointSize > 0)
+	{
+		GAME_ASSERT(!(statusBits & STATUS_BIT_KEEPBACKFACES_2PASS));		// face culling doesn't apply to points
+		EnableState(GL_POINT_SPRITE);
+		glPointSize(entry->mods->pointSize);
+		glDrawArrays(GL_POINTS, 0, mesh->numPoints);
+		DisableState(GL_POINT_SPRITE);
+		CHECK_GL_ERROR();
+		return;
+	}
+
+	// Pick index list
+	GLenum indexType = GL_UNSIGNED_INT;
+	const GLvoid* indices = mesh->triangles;
+	int numIndices = mesh->numTriangles * 3;
+	if (entry->shortIndices)
+	{
+		indexType = GL_UNSIGNED_SHORT;
+		indices = entry->shortIndices;
+		numIndices = entry->numShortTriangles * 3;
+	}
+
 	// Draw the mesh
-	glDrawElements(GL_TRIANGLES, mesh->numTriangles*3, GL_UNSIGNED_INT, mesh->triangles);
+	glDrawElements(GL_TRIANGLES, numIndices, indexType, indices);
 	CHECK_GL_ERROR();
 
 	// Pass 2 to draw transparent meshes without face culling (see above for an explanation)
@@ -857,7 +931,7 @@ static void SendGeometry(const MeshQueueEntry* entry)
 		glCullFace(GL_BACK);	// pass 2: draw frontfaces (cull backfaces)
 
 		// Draw the mesh again
-		glDrawElements(GL_TRIANGLES, mesh->numTriangles * 3, GL_UNSIGNED_INT, mesh->triangles);
+		glDrawElements(GL_TRIANGLES, numIndices, indexType, indices);
 		CHECK_GL_ERROR();
 	}
 }
@@ -189,7 +189,7 @@ QD3DSetupInputType		viewDef;
 
 		/* LOAD AUDIO */
 
-	LoadSoundBank(SOUNDBANK_MAIN);
+	LoadResidentSoundBank(SOUNDBANK_MAIN);
 }
 
 
@@ -224,7 +224,7 @@ TQ3Vector3D				fillDirection2 = { -.7, -.2, -.9 };			// fill
 
 			/* LOAD SOUNDS */
 
-	LoadSoundBank(SOUNDBANK_MAIN);
+	LoadResidentSoundBank(SOUNDBANK_MAIN);
 
 
 			/*************/
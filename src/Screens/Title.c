@@ -141,15 +141,15 @@ Byte					letters[] = {TITLE_MObjType_B, TITLE_MObjType_U,
 
 	InitParticleSystem();		// Must be once we have a valid GL context
 
-	LoadASkeleton(SKELETON_TYPE_ME);
+	LoadResidentSkeleton(SKELETON_TYPE_ME);
 	LoadASkeleton(SKELETON_TYPE_FIREANT);
-	LoadASkeleton(SKELETON_TYPE_LADYBUG);
+	LoadResidentSkeleton(SKELETON_TYPE_LADYBUG);
  
 	FSMakeFSSpec(gDataSpec.vRefNum, gDataSpec.parID, ":Models:Title.3dmf", &spec);
 	LoadGrouped3DMF(&spec,MODEL_GROUP_LEVELINTRO);	
 
 	FSMakeFSSpec(gDataSpec.vRefNum, gDataSpec.parID, ":Models:Global_Models1.3dmf", &spec);
-	LoadGrouped3DMF(&spec,MODEL_GROUP_GLOBAL1);	
+	LoadResidentGrouped3DMF(&spec,MODEL_GROUP_GLOBAL1);	
 	
 
 			/*******************/
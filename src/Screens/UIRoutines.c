@@ -103,7 +103,7 @@ void SetupUIStuff(int backgroundType)
 
 	/* LOAD SOUNDS */
 
-	LoadSoundBank(SOUNDBANK_MAIN);
+	LoadResidentSoundBank(SOUNDBANK_MAIN);
 	LoadSoundBank(SOUNDBANK_BONUS);
 
 	/*******************/
@@ -65,7 +65,7 @@ const JointKeyframeType	*kfPtr;
 																						matrix2.value[2][2] = kfPtr->scale.z;
 		matrix2.value[3][0] = kfPtr->coord.x;	matrix2.value[3][1] = kfPtr->coord.y;	matrix2.value[3][2] = kfPtr->coord.z;
 		
-		MatrixMultiplyFast(&matrix1,&matrix2,destMatPtr);		
+		MatrixMultiplyAffine(&matrix1,&matrix2,destMatPtr);		
 	}
 	else
 	{
@@ -154,7 +154,7 @@ BoneDefinitionType	*bonePtr;
 	{
 		jointNum = bonePtr[jointNum].parentBone;
 		
-  		MatrixMultiply(outMatrix,&skeletonPtr->jointTransformMatrix[jointNum],outMatrix);				
+  		MatrixMultiplyAffine(outMatrix,&skeletonPtr->jointTransformMatrix[jointNum],outMatrix);				
 	}
 	
 			/* ALSO FACTOR IN THE BASE MATRIX */
@@ -162,7 +162,7 @@ BoneDefinitionType	*bonePtr;
 			// Caller should make sure this is up to date!
 			//
 
-	MatrixMultiply(outMatrix,&theNode->BaseTransformMatrix,outMatrix);
+	MatrixMultiplyAffine(outMatrix,&theNode->BaseTransformMatrix,outMatrix);
 }
 
 
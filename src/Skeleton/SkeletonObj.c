@@ -18,6 +18,7 @@
 
 static SkeletonObjDataType *MakeNewSkeletonBaseData(short sourceSkeletonNum);
 static void DisposeSkeletonDefinitionMemory(SkeletonDefType *skeleton);
+static void DisposeResidentSkeleton(void* payload);
 
 
 /****************************/
@@ -31,6 +32,7 @@ static void DisposeSkeletonDefinitionMemory(SkeletonDefType *skeleton);
 
 static SkeletonDefType		*gLoadedSkeletonsList[MAX_SKELETON_TYPES];
 static TQ3BoundingSphere	gSkeletonBoundingSpheres[MAX_SKELETON_TYPES];
+static Boolean				gSkeletonIsResident[MAX_SKELETON_TYPES];		// true if borrowed from the resident asset cache
 
 
 
@@ -41,6 +43,7 @@ void InitSkeletonManager(void)
 	CalcAccelerationSplineCurve();									// calc accel curve
 
 	memset(gLoadedSkeletonsList, 0, sizeof(gLoadedSkeletonsList));
+	memset(gSkeletonIsResident, 0, sizeof(gSkeletonIsResident));
 }
 
 
@@ -72,6 +75,37 @@ void LoadASkeleton(Byte num)
 }
 
 
+/******************** LOAD RESIDENT SKELETON ****************************/
+//
+// Same as LoadASkeleton, but the skeleton definition is kept in the resident
+// asset cache when freed, so it survives level transitions.
+//
+
+void LoadResidentSkeleton(Byte num)
+{
+char	key[MAX_RESIDENT_KEY_LENGTH];
+
+	GAME_ASSERT(num < MAX_SKELETON_TYPES);
+
+	if (gLoadedSkeletonsList[num] == nil)
+	{
+		snprintf(key, sizeof(key), "Skeleton:%d", num);
+
+		SkeletonDefType* skeleton = AcquireResidentAsset(key);
+		if (!skeleton)
+		{
+			long heapBefore = Pomme_GetHeapSize();
+			skeleton = LoadSkeletonFile(num);
+			InsertResidentAsset(key, skeleton, (long) Pomme_GetHeapSize() - heapBefore, DisposeResidentSkeleton);
+		}
+
+		gLoadedSkeletonsList[num] = skeleton;
+		gSkeletonIsResident[num] = true;
+	}
+
+	LoadASkeleton(num);										// calc bounding sphere, etc.
+}
+
 
 /****************** FREE SKELETON FILE **************************/
 //
@@ -82,12 +116,28 @@ void FreeSkeletonFile(Byte skeletonType)
 {
 	if (gLoadedSkeletonsList[skeletonType])										// make sure this really exists
 	{
-		DisposeSkeletonDefinitionMemory(gLoadedSkeletonsList[skeletonType]);	// free skeleton data
+		if (gSkeletonIsResident[skeletonType])									// borrowed from resident cache: hand it back
+			ReleaseResidentAsset(gLoadedSkeletonsList[skeletonType]);
+		else
+			DisposeSkeletonDefinitionMemory(gLoadedSkeletonsList[skeletonType]);	// free skeleton data
+
 		gLoadedSkeletonsList[skeletonType] = nil;
+		gSkeletonIsResident[skeletonType] = false;
 	}
 }
 
 
+/****************** DISPOSE RESIDENT SKELETON **************************/
+//
+// Called by the resident asset cache when it evicts a skeleton.
+//
+
+static void DisposeResidentSkeleton(void* payload)
+{
+	DisposeSkeletonDefinitionMemory((SkeletonDefType*) payload);
+}
+
+
 /*************** FREE ALL SKELETON FILES ***************************/
 //
 // Free's all except for the input type (-1 == none to skip)
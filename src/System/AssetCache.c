@@ -0,0 +1,201 @@
+// ASSETCACHE.C
+// Resident assets shared across levels. See assetcache.h.
+
+#include "game.h"
+
+typedef struct
+{
+	bool						inUse;
+	char						key[MAX_RESIDENT_KEY_LENGTH];
+	void*						payload;
+	long						bytes;
+	int							refCount;
+	uint32_t					lruStamp;
+	ResidentAssetDisposeProc	disposeProc;
+} ResidentAsset;
+
+static ResidentAsset	gResidentAssets[MAX_RESIDENT_ASSETS];
+static uint32_t			gResidentLRUClock = 0;
+
+long					gResidentAssetBytes = 0;
+int						gNumResidentAssets = 0;
+int						gNumParkedResidentAssets = 0;
+
+
+/******************** FIND RESIDENT ASSET ************************/
+
+static ResidentAsset* FindResidentAssetByKey(const char* key)
+{
+	for (int i = 0; i < MAX_RESIDENT_ASSETS; i++)
+	{
+		if (gResidentAssets[i].inUse && 0 == strncmp(gResidentAssets[i].key, key, sizeof(gResidentAssets[i].key)))
+			return &gResidentAssets[i];
+	}
+	return NULL;
+}
+
+static ResidentAsset* FindResidentAssetByPayload(const void* payload)
+{
+	for (int i = 0; i < MAX_RESIDENT_ASSETS; i++)
+	{
+		if (gResidentAssets[i].inUse && gResidentAssets[i].payload == payload)
+			return &gResidentAssets[i];
+	}
+	return NULL;
+}
+
+static ResidentAsset* FindFreeResidentAsset(void)
+{
+	for (int i = 0; i < MAX_RESIDENT_ASSETS; i++)
+	{
+		if (!gResidentAssets[i].inUse)
+			return &gResidentAssets[i];
+	}
+	return NULL;
+}
+
+
+/******************** EVICT RESIDENT ASSET ************************/
+
+static void EvictResidentAsset(ResidentAsset* asset)
+{
+	GAME_ASSERT(asset->inUse);
+	GAME_ASSERT(asset->refCount == 0);
+
+	if (asset->disposeProc)
+		asset->disposeProc(asset->payload);
+
+	gResidentAssetBytes -= asset->bytes;
+	gNumResidentAssets--;
+	gNumParkedResidentAssets--;
+
+	memset(asset, 0, sizeof(*asset));
+}
+
+static ResidentAsset* FindLeastRecentlyUsedParkedAsset(void)
+{
+	ResidentAsset* victim = NULL;
+
+	for (int i = 0; i < MAX_RESIDENT_ASSETS; i++)
+	{
+		ResidentAsset* asset = &gResidentAssets[i];
+		if (asset->inUse && asset->refCount == 0
+			&& (!victim || asset->lruStamp < victim->lruStamp))
+		{
+			victim = asset;
+		}
+	}
+
+	return victim;
+}
+
+//
+// Evicts parked assets, oldest first, until we're back under budget
+// (or until there's nothing left to evict).
+//
+
+static void TrimResidentAssets(long budget)
+{
+	while (gResidentAssetBytes > budget)
+	{
+		ResidentAsset* victim = FindLeastRecentlyUsedParkedAsset();
+
+		if (!victim)									// everything left is in use
+			break;
+
+		EvictResidentAsset(victim);
+	}
+}
+
+
+#pragma mark -
+
+/******************** ACQUIRE RESIDENT ASSET ************************/
+
+void* AcquireResidentAsset(const char* key)
+{
+	ResidentAsset* asset = FindResidentAssetByKey(key);
+	if (!asset)
+		return NULL;
+
+	if (asset->refCount == 0)
+		gNumParkedResidentAssets--;
+
+	asset->refCount++;
+	asset->lruStamp = ++gResidentLRUClock;
+	return asset->payload;
+}
+
+
+/******************** INSERT RESIDENT ASSET ************************/
+
+void InsertResidentAsset(const char* key, void* payload, long bytes, ResidentAssetDisposeProc disposeProc)
+{
+	GAME_ASSERT(payload);
+	GAME_ASSERT(strlen(key) < MAX_RESIDENT_KEY_LENGTH);
+	GAME_ASSERT_MESSAGE(!FindResidentAssetByKey(key), key);
+
+	if (bytes < 0)										// heap may have been compacted during the load
+		bytes = 0;
+
+			/* MAKE ROOM FOR THE NEW ASSET */
+
+	TrimResidentAssets(RESIDENT_ASSET_BUDGET - bytes);
+
+	ResidentAsset* asset = FindFreeResidentAsset();
+
+	if (!asset)											// table full: throw out the oldest parked asset
+	{
+		ResidentAsset* victim = FindLeastRecentlyUsedParkedAsset();
+		if (victim)
+		{
+			EvictResidentAsset(victim);
+			asset = FindFreeResidentAsset();
+		}
+	}
+
+	GAME_ASSERT_MESSAGE(asset, "Too many resident assets in use");
+
+	snprintf(asset->key, sizeof(asset->key), "%s", key);
+	asset->inUse		= true;
+	asset->payload		= payload;
+	asset->bytes		= bytes;
+	asset->refCount		= 1;
+	asset->lruStamp		= ++gResidentLRUClock;
+	asset->disposeProc	= disposeProc;
+
+	gResidentAssetBytes += bytes;
+	gNumResidentAssets++;
+}
+
+
+/******************** RELEASE RESIDENT ASSET ************************/
+
+void ReleaseResidentAsset(void* payload)
+{
+	ResidentAsset* asset = FindResidentAssetByPayload(payload);
+	GAME_ASSERT_MESSAGE(asset, "Releasing an asset that isn't resident");
+	GAME_ASSERT(asset->refCount > 0);
+
+	asset->refCount--;
+	asset->lruStamp = ++gResidentLRUClock;
+
+	if (asset->refCount == 0)
+	{
+		gNumParkedResidentAssets++;
+		TrimResidentAssets(RESIDENT_ASSET_BUDGET);
+	}
+}
+
+
+/******************** PURGE RESIDENT ASSETS ************************/
+
+void PurgeResidentAssets(void)
+{
+	for (int i = 0; i < MAX_RESIDENT_ASSETS; i++)
+	{
+		ResidentAsset* asset = &gResidentAssets[i];
+		if (asset->inUse && asset->refCount == 0)
+			EvictResidentAsset(asset);
+	}
+}
@@ -779,6 +779,7 @@ short	fRefNum;
 			/* PRECALC THE TILE SPLIT MODE MATRIX */
 			
 	CalculateSplitModeMatrix();
+	BuildTerrainPlaneTable();
 
 		
 	BuildTerrainItemList();	
@@ -1154,15 +1155,15 @@ FSSpec	spec;
 			/* LOAD GLOBAL STUFF */
 
 	FSMakeFSSpec(gDataSpec.vRefNum, gDataSpec.parID, ":Models:Global_Models1.3dmf", &spec);
-	LoadGrouped3DMF(&spec,MODEL_GROUP_GLOBAL1);	
+	LoadResidentGrouped3DMF(&spec,MODEL_GROUP_GLOBAL1);	
 	FSMakeFSSpec(gDataSpec.vRefNum, gDataSpec.parID, ":Models:Global_Models2.3dmf", &spec);
-	LoadGrouped3DMF(&spec,MODEL_GROUP_GLOBAL2);	
+	LoadResidentGrouped3DMF(&spec,MODEL_GROUP_GLOBAL2);	
 
-	LoadSoundBank(SOUNDBANK_MAIN);
+	LoadResidentSoundBank(SOUNDBANK_MAIN);
 
-	LoadASkeleton(SKELETON_TYPE_ME);			
-	LoadASkeleton(SKELETON_TYPE_LADYBUG);			
-	LoadASkeleton(SKELETON_TYPE_BUDDY);			
+	LoadResidentSkeleton(SKELETON_TYPE_ME);			
+	LoadResidentSkeleton(SKELETON_TYPE_LADYBUG);			
+	LoadResidentSkeleton(SKELETON_TYPE_BUDDY);			
 	
 			/*****************************/
 			/* LOAD LEVEL SPECIFIC STUFF */
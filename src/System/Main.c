@@ -113,14 +113,17 @@ static const bool	gLevelHasCeiling[NUM_LEVEL_TYPES] =
 	true						// anthill
 };
 
+		// Each range is one more than the original game's: distant supertiles are drawn
+		// with a decimated mesh (see DrawTerrain), so the wider view costs no more triangles.
+
 static const Byte	gLevelSuperTileActiveRange[NUM_LEVEL_TYPES] =
 {
-	5,						// garden
-	4,						// boat
-	5,						// dragonfly
-	4,						// hive
-	4,						// night
-	4						// anthill
+	6,						// garden
+	5,						// boat
+	6,						// dragonfly
+	5,						// hive
+	5,						// night
+	5						// anthill
 };
 
 static const float	gLevelFogStart[NUM_LEVEL_TYPES] =
@@ -146,11 +149,11 @@ static const float	gLevelFogEnd[NUM_LEVEL_TYPES] =
 
 static const float	gLevelAutoFadeStart[NUM_LEVEL_TYPES] =
 {
-	YON_DISTANCE+400,		// garden
+	YON_DISTANCE+1200,		// garden (same distance from the yon plane as the original game's)
 	0,						// boat
 	0,						// dragonfly
 	0,						// hive
-	YON_DISTANCE-250,		// night
+	YON_DISTANCE+1450,		// night
 	0,						// anthill
 };
 
@@ -382,6 +385,7 @@ float fps;
 		MoveSplineObjects();
 		QD3D_MoveShards();
 		MoveParticleGroups();
+		MoveRipples();
 		UpdateCamera();
 	
 			/* DRAW OBJECTS & TERRAIN */
@@ -473,15 +477,21 @@ QD3DSetupInputType	viewDef;
 	gBestCheckPoint			= -1;								// no checkpoint yet
 
 		
-	if (gSuperTileActiveRange == 5)								// set yon clipping value
+	switch(gSuperTileActiveRange)								// set yon clipping value
 	{
-		gCurrentYon = YON_DISTANCE + 1700;
-		gCycScale = 81;
-	}
-	else
-	{
-		gCurrentYon = YON_DISTANCE;
-		gCycScale = 50;
+		case	6:
+				gCurrentYon = YON_DISTANCE + 2500;
+				gCycScale = 97;
+				break;
+
+		case	5:
+				gCurrentYon = YON_DISTANCE + 1700;
+				gCycScale = 81;
+				break;
+
+		default:
+				gCurrentYon = YON_DISTANCE;
+				gCycScale = 50;
 	}
 
 
@@ -739,6 +749,9 @@ static void CheckForCheats(void)
 		if (GetKeyState_SDL(SDL_SCANCODE_F7))		// hurt player
 			PlayerGotHurt(NULL, 1/60.0f, 1.0f, false, true, 1/60.0f);
 
+		if (GetNewKeyState_SDL(SDL_SCANCODE_F9) && gPlayerObj)	// particle stress test
+			StressTestParticleGroups(&gPlayerObj->Coord);
+
 	}
 }
 
@@ -91,6 +91,7 @@ static Boolean beenHere = false;
 		DeleteAllObjects();
 		DeleteAll3DMFGroups();
 		FreeAllSkeletonFiles(-1);
+		PurgeResidentAssets();
 		QD3D_DisposeShards();
 
 		if (gGameViewInfoPtr != nil)                // see if nuke an existing draw context
@@ -103,6 +104,7 @@ static Boolean beenHere = false;
 
 	StopAllEffectChannels();
 	KillSong();
+	ShutdownMusicStream();
 
 	SDL_ShowCursor(1);
 	Pomme_FlushPtrTracking(false);
@@ -193,6 +195,30 @@ void Free2DArray(void** array)
 
 
 
+#pragma mark -
+
+/****************** PROFILING TIMESTAMPS ********************/
+
+uint64_t GetProfilingTimestamp(void)
+{
+	return SDL_GetPerformanceCounter();
+}
+
+
+float GetMillisecondsSince(uint64_t timestamp)
+{
+	static uint64_t performanceFrequency = 0;
+
+	if (performanceFrequency == 0)
+		performanceFrequency = SDL_GetPerformanceFrequency();
+
+	uint64_t elapsed = SDL_GetPerformanceCounter() - timestamp;
+	return (float)(1000.0 * (double)elapsed / (double)performanceFrequency);
+}
+
+
+
+
 #pragma mark -
 
 
@@ -0,0 +1,809 @@
+// MUSICSTREAM.C
+// Streams songs from disk on a background thread. See musicstream.h.
+
+#include "game.h"
+
+
+/****************************/
+/*    CONSTANTS             */
+/****************************/
+
+#define	MUSIC_OUTPUT_RATE			44100
+#define	MUSIC_RING_FRAMES			8192				// must be a power of two; ~190ms of audio
+#define	MUSIC_CHUNK_FRAMES			512					// frames rendered per pass of the streamer thread
+#define	MUSIC_BLOCK_FRAMES			1024				// frames decoded per disk read
+#define	MUSIC_MAX_DECODERS			3					// incoming song + up to 2 songs fading out
+#define	MUSIC_THREAD_WAKE_MS		10
+
+#define	IMA4_PACKET_BYTES			34
+#define	IMA4_PACKET_FRAMES			64
+#define	IMA4_PACKETS_PER_BLOCK		(MUSIC_BLOCK_FRAMES / IMA4_PACKET_FRAMES)
+
+#define	FOURCC(a,b,c,d)				(((uint32_t)(a)<<24) | ((uint32_t)(b)<<16) | ((uint32_t)(c)<<8) | (uint32_t)(d))
+
+enum
+{
+	MUSIC_COMMAND_NONE,
+	MUSIC_COMMAND_PLAY,
+	MUSIC_COMMAND_STOP,
+};
+
+typedef struct
+{
+	int			type;
+	char		path[1024];							// host path, resolved by MusicStream_Play
+	bool		loop;
+	int			fadeFrames;
+	int			serial;
+} MusicCommand;
+
+typedef struct
+{
+	bool		active;
+	SDL_RWops*	file;
+
+			/* FORMAT */
+
+	uint32_t	compression;
+	int			numChannels;
+	int			bytesPerSample;
+	Sint64		dataStart;
+	uint32_t	numUnits;								// sample frames, or packets for IMA4
+	uint32_t	unitsLeft;
+	bool		loop;
+
+			/* DECODED BLOCK AT SOURCE RATE */
+
+	int16_t		block[MUSIC_BLOCK_FRAMES * 2];
+	int			blockFrames;
+	int			blockPos;
+
+			/* LINEAR RESAMPLER */
+
+	float		step;									// source frames per output frame
+	float		phase;
+	float		frameA[2];
+	float		frameB[2];
+
+			/* GAIN ENVELOPE */
+
+	float		gain;
+	float		gainStep;
+	int			fadeFramesLeft;
+	bool		closeWhenFaded;
+} MusicDecoder;
+
+
+/*********************/
+/*    VARIABLES      */
+/*********************/
+
+static	SDL_AudioDeviceID	gMusicDevice = 0;
+static	SDL_Thread*			gMusicThread = NULL;
+static	SDL_sem*			gMusicWakeSem = NULL;
+static	SDL_mutex*			gMusicCommandMutex = NULL;
+static	SDL_atomic_t		gMusicQuit;
+
+		/* RING BUFFER: written by the streamer thread only, read by the audio callback only */
+
+static	int16_t				gMusicRing[MUSIC_RING_FRAMES * 2];
+static	SDL_atomic_t		gMusicRingRead;						// total frames consumed (wraps)
+static	SDL_atomic_t		gMusicRingWrite;					// total frames produced (wraps)
+
+		/* SHARED WITH MAIN THREAD */
+
+static	SDL_atomic_t		gMusicVolumeQ16;					// volume in 16.16 fixed point
+static	SDL_atomic_t		gMusicPaused;
+static	SDL_atomic_t		gMusicRequestSerial;
+static	SDL_atomic_t		gMusicFinishedSerial;
+static	MusicCommand		gPendingMusicCommand;				// guarded by gMusicCommandMutex
+
+		/* STREAMER THREAD ONLY */
+
+static	MusicDecoder		gMusicDecoders[MUSIC_MAX_DECODERS];
+static	int					gMusicLastSerial = 0;
+
+static const int kIMAIndexTable[16] =
+{
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int kIMAStepTable[89] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+	12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+
+#pragma mark -
+
+/****************** BIG-ENDIAN HELPERS *********************/
+
+static uint32_t ReadU32BE(const uint8_t* p)	{ return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+static uint16_t ReadU16BE(const uint8_t* p)	{ return (uint16_t) ((p[0] << 8) | p[1]); }
+
+//
+// Converts an 80-bit IEEE 754 extended float (as found in AIFF COMM chunks) to double.
+//
+
+static double ReadExtended80(const uint8_t* p)
+{
+	int exponent = ((p[0] & 0x7F) << 8) | p[1];
+	uint64_t mantissa = ((uint64_t) ReadU32BE(p+2) << 32) | ReadU32BE(p+6);
+
+	if (exponent == 0 && mantissa == 0)
+		return 0;
+
+	double value = ldexp((double) mantissa, exponent - 16383 - 63);
+	return (p[0] & 0x80) ? -value : value;
+}
+
+
+/****************** OPEN MUSIC FILE *********************/
+//
+// Parses an AIFF/AIFF-C header and leaves the file positioned at the start of the sound data.
+//
+
+static bool OpenMusicDecoder(MusicDecoder* dec, const char* hostPath, bool loop)
+{
+uint8_t		header[38];
+bool		isAIFC = false;
+bool		gotCOMM = false;
+double		sampleRate = 0;
+
+	memset(dec, 0, sizeof(*dec));
+
+	dec->file = SDL_RWFromFile(hostPath, "rb");
+	if (!dec->file)
+	{
+		SDL_Log("%s: can't open %s\n", __func__, hostPath);
+		return false;
+	}
+
+			/* FORM HEADER */
+
+	if (12 != SDL_RWread(dec->file, header, 1, 12)
+		|| ReadU32BE(header) != FOURCC('F','O','R','M'))
+	{
+		goto bail;
+	}
+
+	switch (ReadU32BE(header+8))
+	{
+		case FOURCC('A','I','F','F'):	isAIFC = false;		break;
+		case FOURCC('A','I','F','C'):	isAIFC = true;		break;
+		default:						goto bail;
+	}
+
+	dec->compression = FOURCC('N','O','N','E');
+
+			/* SCAN CHUNKS */
+
+	while (8 == SDL_RWread(dec->file, header, 1, 8))
+	{
+		uint32_t chunkID = ReadU32BE(header);
+		uint32_t chunkSize = ReadU32BE(header+4);
+		Sint64 chunkStart = SDL_RWtell(dec->file);
+
+		if (chunkID == FOURCC('C','O','M','M'))
+		{
+			int commSize = isAIFC ? 22 : 18;
+			if (chunkSize < (uint32_t) commSize || commSize != (int) SDL_RWread(dec->file, header, 1, commSize))
+				goto bail;
+
+			dec->numChannels	= ReadU16BE(header);
+			dec->numUnits		= ReadU32BE(header+2);
+			dec->bytesPerSample	= (ReadU16BE(header+6) + 7) / 8;
+			sampleRate			= ReadExtended80(header+8);
+			if (isAIFC)
+				dec->compression = ReadU32BE(header+18);
+			gotCOMM = true;
+		}
+		else if (chunkID == FOURCC('S','S','N','D'))
+		{
+			if (!gotCOMM || 8 != SDL_RWread(dec->file, header, 1, 8))
+				goto bail;
+
+			dec->dataStart = chunkStart + 8 + ReadU32BE(header);		// skip offset field
+			break;
+		}
+
+		SDL_RWseek(dec->file, chunkStart + chunkSize + (chunkSize & 1), RW_SEEK_SET);
+	}
+
+			/* VALIDATE FORMAT */
+
+	if (!dec->dataStart || dec->numChannels < 1 || dec->numChannels > 2 || sampleRate <= 0)
+		goto bail;
+
+	switch (dec->compression)
+	{
+		case FOURCC('N','O','N','E'):
+		case FOURCC('t','w','o','s'):
+		case FOURCC('s','o','w','t'):
+			if (dec->bytesPerSample < 1 || dec->bytesPerSample > 2)
+				goto bail;
+			break;
+
+		case FOURCC('i','m','a','4'):
+			break;
+
+		default:
+			SDL_Log("%s: unsupported compression in %s\n", __func__, hostPath);
+			goto bail;
+	}
+
+	SDL_RWseek(dec->file, dec->dataStart, RW_SEEK_SET);
+
+	dec->unitsLeft	= dec->numUnits;
+	dec->loop		= loop;
+	dec->step		= (float) (sampleRate / MUSIC_OUTPUT_RATE);
+	dec->phase		= 1.0f;									// pull in the first source frame on the first output
+	dec->active		= true;
+	return true;
+
+bail:
+	SDL_Log("%s: bad AIFF file %s\n", __func__, hostPath);
+	SDL_RWclose(dec->file);
+	dec->file = NULL;
+	return false;
+}
+
+
+/****************** CLOSE MUSIC DECODER *********************/
+
+static void CloseMusicDecoder(MusicDecoder* dec)
+{
+	if (dec->file)
+		SDL_RWclose(dec->file);
+
+	dec->file = NULL;
+	dec->active = false;
+}
+
+
+#pragma mark -
+
+/****************** DECODE IMA4 PACKET *********************/
+
+//
+// Each AIFF-C IMA4 packet is self-contained: a 2-byte header with the initial predictor
+// and step index, followed by 64 4-bit samples.
+//
+
+static void DecodeIMA4Packet(const uint8_t* packet, int16_t* out, int outStride)
+{
+	uint16_t header = ReadU16BE(packet);
+	int predictor = (int16_t) (header & 0xFF80);
+	int stepIndex = header & 0x7F;
+	if (stepIndex > 88)
+		stepIndex = 88;
+
+	for (int i = 0; i < IMA4_PACKET_FRAMES; i++)
+	{
+		int nibble = (packet[2 + i/2] >> ((i & 1) ? 4 : 0)) & 0xF;		// low nibble first
+		int step = kIMAStepTable[stepIndex];
+
+		int diff = step >> 3;
+		if (nibble & 4) diff += step;
+		if (nibble & 2) diff += step >> 1;
+		if (nibble & 1) diff += step >> 2;
+
+		predictor += (nibble & 8) ? -diff : diff;
+		if (predictor > 32767) predictor = 32767;
+		else if (predictor < -32768) predictor = -32768;
+
+		stepIndex += kIMAIndexTable[nibble];
+		if (stepIndex < 0) stepIndex = 0;
+		else if (stepIndex > 88) stepIndex = 88;
+
+		out[i * outStride] = (int16_t) predictor;
+	}
+}
+
+
+/****************** DECODE NEXT BLOCK *********************/
+//
+// Reads and decodes the next block of source frames into dec->block (always stereo).
+// Wraps around to the start of the sound data if the song loops.
+// Returns false at the end of a non-looping song.
+//
+
+static bool DecodeNextMusicBlock(MusicDecoder* dec)
+{
+uint8_t	raw[MUSIC_BLOCK_FRAMES * 2 * 2 + 16];
+
+	if (dec->unitsLeft == 0)
+	{
+		if (!dec->loop)
+			return false;
+
+		SDL_RWseek(dec->file, dec->dataStart, RW_SEEK_SET);		// gapless loop: just rewind and keep decoding
+		dec->unitsLeft = dec->numUnits;
+	}
+
+	int nch = dec->numChannels;
+	int frames = 0;
+
+	if (dec->compression == FOURCC('i','m','a','4'))
+	{
+		uint32_t packets = dec->unitsLeft < IMA4_PACKETS_PER_BLOCK ? dec->unitsLeft : IMA4_PACKETS_PER_BLOCK;
+		size_t bytesPerPacketGroup = IMA4_PACKET_BYTES * nch;
+		size_t got = SDL_RWread(dec->file, raw, bytesPerPacketGroup, packets);
+
+		for (size_t p = 0; p < got; p++)
+		{
+			for (int c = 0; c < nch; c++)
+			{
+				const uint8_t* packet = raw + p * bytesPerPacketGroup + c * IMA4_PACKET_BYTES;
+				DecodeIMA4Packet(packet, &dec->block[p * IMA4_PACKET_FRAMES * 2 + c], 2);
+			}
+		}
+
+		frames = (int) got * IMA4_PACKET_FRAMES;
+		dec->unitsLeft = (got == packets) ? dec->unitsLeft - packets : 0;
+	}
+	else
+	{
+		uint32_t want = dec->unitsLeft < MUSIC_BLOCK_FRAMES ? dec->unitsLeft : MUSIC_BLOCK_FRAMES;
+		size_t bytesPerFrame = dec->bytesPerSample * nch;
+		size_t got = SDL_RWread(dec->file, raw, bytesPerFrame, want);
+		bool littleEndian = dec->compression == FOURCC('s','o','w','t');
+
+		for (size_t i = 0; i < got * nch; i++)
+		{
+			const uint8_t* s = raw + i * dec->bytesPerSample;
+			int16_t v;
+
+			if (dec->bytesPerSample == 1)
+				v = (int16_t) ((int8_t) s[0] << 8);
+			else if (littleEndian)
+				v = (int16_t) (s[0] | (s[1] << 8));
+			else
+				v = (int16_t) ((s[0] << 8) | s[1]);
+
+			if (nch == 2)
+				dec->block[i] = v;
+			else
+				dec->block[i*2] = v;
+		}
+
+		frames = (int) got;
+		dec->unitsLeft = (got == want) ? dec->unitsLeft - want : 0;
+	}
+
+			/* UPMIX MONO */
+
+	if (nch == 1)
+	{
+		for (int i = 0; i < frames; i++)
+			dec->block[i*2+1] = dec->block[i*2];
+	}
+
+	dec->blockFrames = frames;
+	dec->blockPos = 0;
+
+	return frames != 0;										// 0 frames: file is truncated
+}
+
+
+/****************** PULL SOURCE FRAME *********************/
+
+static bool PullSourceFrame(MusicDecoder* dec, float* out)
+{
+	if (dec->blockPos >= dec->blockFrames)
+	{
+		if (!DecodeNextMusicBlock(dec))
+			return false;
+	}
+
+	out[0] = dec->block[dec->blockPos*2 + 0];
+	out[1] = dec->block[dec->blockPos*2 + 1];
+	dec->blockPos++;
+	return true;
+}
+
+
+/****************** PULL RESAMPLED FRAME *********************/
+//
+// Linear interpolation between source frames A and B.
+//
+
+static bool PullResampledFrame(MusicDecoder* dec, float* out)
+{
+	while (dec->phase >= 1.0f)
+	{
+		dec->phase -= 1.0f;
+		dec->frameA[0] = dec->frameB[0];
+		dec->frameA[1] = dec->frameB[1];
+		if (!PullSourceFrame(dec, dec->frameB))
+			return false;
+	}
+
+	out[0] = dec->frameA[0] + (dec->frameB[0] - dec->frameA[0]) * dec->phase;
+	out[1] = dec->frameA[1] + (dec->frameB[1] - dec->frameA[1]) * dec->phase;
+	dec->phase += dec->step;
+	return true;
+}
+
+
+#pragma mark -
+
+/****************** START FADE *********************/
+
+static void StartMusicFade(MusicDecoder* dec, float targetGain, int frames, bool closeWhenFaded)
+{
+	if (frames < 1)
+		frames = 1;
+
+	dec->gainStep = (targetGain - dec->gain) / frames;
+	dec->fadeFramesLeft = frames;
+	dec->closeWhenFaded = closeWhenFaded;
+}
+
+
+/****************** PROCESS MUSIC COMMAND *********************/
+
+static void ProcessMusicCommand(void)
+{
+MusicCommand	command;
+
+	SDL_LockMutex(gMusicCommandMutex);
+	command = gPendingMusicCommand;
+	gPendingMusicCommand.type = MUSIC_COMMAND_NONE;
+	SDL_UnlockMutex(gMusicCommandMutex);
+
+	if (command.type == MUSIC_COMMAND_NONE)
+		return;
+
+	gMusicLastSerial = command.serial;
+
+			/* FADE OUT EVERYTHING THAT'S PLAYING */
+
+	int declickFrames = MUSIC_DECLICK_MS * MUSIC_OUTPUT_RATE / 1000;
+	int fadeOutFrames = command.fadeFrames > declickFrames ? command.fadeFrames : declickFrames;
+
+	for (int i = 0; i < MUSIC_MAX_DECODERS; i++)
+	{
+		MusicDecoder* dec = &gMusicDecoders[i];
+		if (dec->active && !dec->closeWhenFaded)
+			StartMusicFade(dec, 0, fadeOutFrames, true);
+	}
+
+	if (command.type != MUSIC_COMMAND_PLAY)
+		return;
+
+			/* FIND A FREE SLOT FOR THE NEW SONG */
+			// If all slots are taken by songs fading out, cut the quietest one.
+
+	MusicDecoder* slot = NULL;
+	for (int i = 0; i < MUSIC_MAX_DECODERS; i++)
+	{
+		MusicDecoder* dec = &gMusicDecoders[i];
+		if (!dec->active)
+		{
+			slot = dec;
+			break;
+		}
+		if (!slot || dec->gain < slot->gain)
+			slot = dec;
+	}
+
+	CloseMusicDecoder(slot);
+
+	if (!OpenMusicDecoder(slot, command.path, command.loop))
+		return;
+
+	if (command.fadeFrames > 0)
+	{
+		slot->gain = 0;
+		StartMusicFade(slot, 1, command.fadeFrames, false);
+	}
+	else
+	{
+		slot->gain = 1;
+	}
+}
+
+
+/****************** RENDER MUSIC CHUNK *********************/
+//
+// Mixes all active decoders into the ring buffer.
+// Returns false if there was nothing to render.
+//
+
+static bool RenderMusicChunk(uint32_t writePos)
+{
+float	mix[MUSIC_CHUNK_FRAMES * 2];
+bool	anyActive = false;
+
+	memset(mix, 0, sizeof(mix));
+
+	for (int d = 0; d < MUSIC_MAX_DECODERS; d++)
+	{
+		MusicDecoder* dec = &gMusicDecoders[d];
+		if (!dec->active)
+			continue;
+
+		anyActive = true;
+
+		for (int i = 0; i < MUSIC_CHUNK_FRAMES; i++)
+		{
+			float frame[2];
+			if (!PullResampledFrame(dec, frame))			// song over
+			{
+				CloseMusicDecoder(dec);
+				break;
+			}
+
+			mix[i*2+0] += frame[0] * dec->gain;
+			mix[i*2+1] += frame[1] * dec->gain;
+
+			if (dec->fadeFramesLeft > 0)
+			{
+				dec->gain += dec->gainStep;
+				if (--dec->fadeFramesLeft == 0)
+				{
+					dec->gain = roundf(dec->gain);			// land exactly on 0 or 1
+					if (dec->closeWhenFaded)
+					{
+						CloseMusicDecoder(dec);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	if (!anyActive)
+		return false;
+
+			/* CLAMP INTO RING */
+
+	for (int i = 0; i < MUSIC_CHUNK_FRAMES; i++)
+	{
+		int slot = (int) ((writePos + i) & (MUSIC_RING_FRAMES - 1));
+		for (int c = 0; c < 2; c++)
+		{
+			float s = mix[i*2+c];
+			if (s > 32767.0f) s = 32767.0f;
+			else if (s < -32768.0f) s = -32768.0f;
+			gMusicRing[slot*2+c] = (int16_t) s;
+		}
+	}
+
+	return true;
+}
+
+
+/****************** MUSIC STREAMER THREAD *********************/
+
+static int MusicStreamerThread(void* unused)
+{
+	(void) unused;
+
+	while (!SDL_AtomicGet(&gMusicQuit))
+	{
+		SDL_SemWaitTimeout(gMusicWakeSem, MUSIC_THREAD_WAKE_MS);
+
+		ProcessMusicCommand();
+
+				/* FILL RING AHEAD OF THE CALLBACK */
+
+		uint32_t writePos = (uint32_t) SDL_AtomicGet(&gMusicRingWrite);
+		uint32_t readPos;
+
+		for (;;)
+		{
+			readPos = (uint32_t) SDL_AtomicGet(&gMusicRingRead);
+			SDL_MemoryBarrierAcquire();
+
+			if (MUSIC_RING_FRAMES - (writePos - readPos) < MUSIC_CHUNK_FRAMES)	// ring full
+				break;
+
+			if (!RenderMusicChunk(writePos))									// nothing to play
+				break;
+
+			writePos += MUSIC_CHUNK_FRAMES;
+			SDL_MemoryBarrierRelease();											// publish samples before index
+			SDL_AtomicSet(&gMusicRingWrite, (int) writePos);
+		}
+
+				/* SEE IF LAST SONG HAS COMPLETELY DRAINED */
+
+		bool anyActive = false;
+		for (int i = 0; i < MUSIC_MAX_DECODERS; i++)
+			anyActive |= gMusicDecoders[i].active;
+
+		if (!anyActive && readPos == writePos)
+			SDL_AtomicSet(&gMusicFinishedSerial, gMusicLastSerial);
+	}
+
+	for (int i = 0; i < MUSIC_MAX_DECODERS; i++)
+		CloseMusicDecoder(&gMusicDecoders[i]);
+
+	return 0;
+}
+
+
+/****************** MUSIC AUDIO CALLBACK *********************/
+//
+// Runs on SDL's audio thread. Never blocks.
+//
+
+static void MusicAudioCallback(void* userdata, Uint8* stream, int len)
+{
+	(void) userdata;
+
+	int16_t* out = (int16_t*) stream;
+	int framesWanted = len / (int) (2 * sizeof(int16_t));
+	int framesCopied = 0;
+
+	if (!SDL_AtomicGet(&gMusicPaused))
+	{
+		uint32_t readPos = (uint32_t) SDL_AtomicGet(&gMusicRingRead);
+		uint32_t writePos = (uint32_t) SDL_AtomicGet(&gMusicRingWrite);
+		SDL_MemoryBarrierAcquire();
+
+		uint32_t available = writePos - readPos;
+		framesCopied = (int) (available < (uint32_t) framesWanted ? available : (uint32_t) framesWanted);
+
+		int volume = SDL_AtomicGet(&gMusicVolumeQ16);
+
+		for (int i = 0; i < framesCopied; i++)
+		{
+			int slot = (int) ((readPos + i) & (MUSIC_RING_FRAMES - 1));
+			out[i*2+0] = (int16_t) ((gMusicRing[slot*2+0] * volume) >> 16);
+			out[i*2+1] = (int16_t) ((gMusicRing[slot*2+1] * volume) >> 16);
+		}
+
+		SDL_MemoryBarrierRelease();
+		SDL_AtomicSet(&gMusicRingRead, (int) (readPos + framesCopied));
+	}
+
+	memset(out + framesCopied * 2, 0, (framesWanted - framesCopied) * 2 * sizeof(int16_t));
+
+	SDL_SemPost(gMusicWakeSem);								// let the streamer refill
+}
+
+
+#pragma mark -
+
+/****************** INIT MUSIC STREAM *********************/
+
+void InitMusicStream(void)
+{
+SDL_AudioSpec	want;
+
+	SDL_AtomicSet(&gMusicQuit, 0);
+	SDL_AtomicSet(&gMusicPaused, 0);
+	SDL_AtomicSet(&gMusicRingRead, 0);
+	SDL_AtomicSet(&gMusicRingWrite, 0);
+	SDL_AtomicSet(&gMusicRequestSerial, 0);
+	SDL_AtomicSet(&gMusicFinishedSerial, 0);
+	MusicStream_SetVolume(1);
+
+	memset(gMusicDecoders, 0, sizeof(gMusicDecoders));
+	memset(&gPendingMusicCommand, 0, sizeof(gPendingMusicCommand));
+
+			/* OPEN A DEDICATED OUTPUT DEVICE (SDL CONVERTS TO THE HARDWARE FORMAT FOR US) */
+
+	SDL_zero(want);
+	want.freq		= MUSIC_OUTPUT_RATE;
+	want.format		= AUDIO_S16SYS;
+	want.channels	= 2;
+	want.samples	= 1024;
+	want.callback	= MusicAudioCallback;
+
+	gMusicDevice = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+	if (!gMusicDevice)
+	{
+		SDL_Log("%s: couldn't open audio device, music disabled: %s\n", __func__, SDL_GetError());
+		return;
+	}
+
+	gMusicWakeSem = SDL_CreateSemaphore(0);
+	gMusicCommandMutex = SDL_CreateMutex();
+	gMusicThread = SDL_CreateThread(MusicStreamerThread, "MusicStreamer", NULL);
+	GAME_ASSERT(gMusicWakeSem && gMusicCommandMutex && gMusicThread);
+
+	SDL_PauseAudioDevice(gMusicDevice, 0);
+}
+
+
+/****************** SHUTDOWN MUSIC STREAM *********************/
+
+void ShutdownMusicStream(void)
+{
+	if (!gMusicDevice)
+		return;
+
+	SDL_CloseAudioDevice(gMusicDevice);						// stops the callback
+	gMusicDevice = 0;
+
+	SDL_AtomicSet(&gMusicQuit, 1);
+	SDL_SemPost(gMusicWakeSem);
+	SDL_WaitThread(gMusicThread, NULL);
+	gMusicThread = NULL;
+
+	SDL_DestroySemaphore(gMusicWakeSem);
+	SDL_DestroyMutex(gMusicCommandMutex);
+	gMusicWakeSem = NULL;
+	gMusicCommandMutex = NULL;
+}
+
+
+/****************** POST MUSIC COMMAND *********************/
+//
+// Hands a command over to the streamer thread. A newer command replaces one that hasn't been picked up yet.
+//
+
+static void PostMusicCommand(int type, const char* path, bool loop, int fadeMS)
+{
+	int serial = SDL_AtomicAdd(&gMusicRequestSerial, 1) + 1;
+
+	if (!gMusicDevice)										// no audio: pretend it finished right away
+	{
+		SDL_AtomicSet(&gMusicFinishedSerial, serial);
+		return;
+	}
+
+	SDL_LockMutex(gMusicCommandMutex);
+	gPendingMusicCommand.type		= type;
+	gPendingMusicCommand.loop		= loop;
+	gPendingMusicCommand.fadeFrames	= fadeMS * MUSIC_OUTPUT_RATE / 1000;
+	gPendingMusicCommand.serial		= serial;
+	snprintf(gPendingMusicCommand.path, sizeof(gPendingMusicCommand.path), "%s", path ? path : "");
+	SDL_UnlockMutex(gMusicCommandMutex);
+
+	SDL_SemPost(gMusicWakeSem);
+}
+
+
+/****************** MUSIC STREAM API *********************/
+
+void MusicStream_Play(const char* path, bool loop, int crossfadeMS)
+{
+char	hostPath[sizeof(gPendingMusicCommand.path)];
+
+			/* CONVERT ":Audio:Song.aiff" TO A HOST PATH */
+			//
+			// Done here because the streamer thread can't use the Pomme file manager,
+			// which is what finds files regardless of their case on disk.
+			//
+
+	if (!ResolveDataHostPath(path, hostPath, sizeof(hostPath)))
+	{
+		SDL_Log("%s: can't find %s\n", __func__, path);
+		return;
+	}
+
+	PostMusicCommand(MUSIC_COMMAND_PLAY, hostPath, loop, crossfadeMS);
+}
+
+void MusicStream_Stop(int fadeOutMS)
+{
+	PostMusicCommand(MUSIC_COMMAND_STOP, NULL, false, fadeOutMS);
+}
+
+void MusicStream_SetVolume(float volume)
+{
+	if (volume < 0) volume = 0;
+	if (volume > 1) volume = 1;
+	SDL_AtomicSet(&gMusicVolumeQ16, (int) (volume * 65536.0f));
+}
+
+void MusicStream_Pause(bool pause)
+{
+	SDL_AtomicSet(&gMusicPaused, pause ? 1 : 0);
+}
+
+bool MusicStream_IsPlaying(void)
+{
+	return SDL_AtomicGet(&gMusicFinishedSerial) != SDL_AtomicGet(&gMusicRequestSerial);
+}
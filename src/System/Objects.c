@@ -73,6 +73,7 @@ void InitObjectManager(void)
 	gCurrentNode = nil;
 	gFirstNodePtr = nil;									// no node yet
 	gNumObjNodes = 0;
+	InvalidateShadowBlockerList();
 
 		/* INIT OBJECT POOL */
 
@@ -311,11 +312,11 @@ TQ3Matrix4x4			transMatrix,scaleMatrix,rotMatrix;
 	Q3Matrix4x4_SetTranslate(&transMatrix, theNode->Coord.x, theNode->Coord.y,	// make translate matrix
 							 theNode->Coord.z);
 
-	MatrixMultiplyFast(&scaleMatrix,											// mult scale & rot matrices
+	MatrixMultiplyAffine(&scaleMatrix,											// mult scale & rot matrices
 						 &rotMatrix,
 						 &theNode->BaseTransformMatrix);
 
-	MatrixMultiply(&theNode->BaseTransformMatrix,							// mult by trans matrix
+	MatrixMultiplyAffine(&theNode->BaseTransformMatrix,						// mult by trans matrix
 						 &transMatrix,
 						 &theNode->BaseTransformMatrix);
 }
@@ -335,6 +336,8 @@ void MoveObjects(void)
 {
 ObjNode		*thisNodePtr;
 
+	gNumShadowBlockerTests = 0;								// reset per-frame stat
+
 	if (gFirstNodePtr == nil)								// see if there are any objects
 		return;
 
@@ -394,6 +397,8 @@ float			cameraX, cameraZ;
 				/* FIRST DO OUR CULLING */
 				
 	CheckAllObjectsInConeOfVision();
+
+	BeginShadowBatch();
 	
 	theNode = gFirstNodePtr;
 
@@ -415,6 +420,9 @@ float			cameraX, cameraZ;
 		if (theNode->CType == INVALID_NODE_FLAG)				// see if already deleted
 			goto next;
 
+		if (IsDrawnBySceneryBatch(theNode))						// its supertile's batch takes care of it
+			goto next;
+
 		if (statusBits & (STATUS_BIT_ISCULLED | STATUS_BIT_HIDDEN))
 			goto next;
 
@@ -461,6 +469,8 @@ float			cameraX, cameraZ;
 					break;
 			
 			case	DISPLAY_GROUP_GENRE:
+					if (AddShadowToBatch(theNode))											// shadow decals get drawn together below
+						break;
 					Render_SubmitMeshList(
 							theNode->NumMeshes,
 							theNode->MeshList,
@@ -482,6 +492,10 @@ float			cameraX, cameraZ;
 next:
 		theNode = (ObjNode *)theNode->NextNode;
 	}while (theNode != nil);
+
+			/* DRAW ALL SHADOW DECALS AT ONCE */
+
+	SubmitShadowBatch();
 }
 
 
@@ -677,6 +691,9 @@ void DetachObject(ObjNode *theNode)
 	theNode->NextNode = nil;
 	
 	theNode->StatusBits |= STATUS_BIT_DETACHED;	
+
+	InvalidateShadowBlockerList();
+	RemoveFromSceneryBatch(theNode);				// a detached node can't stay in a batch
 }
 
 
@@ -741,6 +758,8 @@ out:
 	
 	
 	theNode->StatusBits &= ~STATUS_BIT_DETACHED;	
+
+	InvalidateShadowBlockerList();
 }
 
 
@@ -859,8 +878,8 @@ TQ3Matrix4x4	m,m2;
 		Q3Matrix4x4_SetRotate_Y(&my, theNode->Rot.y);	
 		Q3Matrix4x4_SetRotate_Z(&mz, theNode->Rot.z);	
 	
-		MatrixMultiplyFast(&mx,&mz, &mxz);
-		MatrixMultiplyFast(&mxz,&my, &m2);
+		MatrixMultiplyAffine(&mx,&mz, &mxz);
+		MatrixMultiplyAffine(&mxz,&my, &m2);
 	}
 				/* STANDARD XYZ ROTATION */
 	else
@@ -872,7 +891,7 @@ TQ3Matrix4x4	m,m2;
 	m2.value[3][1] = theNode->Coord.y;
 	m2.value[3][2] = theNode->Coord.z;
 	
-	MatrixMultiplyFast(&m,&m2, &theNode->BaseTransformMatrix);
+	MatrixMultiplyAffine(&m,&m2, &theNode->BaseTransformMatrix);
 }
 
 
@@ -16,6 +16,7 @@
 /*    PROTOTYPES            */
 /****************************/
 
+static ObjNode* FindShadowBlocker(long x, long y, long z, Boolean useBlockerList);
 
 
 /****************************/
@@ -24,11 +25,52 @@
 
 #define	SHADOW_Y_OFF	6.0f
 
+#define	MAX_SHADOW_BLOCKERS		500			// can't be more than the ObjNode budget
+
+#define	MAX_SHADOW_BATCHES			4		// one per texture/blending combination
+#define	MAX_SHADOW_BATCH_QUADS		256
+
+#define	SHADOW_BATCH_STATUS_MASK	(STATUS_BIT_NOZWRITE | STATUS_BIT_NULLSHADER | STATUS_BIT_GLOW | STATUS_BIT_NOFOG | STATUS_BIT_KEEPBACKFACES)
+
 /**********************/
 /*     VARIABLES      */
 /**********************/
 
 #define	CheckForBlockers	Flag[0]
+#define	IsShadowDecal		Flag[1]
+
+			/* SHADOW BLOCKER LIST */
+			//
+			// All attached CTYPE_BLOCKSHADOW nodes, in object list order.
+			// Rebuilt lazily after any node is attached or detached.
+			// If there are too many blockers to fit, lookups walk the whole object list instead.
+			//
+
+static ObjNode			*gShadowBlockers[MAX_SHADOW_BLOCKERS];
+static int				gNumShadowBlockers = 0;
+static Boolean			gShadowBlockerListIsStale = true;
+static Boolean			gShadowBlockerListIsFull = false;
+
+int						gNumShadowBlockerTests = 0;		// # of blocker boxes tested by UpdateShadow this frame
+
+			/* SHADOW BATCHES */
+			//
+			// Shadow decals are copied into these meshes, already in world space,
+			// so that all shadows sharing a texture go out in a single draw.
+			//
+
+typedef struct
+{
+	TQ3TriMeshData		*mesh;
+	uint32_t			glTextureName;
+	TQ3TexturingMode	texturingMode;
+	RenderModifiers		renderMods;
+}ShadowBatchType;
+
+static ShadowBatchType	gShadowBatches[MAX_SHADOW_BATCHES];
+static int				gNumShadowBatches = 0;
+
+int						gNumBatchedShadows = 0;			// # of shadow decals drawn through a batch this frame
 
 
 //============================================================================================================
@@ -198,6 +240,7 @@ ObjNode	*shadowObj;
 	shadowObj->SpecialF[1] = scaleZ;
 
 	shadowObj->CheckForBlockers = checkBlockers;
+	shadowObj->IsShadowDecal = true;
 
 	return(shadowObj);
 }
@@ -235,6 +278,7 @@ ObjNode	*shadowObj;
 	shadowObj->SpecialF[1] = scaleZ;
 
 	shadowObj->CheckForBlockers = checkBlockers;
+	shadowObj->IsShadowDecal = true;
 
 	return(shadowObj);
 }
@@ -242,6 +286,152 @@ ObjNode	*shadowObj;
 
 
 
+/******************* INVALIDATE SHADOW BLOCKER LIST ************************/
+//
+// Called by AttachObject & DetachObject.
+//
+
+void InvalidateShadowBlockerList(void)
+{
+	gShadowBlockerListIsStale = true;
+}
+
+
+/******************* REBUILD SHADOW BLOCKER LIST ************************/
+
+static void RebuildShadowBlockerList(void)
+{
+	gNumShadowBlockers = 0;
+	gShadowBlockerListIsFull = false;
+
+	for (ObjNode* thisNodePtr = gFirstNodePtr; thisNodePtr != nil; thisNodePtr = thisNodePtr->NextNode)
+	{
+		if (thisNodePtr->CType & CTYPE_BLOCKSHADOW)
+		{
+			if (gNumShadowBlockers >= MAX_SHADOW_BLOCKERS)				// no room: FindShadowBlocker will scan the object list
+			{
+				gShadowBlockerListIsFull = true;
+				break;
+			}
+			gShadowBlockers[gNumShadowBlockers++] = thisNodePtr;
+		}
+	}
+
+	gShadowBlockerListIsStale = false;
+}
+
+
+/******************* IS POINT ON SHADOW BLOCKER ************************/
+
+static inline Boolean IsPointOnShadowBlocker(const ObjNode* theNode, long x, long y, long z)
+{
+	if (!(theNode->CType & CTYPE_BLOCKSHADOW))							// look for things which can block the shadow
+		return false;
+
+	if (!theNode->CollisionBoxes)
+		return false;
+
+	gNumShadowBlockerTests++;
+
+	const CollisionBoxType* box = &theNode->CollisionBoxes[0];
+
+	return y >= box->bottom
+		&& x >= box->left
+		&& x <= box->right
+		&& z <= box->front
+		&& z >= box->back;
+}
+
+
+/******************* FIND SHADOW BLOCKER ************************/
+//
+// Returns the first node in the object list that the point is on top of,
+// or nil if the shadow should go on the terrain.
+//
+// useBlockerList = false walks the whole object list instead (for benchmarking).
+//
+
+static ObjNode* FindShadowBlocker(long x, long y, long z, Boolean useBlockerList)
+{
+	if (useBlockerList && gShadowBlockerListIsStale)
+		RebuildShadowBlockerList();
+
+	if (!useBlockerList || gShadowBlockerListIsFull)					// benchmarking, or the list overflowed
+	{
+		for (ObjNode* thisNodePtr = gFirstNodePtr; thisNodePtr != nil; thisNodePtr = thisNodePtr->NextNode)
+		{
+			if (IsPointOnShadowBlocker(thisNodePtr, x, y, z))
+				return thisNodePtr;
+		}
+		return nil;
+	}
+
+	for (int i = 0; i < gNumShadowBlockers; i++)						// CType is rechecked in case it changed since the list was built
+	{
+		if (IsPointOnShadowBlocker(gShadowBlockers[i], x, y, z))
+			return gShadowBlockers[i];
+	}
+
+	return nil;
+}
+
+
+#if _DEBUG
+/******************* BENCHMARK SHADOW BLOCKERS ************************/
+//
+// Drops a few hundred shadow probes around the player and looks for blockers under
+// them with and without the blocker list. Checks that both agree and prints timings.
+//
+
+void BenchmarkShadowBlockers(void)
+{
+	const int	probesPerSide = 24;
+	const float	spread = TERRAIN_SUPERTILE_UNIT_SIZE * SUPERTILE_DIST_WIDE * .5f;
+	int			savedNumTests = gNumShadowBlockerTests;
+	int			numTests[2] = {0, 0};
+	double		totalMS[2] = {0, 0};
+	int			numMismatches = 0;
+	int			numOnBlockers = 0;
+
+	for (int pz = 0; pz < probesPerSide; pz++)
+	{
+		for (int px = 0; px < probesPerSide; px++)
+		{
+			float	fx = gMyCoord.x - spread + (2.0f * spread) * px / (probesPerSide - 1);
+			float	fz = gMyCoord.z - spread + (2.0f * spread) * pz / (probesPerSide - 1);
+			long	x = fx;
+			long	z = fz;
+			long	y = GetTerrainHeightAtCoord(fx, fz, FLOOR) + 200.0f * ((px + pz) % 4);
+			ObjNode	*found[2];
+
+			for (int useList = 0; useList < 2; useList++)
+			{
+				gNumShadowBlockerTests = 0;
+
+				uint64_t start = GetProfilingTimestamp();
+				found[useList] = FindShadowBlocker(x, y, z, useList);
+				totalMS[useList] += GetMillisecondsSince(start);
+
+				numTests[useList] += gNumShadowBlockerTests;
+			}
+
+			if (found[0] != found[1])
+				numMismatches++;
+			if (found[1])
+				numOnBlockers++;
+		}
+	}
+
+	printf("Shadow blockers: %d probes (%d on blockers), %d blockers; object list %.3f ms (%d tests), blocker list %.3f ms (%d tests), %d mismatches\n",
+			probesPerSide * probesPerSide, numOnBlockers, gNumShadowBlockers,
+			totalMS[0], numTests[0], totalMS[1], numTests[1], numMismatches);
+	GAME_ASSERT_MESSAGE(numMismatches == 0, "Shadow blocker list changed which blocker shadows land on");
+
+	gNumShadowBlockerTests = savedNumTests;
+}
+#endif
+
+
 /************************ UPDATE SHADOW *************************/
 
 void UpdateShadow(ObjNode *theNode)
@@ -288,47 +478,26 @@ float	dist;
 		
 	if (shadowNode->CheckForBlockers)
 	{
-		thisNodePtr = gFirstNodePtr;
-		do
+		thisNodePtr = FindShadowBlocker(x, y, z, true);
+		if (thisNodePtr)
 		{
-			if (thisNodePtr->CType & CTYPE_BLOCKSHADOW)						// look for things which can block the shadow
+				/* SHADOW IS ON OBJECT  */
+
+			// Use same draw order as object we're standing on top of
+			shadowNode->RenderModifiers.drawOrder = thisNodePtr->RenderModifiers.drawOrder;
+
+			shadowNode->Coord.y = thisNodePtr->CollisionBoxes[0].top + SHADOW_Y_OFF;
+			
+			if (thisNodePtr->CType & CTYPE_LIQUID)						// if liquid, move to top
 			{
-				if (thisNodePtr->CollisionBoxes)
-				{
-					if (y < thisNodePtr->CollisionBoxes[0].bottom)
-						goto next;
-					if (x < thisNodePtr->CollisionBoxes[0].left)
-						goto next;
-					if (x > thisNodePtr->CollisionBoxes[0].right)
-						goto next;
-					if (z > thisNodePtr->CollisionBoxes[0].front)
-						goto next;
-					if (z < thisNodePtr->CollisionBoxes[0].back)
-						goto next;
-
-						/* SHADOW IS ON OBJECT  */
-
-					// Use same draw order as object we're standing on top of
-					shadowNode->RenderModifiers.drawOrder = thisNodePtr->RenderModifiers.drawOrder;
-
-					shadowNode->Coord.y = thisNodePtr->CollisionBoxes[0].top + SHADOW_Y_OFF;
-					
-					if (thisNodePtr->CType & CTYPE_LIQUID)						// if liquid, move to top
-					{
-						shadowNode->Coord.y += gLiquidCollisionTopOffset[thisNodePtr->Kind];
-					}
-					
-					shadowNode->Scale.x = shadowNode->SpecialF[0];				// use preset scale
-					shadowNode->Scale.z = shadowNode->SpecialF[1];
-					UpdateObjectTransforms(shadowNode);
-					return;
-					
-				}
-			}		
-	next:					
-			thisNodePtr = (ObjNode *)thisNodePtr->NextNode;		// next node
+				shadowNode->Coord.y += gLiquidCollisionTopOffset[thisNodePtr->Kind];
+			}
+			
+			shadowNode->Scale.x = shadowNode->SpecialF[0];				// use preset scale
+			shadowNode->Scale.z = shadowNode->SpecialF[1];
+			UpdateObjectTransforms(shadowNode);
+			return;
 		}
-		while (thisNodePtr != nil);
 	}		
 		
 			/************************/
@@ -353,6 +522,207 @@ float	dist;
 }
 
 
+/******************* BEGIN SHADOW BATCH ************************/
+//
+// Called by DrawObjects before any node is submitted.
+//
+
+void BeginShadowBatch(void)
+{
+	gNumShadowBatches = 0;											// batches get re-keyed every frame since textures change between levels
+	gNumBatchedShadows = 0;
+}
+
+
+/******************* GET SHADOW BATCH ************************/
+//
+// Returns the batch that draws meshes with this texture & status bits, creating it if needed.
+//
+
+static ShadowBatchType *GetShadowBatch(const TQ3TriMeshData *srcMesh, uint32_t statusBits)
+{
+ShadowBatchType	*batch;
+
+	for (int i = 0; i < gNumShadowBatches; i++)
+	{
+		batch = &gShadowBatches[i];
+		if (batch->glTextureName == srcMesh->glTextureName
+			&& batch->texturingMode == srcMesh->texturingMode
+			&& batch->renderMods.statusBits == statusBits)
+		{
+			return batch;
+		}
+	}
+
+	if (gNumShadowBatches >= MAX_SHADOW_BATCHES)
+		return nil;
+
+	batch = &gShadowBatches[gNumShadowBatches++];
+
+	if (!batch->mesh)														// meshes are kept for the rest of the session
+	{
+		batch->mesh = Q3TriMeshData_New(MAX_SHADOW_BATCH_QUADS*2, MAX_SHADOW_BATCH_QUADS*4,
+										kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexColors);
+	}
+
+	batch->mesh->numPoints		= 0;
+	batch->mesh->numTriangles	= 0;
+	batch->mesh->diffuseColor	= (TQ3ColorRGBA) { 1, 1, 1, 1 };
+	batch->mesh->texturingMode	= srcMesh->texturingMode;
+	batch->mesh->glTextureName	= srcMesh->glTextureName;
+
+	batch->glTextureName		= srcMesh->glTextureName;
+	batch->texturingMode		= srcMesh->texturingMode;
+
+	batch->renderMods					= (RenderModifiers) {0};
+	batch->renderMods.statusBits		= statusBits;
+	batch->renderMods.diffuseColor		= (TQ3ColorRGBA) { 1, 1, 1, 1 };
+	batch->renderMods.autoFadeFactor	= 1.0f;
+	batch->renderMods.drawOrder			= kDrawOrder_Shadows;
+
+	return batch;
+}
+
+
+/******************* ADD SHADOW TO BATCH ************************/
+//
+// Called by DrawObjects for each visible display group node.
+// If the node is a shadow decal that can share a draw with the other shadows,
+// its geometry gets appended to a batch in world space and we return true.
+// Otherwise the caller must submit the node normally.
+//
+// Shadows resting on a blocker take the blocker's draw order (see UpdateShadow),
+// so they must still be depth-sorted on their own.
+//
+
+Boolean AddShadowToBatch(ObjNode *theNode)
+{
+const RenderModifiers	*mods = &theNode->RenderModifiers;
+ShadowBatchType			*batches[MAX_DECOMPOSED_TRIMESHES];
+
+	if (!theNode->IsShadowDecal)
+		return false;
+
+	if (mods->drawOrder != kDrawOrder_Shadows)
+		return false;
+
+	uint32_t statusBits = mods->statusBits & SHADOW_BATCH_STATUS_MASK;
+	if (!(statusBits & STATUS_BIT_NULLSHADER))							// batches don't carry normals
+		return false;
+
+			/* FIND A BATCH WITH ROOM FOR EVERY MESH */
+
+	for (int i = 0; i < theNode->NumMeshes; i++)
+	{
+		const TQ3TriMeshData* srcMesh = theNode->MeshList[i];
+
+		if (!srcMesh->vertexUVs)
+			return false;
+
+		if (srcMesh->texturingMode != kQ3TexturingModeAlphaBlend			// batch must land in the alpha pass like the original
+			&& !(statusBits & STATUS_BIT_GLOW))
+			return false;
+
+		batches[i] = GetShadowBatch(srcMesh, statusBits);
+		if (!batches[i])
+			return false;
+
+		if (batches[i]->mesh->numPoints + srcMesh->numPoints > MAX_SHADOW_BATCH_QUADS*4
+			|| batches[i]->mesh->numTriangles + srcMesh->numTriangles > MAX_SHADOW_BATCH_QUADS*2)
+			return false;
+	}
+
+			/* APPEND EACH MESH IN WORLD SPACE */
+
+	for (int i = 0; i < theNode->NumMeshes; i++)
+	{
+		const TQ3TriMeshData* srcMesh = theNode->MeshList[i];
+		TQ3TriMeshData* batchMesh = batches[i]->mesh;
+		int base = batchMesh->numPoints;
+
+		TransformPointsAffine(srcMesh->points, &theNode->BaseTransformMatrix, &batchMesh->points[base], srcMesh->numPoints);
+
+		memcpy(&batchMesh->vertexUVs[base], srcMesh->vertexUVs, srcMesh->numPoints * sizeof(TQ3Param2D));
+
+				/* BAKE COLOR & FADE INTO VERTEX COLORS */
+				//
+				// Same math as the renderer's alpha pass: per-vertex colors ignore the diffuse colors.
+				//
+
+		if (srcMesh->hasVertexColors)
+		{
+			for (int v = 0; v < srcMesh->numPoints; v++)
+			{
+				batchMesh->vertexColors[base+v] = srcMesh->vertexColors[v];
+				batchMesh->vertexColors[base+v].a *= mods->autoFadeFactor;
+			}
+		}
+		else
+		{
+			TQ3ColorRGBA color =
+			{
+				srcMesh->diffuseColor.r * mods->diffuseColor.r,
+				srcMesh->diffuseColor.g * mods->diffuseColor.g,
+				srcMesh->diffuseColor.b * mods->diffuseColor.b,
+				srcMesh->diffuseColor.a * mods->diffuseColor.a * mods->autoFadeFactor,
+			};
+
+			for (int v = 0; v < srcMesh->numPoints; v++)
+				batchMesh->vertexColors[base+v] = color;
+		}
+
+		for (int t = 0; t < srcMesh->numTriangles; t++)
+		{
+			TQ3TriMeshTriangleData* tri = &batchMesh->triangles[batchMesh->numTriangles++];
+			tri->pointIndices[0] = srcMesh->triangles[t].pointIndices[0] + base;
+			tri->pointIndices[1] = srcMesh->triangles[t].pointIndices[1] + base;
+			tri->pointIndices[2] = srcMesh->triangles[t].pointIndices[2] + base;
+		}
+
+		batchMesh->numPoints += srcMesh->numPoints;
+	}
+
+	gNumBatchedShadows++;
+	return true;
+}
+
+
+/******************* SUBMIT SHADOW BATCH ************************/
+//
+// Called by DrawObjects once all nodes have been submitted.
+// The batch meshes must stay untouched until the render queue is flushed.
+//
+
+void SubmitShadowBatch(void)
+{
+	for (int i = 0; i < gNumShadowBatches; i++)
+	{
+		ShadowBatchType* batch = &gShadowBatches[i];
+		TQ3TriMeshData* mesh = batch->mesh;
+
+		if (mesh->numTriangles == 0)
+			continue;
+
+				/* CALC BOUNDING BOX FOR DEPTH SORTING */
+
+		mesh->bBox.min = mesh->bBox.max = mesh->points[0];
+		for (int v = 1; v < mesh->numPoints; v++)
+		{
+			const TQ3Point3D* p = &mesh->points[v];
+			if (p->x < mesh->bBox.min.x) mesh->bBox.min.x = p->x;
+			if (p->y < mesh->bBox.min.y) mesh->bBox.min.y = p->y;
+			if (p->z < mesh->bBox.min.z) mesh->bBox.min.z = p->z;
+			if (p->x > mesh->bBox.max.x) mesh->bBox.max.x = p->x;
+			if (p->y > mesh->bBox.max.y) mesh->bBox.max.y = p->y;
+			if (p->z > mesh->bBox.max.z) mesh->bBox.max.z = p->z;
+		}
+		mesh->bBox.isEmpty = kQ3False;
+
+		Render_SubmitMesh(mesh, nil, &batch->renderMods, nil);
+	}
+}
+
+
 
 //============================================================================================================
 //============================================================================================================
@@ -379,6 +749,9 @@ ObjNode				*theNode;
 					
 	do
 	{	
+		if (IsDrawnBySceneryBatch(theNode))						// batch was culled as a whole
+			goto next;
+
 		if (theNode->StatusBits & STATUS_BIT_ALWAYSCULL)
 			goto try_cull;
 			
@@ -0,0 +1,86 @@
+// PARALLEL.C
+// Splits loops across worker threads. See parallel.h.
+
+#include "game.h"
+
+typedef struct
+{
+	ParallelForProc		proc;
+	void*				userData;
+	int					begin;
+	int					end;
+} ParallelRange;
+
+
+/****************** PARALLEL WORKER THREAD *********************/
+
+static int ParallelWorkerThread(void* data)
+{
+	ParallelRange* range = (ParallelRange*) data;
+	range->proc(range->begin, range->end, range->userData);
+	return 0;
+}
+
+
+/****************** GET NUM PARALLEL WORKERS *********************/
+
+int GetNumParallelWorkers(void)
+{
+	int n = SDL_GetCPUCount();
+
+	if (n < 1)
+		n = 1;
+	else if (n > MAX_PARALLEL_WORKERS)
+		n = MAX_PARALLEL_WORKERS;
+
+	return n;
+}
+
+
+/****************** PARALLEL FOR *********************/
+
+void ParallelFor(int count, ParallelForProc proc, void* userData)
+{
+ParallelRange	ranges[MAX_PARALLEL_WORKERS];
+SDL_Thread*		threads[MAX_PARALLEL_WORKERS];
+
+	if (count <= 0)
+		return;
+
+	int numWorkers = GetNumParallelWorkers();
+	if (numWorkers > count)
+		numWorkers = count;
+
+	if (numWorkers == 1)									// not worth spawning anything
+	{
+		proc(0, count, userData);
+		return;
+	}
+
+			/* SPLIT RANGE INTO CONTIGUOUS CHUNKS */
+
+	for (int w = 0; w < numWorkers; w++)
+	{
+		ranges[w].proc		= proc;
+		ranges[w].userData	= userData;
+		ranges[w].begin		= (int) ((int64_t) count * w / numWorkers);
+		ranges[w].end		= (int) ((int64_t) count * (w+1) / numWorkers);
+	}
+
+			/* KICK OFF WORKERS; CALLING THREAD TAKES CHUNK 0 */
+
+	for (int w = 1; w < numWorkers; w++)
+	{
+		threads[w] = SDL_CreateThread(ParallelWorkerThread, "ParallelFor", &ranges[w]);
+		if (!threads[w])									// couldn't spawn: do it ourselves
+			ParallelWorkerThread(&ranges[w]);
+	}
+
+	ParallelWorkerThread(&ranges[0]);
+
+	for (int w = 1; w < numWorkers; w++)
+	{
+		if (threads[w])
+			SDL_WaitThread(threads[w], NULL);
+	}
+}
@@ -35,18 +35,40 @@ static void UpdateDebugStats(void)
 
 		snprintf(
 				gDebugTextBuffer, sizeof(gDebugTextBuffer),
-				"fps: %d\ntris: %d\nmeshes: %d+%d\ntiles: %ld/%ld%s\nnodes: %d\nheap: %dK, %dp\n\nx: %d\nz: %d\ny: %.3f %s%s\n%s\n%s\n\n\n\n\n\n\n\n\n"
+				"fps: %d\ntris: %d\nmeshes: %d+%d\nparticles: %d (%d dropped), %dK, %.2fms, %d ripples\nvoices: %d/%d +%d, %d stolen, %d dropped\ntiles: %ld/%ld%s, %d far, %.2fms/build (%.2fms tex)\nitems: %d max/pass, %.2fms/scan\nnodes: %d, %d shadow blocker tests, %d batched shadows\nscenery: %d nodes in %d batch draws\nheap: %dK, %dp\nresident: %dK, %d/%d parked\n\nx: %d\nz: %d\ny: %.3f %s%s\n%s\n%s\n\n\n\n"
 				"Bugdom %s\nOpenGL %s, %s @ %dx%d",
 				(int)roundf(fps),
 				gRenderStats.triangles,
 				gRenderStats.meshesPass1,
 				gRenderStats.meshesPass2,
+				gNumLiveParticles,
+				gNumDroppedParticles,
+				gParticleArenaBytes / 1024,
+				gParticleDrawMilliseconds,
+				gNumRipples,
+				gVoiceStats.voicesBusy,
+				gVoiceStats.voicesTotal,
+				gVoiceStats.started,
+				gVoiceStats.stolen,
+				gVoiceStats.dropped,
 				gSupertileBudget - gNumFreeSupertiles,
 				gSupertileBudget,
 				gSuperTileMemoryListExists ? "" : " (no terrain)",
+				gNumFarSuperTilesDrawn,
+				gSuperTileBuildMilliseconds,
+				gSuperTileTextureMilliseconds,
+				gMaxItemsAllocatedInAPass,
+				gItemScanMilliseconds,
 				gNumObjNodes,
+				gNumShadowBlockerTests,
+				gNumBatchedShadows,
+				gNumBatchedSceneryNodes,
+				gNumSceneryBatchDraws,
 				(int)(Pomme_GetHeapSize() / 1024),
 				(int)Pomme_GetNumAllocs(),
+				(int)(gResidentAssetBytes / 1024),
+				gNumParkedResidentAssets,
+				gNumResidentAssets,
 				(int)(gPlayerObj? gPlayerObj->Coord.x: 0),
 				(int)(gPlayerObj? gPlayerObj->Coord.z: 0),
 				gPlayerObj? gPlayerObj->Coord.y: 0,
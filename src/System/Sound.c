@@ -18,16 +18,35 @@
 /*    PROTOTYPES            */
 /****************************/
 
-static void SongCompletionProc(SndChannelPtr chan);
-static short FindSilentChannel(void);
+static short FindSilentChannel(u_long loudness);
+static short MakeChannelHandle(short c);
+static short GetChannelFromHandle(short handle);
+static void StopChannel(short c);
+static void SetChannelVolume(short c, float leftVol, float rightVol);
+static void RefreshChannelBusyFlags(void);
+static void ChannelStartedPlaying(short c);
 static void Calc3DEffectVolume(short effectNum, TQ3Point3D *where, float volAdjust, u_long *leftVolOut, u_long *rightVolOut);
+static void Calc3DEffectVolumes(int n, const float* x, const float* y, const float* z, const float* refDist, const float* volAdjust, u_long* leftVolOut, u_long* rightVolOut);
+static void Update3DSoundChannels(void);
+static void DisposeResidentSoundBank(void* payload);
 
 
 /****************************/
 /*    CONSTANTS             */
 /****************************/
 
-#define		MAX_CHANNELS			14
+#define		MAX_CHANNELS			64			// upper limit for --voices
+#define		DEFAULT_CHANNELS		14
+
+		// Callers get channel handles, not raw channel indices:
+		// the low bits are the channel index, the high bits are the generation
+		// the voice was in when the effect was started. Once the voice is reused
+		// for another effect, old handles no longer match and are ignored.
+		// (6 + 9 bits, so a handle is always a positive short.)
+
+#define		CHANNEL_INDEX_BITS		6
+#define		CHANNEL_INDEX_MASK		((1 << CHANNEL_INDEX_BITS) - 1)
+#define		CHANNEL_GENERATION_MASK	0x1ff
 
 
 typedef struct
@@ -46,6 +65,11 @@ typedef struct
 	u_long			lastLoudness;
 } LoadedEffect;
 
+typedef struct
+{
+	LoadedEffect	parkedEffects[NUM_EFFECTS];		// holds the bank's samples while it sits unused in the resident cache
+} ResidentSoundBank;
+
 
 #define	VOLUME_DISTANCE_FACTOR	.004f		// bigger == sound decays FASTER with dist, smaller = louder far away
 
@@ -76,17 +100,30 @@ TQ3Point3D					gEarCoords;				// coord of camera plus a bit to get pt in front o
 static	TQ3Vector3D			gEyeVector;
 
 static	LoadedEffect		gLoadedEffects[NUM_EFFECTS];
+static	ResidentSoundBank*	gResidentSoundBanks[NUM_SOUNDBANKS];	// non-nil if the bank is borrowed from the resident asset cache
 
 static	SndChannelPtr		gSndChannel[MAX_CHANNELS];
 static	ChannelInfoType		gChannelInfo[MAX_CHANNELS];
 
 static short				gMaxChannels = 0;
 
+static uint32_t				gChannelStartStampAllocator = 0;
+static VoiceStats			gVoiceStatsThisFrame;
+
+		/* SCRATCH FOR BATCHED 3D VOLUME UPDATES */
+
+static float				gEmitterX[MAX_CHANNELS];
+static float				gEmitterY[MAX_CHANNELS];
+static float				gEmitterZ[MAX_CHANNELS];
+static float				gEmitterRefDist[MAX_CHANNELS];
+static float				gEmitterVolAdjust[MAX_CHANNELS];
+static short				gEmitterChannel[MAX_CHANNELS];
+static u_long				gEmitterLeftVol[MAX_CHANNELS];
+static u_long				gEmitterRightVol[MAX_CHANNELS];
+VoiceStats					gVoiceStats;
+
 Boolean						gSongPlayingFlag = false;
-static Boolean				gResetSong = false;
-static Boolean				gLoopSongFlag = true;
 
-static	SndChannelPtr		gMusicChannel=nil;
 Boolean						gMuteMusicFlag = false;
 static short				gCurrentSong = -1;
 
@@ -166,20 +203,31 @@ OSErr		iErr;
 			/* INIT BANK INFO */
 
 	memset(gLoadedEffects, 0, sizeof(gLoadedEffects));
+	memset(gResidentSoundBanks, 0, sizeof(gResidentSoundBanks));
 
 			/******************/
 			/* ALLOC CHANNELS */
 			/******************/
 
-			/* MAKE MUSIC CHANNEL */
-			
-	SndNewChannel(&gMusicChannel,sampledSynth,initStereo,nil);
+			/* START MUSIC STREAMER */
+
+	InitMusicStream();
 
 
 			/* ALL OTHER CHANNELS */
-				
-	for (gMaxChannels = 0; gMaxChannels < MAX_CHANNELS; gMaxChannels++)
+
+	int numChannelsWanted = gCommandLine.numEffectVoices > 0 ? gCommandLine.numEffectVoices : DEFAULT_CHANNELS;
+	if (numChannelsWanted > MAX_CHANNELS)
+		numChannelsWanted = MAX_CHANNELS;
+
+	memset(gChannelInfo, 0, sizeof(gChannelInfo));
+	memset(&gVoiceStatsThisFrame, 0, sizeof(gVoiceStatsThisFrame));
+	memset(&gVoiceStats, 0, sizeof(gVoiceStats));
+
+	for (gMaxChannels = 0; gMaxChannels < numChannelsWanted; gMaxChannels++)
 	{
+		gChannelInfo[gMaxChannels].effectNum = -1;
+
 			/* NEW SOUND CHANNEL */
 			
 		iErr = SndNewChannel(&gSndChannel[gMaxChannels],sampledSynth,0,/*NewSndCallBackUPP(CallBackFn)*/nil);
@@ -264,12 +312,79 @@ void LoadSoundBank(int bankNum)
 	}
 }
 
+/******************* LOAD RESIDENT SOUND BANK ************************/
+//
+// Same as LoadSoundBank, but the samples are kept in the resident asset cache
+// when the bank is disposed, so they needn't be reloaded and decompressed next time.
+//
+
+void LoadResidentSoundBank(int bankNum)
+{
+char	key[MAX_RESIDENT_KEY_LENGTH];
+
+	if (gResidentSoundBanks[bankNum])							// already attached
+		return;
+
+	snprintf(key, sizeof(key), "SoundBank:%s", kSoundBankNames[bankNum]);
+
+	ResidentSoundBank* resident = AcquireResidentAsset(key);
+
+			/* NOT CACHED YET: LOAD IT FOR REAL */
+
+	if (!resident)
+	{
+		long heapBefore = Pomme_GetHeapSize();
+
+		LoadSoundBank(bankNum);
+
+		resident = (ResidentSoundBank*) AllocPtr(sizeof(ResidentSoundBank));
+		InsertResidentAsset(key, resident, (long) Pomme_GetHeapSize() - heapBefore, DisposeResidentSoundBank);
+	}
+
+			/* ALREADY CACHED: MOVE THE PARKED SAMPLES BACK IN */
+
+	else
+	{
+		DisposeSoundBank(bankNum);								// nuke any non-resident copy (also stops all channels)
+
+		for (int i = 0; i < NUM_EFFECTS; i++)
+		{
+			if (kEffectsTable[i].bank == bankNum)
+			{
+				gLoadedEffects[i] = resident->parkedEffects[i];
+				memset(&resident->parkedEffects[i], 0, sizeof(LoadedEffect));
+			}
+		}
+	}
+
+	gResidentSoundBanks[bankNum] = resident;
+}
+
 /******************** DISPOSE SOUND BANK **************************/
 
 void DisposeSoundBank(int bankNum)
 {
 	StopAllEffectChannels();									// make sure all sounds are stopped before nuking any banks
 
+			/* IF BORROWED FROM THE RESIDENT CACHE, PARK THE SAMPLES THERE */
+
+	ResidentSoundBank* resident = gResidentSoundBanks[bankNum];
+	if (resident)
+	{
+		for (int i = 0; i < NUM_EFFECTS; i++)
+		{
+			if (kEffectsTable[i].bank == bankNum)
+			{
+				resident->parkedEffects[i] = gLoadedEffects[i];
+				memset(&gLoadedEffects[i], 0, sizeof(LoadedEffect));
+			}
+		}
+
+		gResidentSoundBanks[bankNum] = nil;
+		ReleaseResidentAsset(resident);
+		return;
+	}
+
 			/* FREE ALL SAMPLES */
 
 	for (int i = 0; i < NUM_EFFECTS; i++)
@@ -292,23 +407,53 @@ void DisposeAllSoundBanks(void)
 	}
 }
 
+/**************** DISPOSE RESIDENT SOUND BANK *****************/
+//
+// Called by the resident asset cache when it evicts a bank.
+//
+
+static void DisposeResidentSoundBank(void* payload)
+{
+	ResidentSoundBank* resident = (ResidentSoundBank*) payload;
+
+	for (int i = 0; i < NUM_EFFECTS; i++)
+	{
+		if (resident->parkedEffects[i].sndHandle)
+			DisposeHandle((Handle) resident->parkedEffects[i].sndHandle);
+	}
+
+	DisposePtr((Ptr) resident);
+}
+
 /********************* STOP A CHANNEL **********************/
 //
 // Stops the indicated sound channel from playing.
+// If the handle is stale (the voice was given to another effect since),
+// the voice is left alone and only the caller's handle is cleared.
 //
 
 void StopAChannel(short *channelNum)
+{
+	short c = GetChannelFromHandle(*channelNum);
+
+	*channelNum = -1;
+
+	if (c >= 0)
+		StopChannel(c);
+}
+
+
+/********************* STOP CHANNEL **********************/
+
+static void StopChannel(short c)
 {
 SndCommand 	mySndCmd;
 OSErr 		myErr;
-SCStatus	theStatus;
-short		c = *channelNum;
 
 	if ((c < 0) || (c >= gMaxChannels))		// make sure its a legal #
 		return;
 
-	myErr = SndChannelStatus(gSndChannel[c],sizeof(SCStatus),&theStatus);	// get channel info
-	if (myErr == noErr && theStatus.scChannelBusy)					// if channel busy, then stop it
+	if (gChannelInfo[c].isBusy)						// if channel busy, then stop it
 	{
 		mySndCmd.cmd = flushCmd;	
 		mySndCmd.param1 = 0;
@@ -319,11 +464,13 @@ short		c = *channelNum;
 		mySndCmd.param1 = 0;
 		mySndCmd.param2 = 0;
 		myErr = SndDoImmediate(gSndChannel[c], &mySndCmd);
+		(void) myErr;
 	}
 	
-	*channelNum = -1;
-	
 	gChannelInfo[c].effectNum = -1;	
+	gChannelInfo[c].isBusy = false;
+	gChannelInfo[c].hasEmitterUpdate = false;
+	gChannelInfo[c].generation = (gChannelInfo[c].generation + 1) & CHANNEL_GENERATION_MASK;	// owner's handle is dead now
 	
 }
 
@@ -336,10 +483,7 @@ short		i;
 
 	for (i=0; i < gMaxChannels; i++)
 	{
-		short	c;
-		
-		c = i;
-		StopAChannel(&c);
+		StopChannel(i);
 	}
 }
 
@@ -357,7 +501,7 @@ void PauseAllChannels(Boolean pause)
 
 	if (!gMuteMusicFlag)
 	{
-		SndDoImmediate(gMusicChannel, &cmd);
+		MusicStream_Pause(pause);
 	}
 }
 
@@ -379,7 +523,7 @@ void FadeGlobalVolume(float fadeVolume)
 
 	for (int c = 0; c < gMaxChannels; c++)
 	{
-		ChangeChannelVolume(c, gChannelInfo[c].leftVolume, gChannelInfo[c].rightVolume);
+		SetChannelVolume(c, gChannelInfo[c].leftVolume, gChannelInfo[c].rightVolume);
 	}
 
 
@@ -387,19 +531,10 @@ void FadeGlobalVolume(float fadeVolume)
 
 	// First, resume song playback if it was paused --
 	// e.g. when we're adjusting the volume via pause menu
-	SndCommand cmd1 = { .cmd = pommeResumePlaybackCmd };
-	SndDoImmediate(gMusicChannel, &cmd1);
+	MusicStream_Pause(gMuteMusicFlag);
 
-	// Now update song channel volume
-	uint32_t lv2 = kFullVolume * gSongVolume * fadeVolume;
-	uint32_t rv2 = kFullVolume * gSongVolume * fadeVolume;
-	SndCommand cmd2 =
-	{
-		.cmd = volumeCmd,
-		.param1 = 0,
-		.param2 = (rv2 << 16) | lv2,
-	};
-	SndDoImmediate(gMusicChannel, &cmd2);
+	// Now update song volume
+	MusicStream_SetVolume(gSongVolume * fadeVolume);
 
 
 	gGlobalVolume = globalVolumeBackup;
@@ -413,22 +548,11 @@ void FadeGlobalVolume(float fadeVolume)
 
 void PlaySong(short songNum, Boolean loopFlag)
 {
-static	SndCommand 		mySndCmd;
-int		volume;
-OSErr	iErr;
-
 	if (songNum == gCurrentSong)					// see if this is already playing
 		return;
 
-		/* ZAP ANY EXISTING SONG */
-		
-	gCurrentSong 	= songNum;
-	gLoopSongFlag 	= loopFlag;
-	KillSong();
-	DoSoundMaintenance();
-
 			/******************************/
-			/* OPEN APPROPRIATE AIFF FILE */
+			/* FIND APPROPRIATE AIFF FILE */
 			/******************************/
 
 	const char* path = NULL;
@@ -452,81 +576,21 @@ OSErr	iErr;
 			return;
 	}
 
-	short musicFileRefNum = OpenGameFile(path);
-	volume = FULL_CHANNEL_VOLUME * gSongVolume;
-
-
-	gCurrentSong = songNum;
-	
-	
 				/*******************/
 				/* START STREAMING */
 				/*******************/
-		
-		/* RESET CHANNEL TO DEFAULT VALUES */
-
-	mySndCmd.cmd = volumeCmd;										// set sound playback volume
-	mySndCmd.param1 = 0;
-	mySndCmd.param2 = (volume<<16) | volume;
-	SndDoImmediate(gMusicChannel, &mySndCmd);
-					
-	mySndCmd.cmd 		= freqCmd;									// modify the rate to change the frequency 
-	mySndCmd.param1 	= 0;
-	mySndCmd.param2 	= kMiddleC;
-	SndDoImmediate(gMusicChannel, &mySndCmd);
-					
-			
-			
-			/* START PLAYING FROM FILE */
-
-	iErr = SndStartFilePlay(
-			gMusicChannel,
-			musicFileRefNum,
-			0,
-			0, //STREAM_BUFFER_SIZE,
-			nil, // gMusicBuffer
-			nil,
-			SongCompletionProc,
-			true);
-
-	if (iErr)
-	{
-		FSClose(musicFileRefNum);								// close the file
-		DoAlert("PlaySong: SndStartFilePlay failed! (%d)", iErr);
-	}
-	gSongPlayingFlag = true;
-
-
-			/* SET LOOP FLAG ON STREAM (SOURCE PORT ADDITION) */
-			/* So we don't need to re-read the file over and over. */
-
-	if (loopFlag)
-	{
-		mySndCmd.cmd = pommeSetLoopCmd;
-		mySndCmd.param1 = loopFlag ? 1 : 0;
-		mySndCmd.param2 = 0;
-		iErr = SndDoImmediate(gMusicChannel, &mySndCmd);
-		if (iErr)
-			DoFatalAlert("PlaySong: SndDoImmediate (pomme loop extension) failed!");
-	}
-
-
-			/* SEE IF WANT TO MUTE THE MUSIC */
-			
-//	if (gMuteMusicFlag)													
-//		SndPauseFilePlay(gMusicChannel);						// pause it	
-}
-
-/***************** SONG COMPLETION PROC *********************/
-
-static void SongCompletionProc(SndChannelPtr chan)
-{
-	(void) chan;
-
-	if (gSongPlayingFlag && !gLoopSongFlag)
-	{
-		gResetSong = true;
-	}
+				//
+				// The streamer thread opens and decodes the file, so this never reads song data.
+				// If another song is still playing, crossfade into the new one.
+				// Looping is handled by the streamer, without a gap.
+				//
+
+	MusicStream_SetVolume(gSongVolume);
+	MusicStream_Play(path, loopFlag, gSongPlayingFlag ? MUSIC_CROSSFADE_MS : 0);
+	MusicStream_Pause(gMuteMusicFlag);
+
+	gCurrentSong		= songNum;
+	gSongPlayingFlag	= true;
 }
 
 
@@ -539,9 +603,9 @@ void KillSong(void)
 	if (!gSongPlayingFlag)
 		return;
 
-	gSongPlayingFlag = false;											// tell callback to do nothing
+	gSongPlayingFlag = false;
 
-	SndStopFilePlay(gMusicChannel, true);								// stop it
+	MusicStream_Stop(MUSIC_DECLICK_MS);									// stop it
 }
 
 #pragma mark -
@@ -569,9 +633,9 @@ u_long					leftVol, rightVol;
 	theChan = PlayEffect_Parms(effectNum, leftVol, rightVol, kMiddleC);
 
 	if (theChan != -1)
-		gChannelInfo[theChan].volumeAdjust = 1.0;			// full volume adjust
+		gChannelInfo[GetChannelFromHandle(theChan)].volumeAdjust = 1.0;	// full volume adjust
 						
-	return(theChan);									// return channel #	
+	return(theChan);									// return channel handle
 }
 
 
@@ -600,9 +664,9 @@ u_long			leftVol, rightVol;
 	theChan = PlayEffect_Parms(effectNum, leftVol, rightVol, rateMultiplier);
 	
 	if (theChan != -1)
-		gChannelInfo[theChan].volumeAdjust = volumeAdjust;	// remember volume adjuster
+		gChannelInfo[GetChannelFromHandle(theChan)].volumeAdjust = volumeAdjust;	// remember volume adjuster
 
-	return(theChan);									// return channel #	
+	return(theChan);									// return channel handle
 }
 
 
@@ -614,14 +678,19 @@ u_long			leftVol, rightVol;
 
 Boolean Update3DSoundChannel(int effectNum, short *channel, TQ3Point3D *where)
 {
-SCStatus		theStatus;
-u_long			leftVol,rightVol;
 short			c;
 
-	c = *channel;
+	if (*channel == -1)
+		return(true);
+
+			/* MAKE SURE THE VOICE WASN'T GIVEN TO ANOTHER EFFECT */
 
+	c = GetChannelFromHandle(*channel);
 	if (c == -1)
+	{
+		*channel = -1;
 		return(true);
+	}
 
 			/* MAKE SURE THE SAME SOUND IS STILL ON THIS CHANNEL */
 			
@@ -638,8 +707,7 @@ short			c;
 	if (!gChannelInfo[c].isLooping)										// loopers wont complete, duh.
 #endif
 	{
-		SndChannelStatus(gSndChannel[c],sizeof(SCStatus),&theStatus);	// get channel info
-		if (!theStatus.scChannelBusy)									// see if channel not busy
+		if (!gChannelInfo[c].isBusy)									// see if channel not busy
 		{
 			StopAChannel(channel);							// make sure it's really stopped (OS X sound manager bug)
 			return(true);
@@ -647,18 +715,16 @@ short			c;
 	}
 
 			/* UPDATE THE THING */
+			//
+			// Just remember where the emitter is. The new volume is calculated
+			// along with all other 3D channels in Update3DSoundChannels.
+			//
 
 	if (where)
 	{
-		Calc3DEffectVolume(gChannelInfo[c].effectNum, where, gChannelInfo[c].volumeAdjust, &leftVol, &rightVol);
-		if ((leftVol+rightVol) == 0)										// if volume goes to 0, then kill channel
-		{
-			StopAChannel(channel);
-			return(false);
-		}
-
-		ChangeChannelVolume(c, leftVol, rightVol);
-	}	
+		gChannelInfo[c].emitterCoord = *where;
+		gChannelInfo[c].hasEmitterUpdate = true;
+	}
 	return(false);
 }
 
@@ -731,24 +797,23 @@ u_long			lv2,rv2;
 		&& (kSoundFlag_Unique & flags)
 		&& gChannelInfo[theChan].effectNum == effectNum)
 	{
-		SCStatus theStatus;
-		myErr = SndChannelStatus(gSndChannel[theChan], sizeof(SCStatus), &theStatus);
-		if (myErr == noErr && theStatus.scChannelBusy)
+		if (gChannelInfo[theChan].isBusy)
 		{
 			if (kSoundFlag_DontInterrupt & flags)					// don't interrupt if this flag is set
 				return -1;
 //			else if ((kSoundFlag_DontInterruptLouder & flags) && sound->lastLoudness >= leftVolume + rightVolume)	// don't interrupt louder effect
 //				return -1;
 			else												// otherwise interrupt current effect, force replay
-				StopAChannel(&theChan);
+				StopChannel(theChan);
 		}
 	}
 
-			/* LOOK FOR FREE CHANNEL */
+			/* LOOK FOR FREE CHANNEL (OR ONE WE CAN STEAL) */
 
-	theChan = FindSilentChannel();
+	theChan = FindSilentChannel(leftVolume + rightVolume);
 	if (theChan == -1)
 	{
+		gVoiceStatsThisFrame.dropped++;
 		return(-1);
 	}
 
@@ -806,7 +871,8 @@ u_long			lv2,rv2;
 	gChannelInfo[theChan].effectNum 	= effectNum;		// remember what effect is playing on this channel
 	gChannelInfo[theChan].leftVolume 	= leftVolume;		// remember requested volume (not the adjusted volume!)
 	gChannelInfo[theChan].rightVolume 	= rightVolume;	
-	return(theChan);										// return channel #	
+	ChannelStartedPlaying(theChan);
+	return(MakeChannelHandle(theChan));						// return channel handle
 }
 
 
@@ -820,14 +886,23 @@ u_long			lv2,rv2;
 //
 
 void ChangeChannelVolume(short channel, float leftVol, float rightVol)
+{
+	channel = GetChannelFromHandle(channel);
+	if (channel < 0)									// make sure it's valid (and still ours)
+		return;
+
+	SetChannelVolume(channel, leftVol, rightVol);
+}
+
+
+/*************** SET CHANNEL VOLUME **************/
+
+static void SetChannelVolume(short channel, float leftVol, float rightVol)
 {
 SndCommand 		mySndCmd;
 SndChannelPtr	chanPtr;
 u_long			lv2,rv2;
 
-	if (channel < 0)									// make sure it's valid
-		return;
-
 	lv2 = leftVol * gGlobalVolume;				// amplify by global volume
 	rv2 = rightVol * gGlobalVolume;			
 
@@ -849,7 +924,7 @@ u_long			lv2,rv2;
 void ToggleMusic(void)
 {
 	gMuteMusicFlag = !gMuteMusicFlag;
-	SndPauseFilePlay(gMusicChannel);			// pause it
+	MusicStream_Pause(gMuteMusicFlag);			// pause it
 }
 
 
@@ -868,40 +943,116 @@ void DoSoundMaintenance(void)
 			ToggleMusic();			
 	}
 
-				/* SEE IF STREAMED MUSIC STOPPED - SO RESET */
+				/* UPDATE VOICE STATE & STATS */
 
-	if (gResetSong)
+	RefreshChannelBusyFlags();
+	Update3DSoundChannels();
+
+	gVoiceStatsThisFrame.voicesBusy = 0;
+	for (int c = 0; c < gMaxChannels; c++)
 	{
-		gResetSong = false;
-		if (!gLoopSongFlag)
-			KillSong();
+		if (gChannelInfo[c].isBusy)
+			gVoiceStatsThisFrame.voicesBusy++;
 	}
+	gVoiceStatsThisFrame.voicesTotal = gMaxChannels;
+
+	gVoiceStats = gVoiceStatsThisFrame;
+	memset(&gVoiceStatsThisFrame, 0, sizeof(gVoiceStatsThisFrame));
+
+				/* SEE IF STREAMED MUSIC STOPPED - SO RESET */
+
+	if (gSongPlayingFlag && !MusicStream_IsPlaying())
+		KillSong();
 }
 
 
 
-/******************** FIND SILENT CHANNEL *************************/
+/******************** CHANNEL STARTED PLAYING *************************/
+
+static void ChannelStartedPlaying(short c)
+{
+	gChannelInfo[c].generation = (gChannelInfo[c].generation + 1) & CHANNEL_GENERATION_MASK;	// invalidate handles of the previous effect
+	gChannelInfo[c].isBusy = true;
+	gChannelInfo[c].hasEmitterUpdate = false;
+	gChannelInfo[c].startStamp = ++gChannelStartStampAllocator;
+	gVoiceStatsThisFrame.started++;
+}
 
-static short FindSilentChannel(void)
+
+/******************** REFRESH CHANNEL BUSY FLAGS *************************/
+//
+// Pomme only reports completion through a callback for file playback (music),
+// so effect channels that we believe are busy are checked once here.
+// Everywhere else reads the cached isBusy flag.
+//
+
+static void RefreshChannelBusyFlags(void)
 {
-short		theChan;
-OSErr		myErr;
 SCStatus	theStatus;
 
-	for (theChan=0; theChan < gMaxChannels; theChan++)
+	for (int c = 0; c < gMaxChannels; c++)
 	{
-		myErr = SndChannelStatus(gSndChannel[theChan],sizeof(SCStatus),&theStatus);	// get channel info
-		if (myErr)
+		if (!gChannelInfo[c].isBusy)
 			continue;
-		if (!theStatus.scChannelBusy)					// see if channel not busy
+
+		OSErr myErr = SndChannelStatus(gSndChannel[c], sizeof(SCStatus), &theStatus);
+		if (myErr != noErr || !theStatus.scChannelBusy)
+			gChannelInfo[c].isBusy = false;
+	}
+}
+
+
+/******************** FIND SILENT CHANNEL *************************/
+//
+// Returns a channel on which to play a new effect that will be this loud (left+right),
+// or -1 if the effect should be dropped.
+//
+// If all channels are busy, steals the quietest one, as long as it is quieter
+// than the new effect. Among equally quiet channels, the oldest one is stolen.
+//
+
+static short FindSilentChannel(u_long loudness)
+{
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (short c = 0; c < gMaxChannels; c++)
 		{
-			return(theChan);
+			if (!gChannelInfo[c].isBusy)					// see if channel not busy
+				return c;
 		}
+
+		if (pass == 0)										// some effects may have ended since the last frame
+			RefreshChannelBusyFlags();
 	}
-	
-			/* NO FREE CHANNELS */
-	
-	return(-1);										
+
+			/* NO FREE CHANNELS: FIND VICTIM */
+
+	short		victim = -1;
+	float		victimLoudness = 0;
+	uint32_t	victimStamp = 0;
+
+	for (short c = 0; c < gMaxChannels; c++)
+	{
+		const ChannelInfoType* info = &gChannelInfo[c];
+		float chanLoudness = info->leftVolume + info->rightVolume;
+
+		if (victim == -1
+			|| chanLoudness < victimLoudness
+			|| (chanLoudness == victimLoudness && info->startStamp < victimStamp))
+		{
+			victim = c;
+			victimLoudness = chanLoudness;
+			victimStamp = info->startStamp;
+		}
+	}
+
+	if (victim == -1 || victimLoudness > (float) loudness)	// everything playing is louder than the new effect
+		return -1;
+
+	StopChannel(victim);									// (the old owner's handle goes stale once the new effect starts)
+
+	gVoiceStatsThisFrame.stolen++;
+	return victim;
 }
 
 
@@ -909,23 +1060,117 @@ SCStatus	theStatus;
 
 Boolean IsEffectChannelPlaying(short chanNum)
 {
-SCStatus	theStatus;
+	short c = GetChannelFromHandle(chanNum);
+	if (c < 0)
+		return false;
 
-	SndChannelStatus(gSndChannel[chanNum],sizeof(SCStatus),&theStatus);	// get channel info
-	return (theStatus.scChannelBusy);
+	return gChannelInfo[c].isBusy;
 }
 
 
+/********************** MAKE CHANNEL HANDLE ********************/
+
+static short MakeChannelHandle(short c)
+{
+	return (short) ((gChannelInfo[c].generation << CHANNEL_INDEX_BITS) | c);
+}
+
+
+/********************** GET CHANNEL FROM HANDLE ********************/
+//
+// Returns the channel index behind a handle returned by PlayEffect*,
+// or -1 if the handle is invalid or its voice has been reused since.
+//
+
+static short GetChannelFromHandle(short handle)
+{
+	if (handle < 0)
+		return -1;
+
+	short c = handle & CHANNEL_INDEX_MASK;
+	if (c >= gMaxChannels)
+		return -1;
+
+	if (handle != MakeChannelHandle(c))
+		return -1;
+
+	return c;
+}
+
+
+
+/******************** UPDATE 3D SOUND CHANNELS *********************/
+//
+// Recalculates the volume of every channel whose emitter moved this frame
+// (see Update3DSoundChannel) in one pass, then sends the new volumes to the
+// mixer. Channels whose volume didn't change aren't sent anything.
+//
+
+static void Update3DSoundChannels(void)
+{
+	int n = 0;
+
+			/* GATHER EMITTERS */
+
+	for (short c = 0; c < gMaxChannels; c++)
+	{
+		ChannelInfoType* info = &gChannelInfo[c];
+
+		if (!info->hasEmitterUpdate)
+			continue;
+
+		info->hasEmitterUpdate = false;
+
+		if (!info->isBusy || info->effectNum < 0)
+			continue;
+
+		float volAdjust = info->volumeAdjust;
+		if (info->effectNum == EFFECT_BUZZ)							// tone down annoying buzz effect
+			volAdjust *= .5f;
+
+		gEmitterChannel[n]		= c;
+		gEmitterX[n]			= info->emitterCoord.x;
+		gEmitterY[n]			= info->emitterCoord.y;
+		gEmitterZ[n]			= info->emitterCoord.z;
+		gEmitterRefDist[n]		= kEffectsTable[info->effectNum].refDistance;
+		gEmitterVolAdjust[n]	= volAdjust;
+		n++;
+	}
+
+	if (n == 0)
+		return;
+
+			/* CALC ALL VOLUMES AT ONCE */
+
+	Calc3DEffectVolumes(n, gEmitterX, gEmitterY, gEmitterZ, gEmitterRefDist, gEmitterVolAdjust, gEmitterLeftVol, gEmitterRightVol);
+
+			/* APPLY THEM */
+
+	for (int i = 0; i < n; i++)
+	{
+		short c = gEmitterChannel[i];
+		u_long leftVol = gEmitterLeftVol[i];
+		u_long rightVol = gEmitterRightVol[i];
+
+		if ((leftVol+rightVol) == 0)								// if volume goes to 0, then kill channel
+		{
+			StopChannel(c);											// (invalidates the owner's handle, so it sees -1 on its next update)
+			continue;
+		}
+
+		if ((float) leftVol != gChannelInfo[c].leftVolume
+			|| (float) rightVol != gChannelInfo[c].rightVolume)
+		{
+			SetChannelVolume(c, leftVol, rightVol);
+		}
+	}
+}
+
 
 /******************** CALC 3D EFFECT VOLUME *********************/
 
 static void Calc3DEffectVolume(short effectNum, TQ3Point3D *where, float volAdjust, u_long *leftVolOut, u_long *rightVolOut)
 {
-float	dist;
-float	refDist,volumeFactor;
-u_long	volume,left,right;
-u_long	maxLeft,maxRight;
-
 			/* TONE DOWN ANNOYING BUZZ EFFECT */
 
 	if (effectNum == EFFECT_BUZZ)
@@ -933,101 +1178,79 @@ u_long	maxLeft,maxRight;
 		volAdjust *= .5f;
 	}
 
-	dist 	= Q3Point3D_Distance(where, &gEarCoords);		// calc dist to sound for pane 0
-		
-			/* DO VOLUME CALCS */
-			
-	refDist = kEffectsTable[effectNum].refDistance;			// get ref dist
+	float refDist = kEffectsTable[effectNum].refDistance;
 
-	dist -= refDist;
-	if (dist <= EPS)
-		volumeFactor = 1.0f;
-	else
+	Calc3DEffectVolumes(1, &where->x, &where->y, &where->z, &refDist, &volAdjust, leftVolOut, rightVolOut);
+}
+
+
+/******************** CALC 3D EFFECT VOLUMES *********************/
+//
+// Calculates the stereo volume of n emitters at once.
+// Written as one branch-light loop over flat arrays so the compiler can vectorize it.
+//
+
+static void Calc3DEffectVolumes(int n, const float* x, const float* y, const float* z,
+								const float* refDist, const float* volAdjust,
+								u_long* leftVolOut, u_long* rightVolOut)
+{
+	const float earX = gEarCoords.x;
+	const float earY = gEarCoords.y;
+	const float earZ = gEarCoords.z;
+
+			/* CALC EYE LOOK VECTOR */
+
+	TQ3Vector2D lookVec;
+	FastNormalizeVector2D(gEyeVector.x, gEyeVector.z, &lookVec);
+
+	for (int i = 0; i < n; i++)
 	{
-		volumeFactor = 1.0f / (dist * VOLUME_DISTANCE_FACTOR);
-		if (volumeFactor > 1.0f)
+		const float dx = x[i] - earX;
+		const float dy = y[i] - earY;
+		const float dz = z[i] - earZ;
+
+				/* DO VOLUME CALCS */
+
+		float dist = sqrtf(dx*dx + dy*dy + dz*dz);				// calc dist to sound for pane 0
+		dist -= refDist[i];
+
+		float volumeFactor = 1.0f / (dist * VOLUME_DISTANCE_FACTOR);
+		if (dist <= EPS || volumeFactor > 1.0f)
 			volumeFactor = 1.0f;
-	}
-	
-	volume = (float)FULL_CHANNEL_VOLUME * volumeFactor * volAdjust;	
-	
-				
-	if (volume < 6)							// if really quiet, then just turn it off
-	{
-		*leftVolOut = *rightVolOut = 0;
-		return;
-	}
 
-			/************************/
-			/* DO STEREO SEPARATION */
-			/************************/
-	
-	else		
-	{
-		float		volF = (float)volume;
-		
+		u_long volume = (float)FULL_CHANNEL_VOLUME * volumeFactor * volAdjust[i];
+
+		float volF = (float)volume;
 		if (volF > 256.0f)
-		{
-//			printf("Sfx %d volume %f clipped\n", effectNum, volF);
 			volF = 256.0f;
-		}
-		
-		TQ3Vector2D	earToSound,lookVec;
-		float		dot,cross;
-		
-		maxLeft = maxRight = 0;
-		
-			/* CALC VECTOR TO SOUND */
-			
-		earToSound.x = where->x - gEarCoords.x;
-		earToSound.y = where->z - gEarCoords.z;
-		FastNormalizeVector2D(earToSound.x, earToSound.y, &earToSound);
-		
-		
-			/* CALC EYE LOOK VECTOR */
-			
-		FastNormalizeVector2D(gEyeVector.x, gEyeVector.z, &lookVec);
-			
 
-			/* DOT PRODUCT  TELLS US HOW MUCH STEREO SHIFT */
-			
-		dot = 1.0f - fabs(Q3Vector2D_Dot(&earToSound,  &lookVec));
-		if (dot < 0.0f)
-			dot = 0.0f;
-		else
-		if (dot > 1.0f)
-			dot = 1.0f;
+				/* CALC VECTOR TO SOUND */
+				//
+				// Same as FastNormalizeVector2D: a zero vector stays zero.
+				//
 
+		float invMag = 1.0f / (sqrtf(dx*dx + dz*dz) + FLT_MIN);
+		float toSoundX = dx * invMag;
+		float toSoundY = dz * invMag;
 
-			/* CROSS PRODUCT TELLS US WHICH SIDE */
-			
-		cross = Q3Vector2D_Cross(&earToSound,  &lookVec);
-		
-		
-				/* DO LEFT/RIGHT CALC */
-				
-		if (cross > 0.0f)
-		{
-			left 	= volF + (volF * dot);
-			right 	= volF - (volF * dot);
-		}
-		else
-		{
-			right 	= volF + (volF * dot);
-			left 	= volF - (volF * dot);
-		}
-		
-		
-				/* KEEP MAX */
-				
-		if (left > maxLeft)
-			maxLeft = left;
-		if (right > maxRight)
-			maxRight = right;
-				
-	}
+				/* DOT PRODUCT TELLS US HOW MUCH STEREO SHIFT */
 
-	*leftVolOut = maxLeft;
-	*rightVolOut = maxRight;		
-}
+		float dot = 1.0f - fabsf(toSoundX * lookVec.x + toSoundY * lookVec.y);
+		dot = ClampFloat(dot, 0.0f, 1.0f);
+
+				/* CROSS PRODUCT TELLS US WHICH SIDE */
+
+		float cross = toSoundX * lookVec.y - toSoundY * lookVec.x;
+
+		float louder = volF + (volF * dot);
+		float quieter = volF - (volF * dot);
 
+		u_long left		= cross > 0.0f ? louder : quieter;
+		u_long right	= cross > 0.0f ? quieter : louder;
+
+				/* IF REALLY QUIET, THEN JUST TURN IT OFF */
+
+		leftVolOut[i]	= volume < 6 ? 0 : left;
+		rightVolOut[i]	= volume < 6 ? 0 : right;
+	}
+}
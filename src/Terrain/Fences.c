@@ -14,7 +14,15 @@
 /*    PROTOTYPES            */
 /****************************/
 
+static void BuildFenceGeometry(int f);
 static void SubmitFence(int f, float camX, float camZ);
+static void BuildFenceSegmentGrid(void);
+static void DisposeFenceSegmentGrid(void);
+static void FindFenceSegmentsNearMotion(double x0, double z0, double x1, double z1, double radius);
+static void CollideWithFences(ObjNode *theNode, float radiusScale, Boolean useGrid);
+#if _DEBUG
+static void BenchmarkFenceCollision(void);
+#endif
 
 
 /****************************/
@@ -29,6 +37,8 @@ static void SubmitFence(int f, float camX, float camZ);
 
 #define	FENCE_SINK_FACTOR	40.0f
 
+#define	FENCE_GRID_CELL_SIZE	TERRAIN_SUPERTILE_UNIT_SIZE		// world size of a cell in the fence segment grid
+
 enum
 {
 	FENCE_TYPE_THORN,
@@ -55,6 +65,24 @@ static TQ3TriMeshData*			gFenceTriMeshDataPtrs[MAX_FENCES];
 static RenderModifiers			gFenceRenderMods[MAX_FENCES];
 static GLuint					gFenceTypeTextures[NUM_FENCE_SHADERS];
 
+static Byte						gFenceNumSuperTiles[MAX_FENCES];							// # of distinct supertiles that the fence's nubs are in
+static Byte						gFenceSuperTiles[MAX_FENCES][MAX_NUBS_IN_FENCE][2];		// row & col of each of those supertiles
+
+			/* SEGMENT GRID */
+			//
+			// Uniform grid over the map. Each cell lists the fence segments whose bbox overlaps it,
+			// packed as (fence * MAX_NUBS_IN_FENCE + segment).
+			//
+
+_Static_assert(MAX_NUBS_IN_FENCE <= 64, "segment masks below are 64-bit");
+_Static_assert(MAX_FENCES * MAX_NUBS_IN_FENCE <= 0xFFFF, "grid entries are 16-bit");
+
+static int						gFenceGridWidth = 0;
+static int						gFenceGridDepth = 0;
+static int32_t					*gFenceGridCellStart = nil;		// index of each cell's first entry; [numCells] = total # entries
+static uint16_t					*gFenceGridEntries = nil;
+static uint64_t					gFenceSegmentCandidates[MAX_FENCES];	// bit i set if segment i may be hit by the current motion
+
 
 static Boolean gFenceOnThisLevel[NUM_LEVEL_TYPES][NUM_FENCE_SHADERS] =
 {
@@ -144,6 +172,8 @@ void DisposeFences(void)
 		}
 	}
 
+	DisposeFenceSegmentGrid();
+
 			/* DISPOSE FENCE MESHES */
 
 	for (int f = 0; f < MAX_FENCES; f++)
@@ -272,6 +302,51 @@ FencePointType			*nubs;
 			tmd->triangles[j+1].pointIndices[2] = 2 + j;
 		}
 	}
+
+			/*********************************/
+			/* BUILD STATIC FENCE GEOMETRY   */
+			/*********************************/
+			//
+			// Fences only depend on the terrain & their nubs, so their meshes are built once here.
+			// Only the auto-fade transparency gets updated when they're drawn.
+			//
+
+	for (f = 0; f < gNumFences; f++)
+	{
+		BuildFenceGeometry(f);
+
+				/* REMEMBER WHICH SUPERTILES THE NUBS ARE IN */
+
+		nubs = *gFenceList[f].nubList;
+		gFenceNumSuperTiles[f] = 0;
+
+		for (i = 0; i < gFenceList[f].numNubs; i++)
+		{
+			long row = nubs[i].z / TERRAIN_SUPERTILE_UNIT_SIZE;			// calc supertile row,col
+			long col = nubs[i].x / TERRAIN_SUPERTILE_UNIT_SIZE;
+
+			for (j = 0; j < gFenceNumSuperTiles[f]; j++)					// already have it?
+			{
+				if (gFenceSuperTiles[f][j][0] == row && gFenceSuperTiles[f][j][1] == col)
+					break;
+			}
+
+			if (j == gFenceNumSuperTiles[f])
+			{
+				gFenceSuperTiles[f][j][0] = row;
+				gFenceSuperTiles[f][j][1] = col;
+				gFenceNumSuperTiles[f]++;
+			}
+		}
+	}
+
+			/* BIN SEGMENTS FOR COLLISION */
+
+	BuildFenceSegmentGrid();
+
+#if _DEBUG
+	BenchmarkFenceCollision();
+#endif
 }
 
 
@@ -279,8 +354,7 @@ FencePointType			*nubs;
 
 void DrawFences(const QD3DSetupOutputType *setupInfo)
 {
-long			row,col,numNubs,type;
-FencePointType	*nubs;
+long			type;
 float			cameraX, cameraZ;
 
 			/* GET CAMERA COORDS */
@@ -306,15 +380,9 @@ float			cameraX, cameraZ;
 
 			/* SEE IF THIS FENCE IS VISIBLE AT ALL */
 			
-		numNubs = gFenceList[f].numNubs;
-		nubs = *gFenceList[f].nubList;
-		
-		for (int n = 0; n < numNubs; n++)
+		for (int n = 0; n < gFenceNumSuperTiles[f]; n++)	// see if any supertile the fence is in is active
 		{
-			row = nubs[n].z / TERRAIN_SUPERTILE_UNIT_SIZE;	// calc supertile row,col
-			col = nubs[n].x / TERRAIN_SUPERTILE_UNIT_SIZE;
-			
-			if (gTerrainScrollBuffer[row][col] != EMPTY_SUPERTILE)
+			if (gTerrainScrollBuffer[gFenceSuperTiles[f][n][0]][gFenceSuperTiles[f][n][1]] != EMPTY_SUPERTILE)
 				goto drawit;
 		}
 		gIsFenceVisible[f] = false;
@@ -350,6 +418,19 @@ drawit:
 //
 
 void DoFenceCollision(ObjNode *theNode, float radiusScale)
+{
+	CollideWithFences(theNode, radiusScale, true);
+}
+
+
+/******************** COLLIDE WITH FENCES **************************/
+//
+// INPUT:	useGrid = only test the segments that the segment grid says are near the motion.
+//					  Segments the grid rules out can neither intersect the motion nor have an
+//					  endpoint within the radius, so the outcome is the same as testing them all.
+//
+
+static void CollideWithFences(ObjNode *theNode, float radiusScale, Boolean useGrid)
 {
 double			fromX,fromZ,toX,toZ;
 long			f,numFenceSegments,i,numReScans;
@@ -371,6 +452,9 @@ double			oldX,oldZ,newX,newZ;
 	newZ = gCoord.z;
 	radius = theNode->BoundingSphere.radius * radiusScale;
 
+	if (useGrid)
+		FindFenceSegmentsNearMotion(oldX, oldZ, newX, newZ, radius);
+
 
 
 			/****************************************/
@@ -428,6 +512,9 @@ double			oldX,oldZ,newX,newZ;
 		numReScans = 0;	
 		for (i = 0; i < numFenceSegments; i++)
 		{
+			if (useGrid && !(gFenceSegmentCandidates[f] & (1ull << i)))	// skip segments that are nowhere near
+				continue;
+
 					/* GET LINE SEG ENDPOINTS */
 					
 			segFromX = nubs[i].x;
@@ -500,6 +587,10 @@ double			oldX,oldZ,newX,newZ;
 						
 				newX = gCoord.x;
 				newZ = gCoord.z;
+
+				if (useGrid)										// motion changed, so get new candidates
+					FindFenceSegmentsNearMotion(oldX, oldZ, newX, newZ, radius);
+
 				if (++numReScans < 5)
 					i = -1;							// reset segment index to scan all again (reset to -1 because for loop will auto-inc to 0 for us)
 			}
@@ -543,12 +634,12 @@ next_fence:;
 }
 
 
-/******************** SUBMIT FENCE **************************/
+/******************** BUILD FENCE GEOMETRY **************************/
 //
-// Visibility checks have already been done, so there's a good chance the fence is visible
+// Builds the fence's trimesh from its nubs & the terrain. Called once from PrimeFences.
 //
 
-static void SubmitFence(int f, float camX, float camZ)
+static void BuildFenceGeometry(int f)
 {
 u_short					type;
 float					u,height;
@@ -556,6 +647,10 @@ long					i,numNubs,j;
 FenceDefType			*fence;
 FencePointType			*nubs;
 TQ3TriMeshData			*tmd;
+float					nubX[MAX_NUBS_IN_FENCE];
+float					nubZ[MAX_NUBS_IN_FENCE];
+float					floorY[MAX_NUBS_IN_FENCE];
+float					ceilingY[MAX_NUBS_IN_FENCE];
 
 			/* GET FENCE INFO */
 
@@ -591,9 +686,38 @@ TQ3TriMeshData			*tmd;
 	tmd->bBox.max.z = gFenceList[f].bBox.bottom;
 
 
-			/************************************/
-			/* BUILD POINTS, UV's & TRANSP LIST */
-			/************************************/
+			/*****************************/
+			/* GET TERRAIN Y AT ALL NUBS */
+			/*****************************/
+
+	for (i = 0; i < numNubs; i++)
+	{
+		nubX[i] = nubs[i].x;
+		nubZ[i] = nubs[i].z;
+	}
+
+	switch(type)
+	{
+		case	FENCE_TYPE_MOSS:
+				GetTerrainHeightsAtCoords(numNubs, nubX, nubZ, CEILING, ceilingY);
+				break;
+
+		case	FENCE_TYPE_WOOD:
+				break;
+
+		case	FENCE_TYPE_HIVE:
+				GetTerrainHeightsAtCoords(numNubs, nubX, nubZ, FLOOR, floorY);
+				GetTerrainHeightsAtCoords(numNubs, nubX, nubZ, CEILING, ceilingY);
+				break;
+
+		default:
+				GetTerrainHeightsAtCoords(numNubs, nubX, nubZ, FLOOR, floorY);
+	}
+
+
+			/***************************/
+			/* BUILD POINTS, UV's      */
+			/***************************/
 
 	switch(type)
 	{
@@ -611,13 +735,13 @@ TQ3TriMeshData			*tmd;
 	{
 		float		x,y,z,y2;
 
-		x = nubs[i].x;
-		z = nubs[i].z;
+		x = nubX[i];
+		z = nubZ[i];
 		
 		switch(type)
 		{
 			case	FENCE_TYPE_MOSS:
-					y = GetTerrainHeightAtCoord(x, z, CEILING);			
+					y = ceilingY[i];
 					y += FENCE_SINK_FACTOR;										// sink into ceiling a little bit
 					y2 = y + height;
 					break;
@@ -628,14 +752,14 @@ TQ3TriMeshData			*tmd;
 					break;
 		
 			case	FENCE_TYPE_HIVE:
-					y = GetTerrainHeightAtCoord(x, z, FLOOR);			
+					y = floorY[i];
 					y -= FENCE_SINK_FACTOR;	
-					y2 = GetTerrainHeightAtCoord(x, z, CEILING);
+					y2 = ceilingY[i];
 					y2 += FENCE_SINK_FACTOR;
 					break;
 		
 			default:
-					y = GetTerrainHeightAtCoord(x, z, FLOOR);			
+					y = floorY[i];
 					y -= FENCE_SINK_FACTOR;										// sink into ground a little bit
 					y2 = y + height;
 		}
@@ -658,25 +782,6 @@ TQ3TriMeshData			*tmd;
 		tmd->vertexUVs[j].v		= 1;
 		tmd->vertexUVs[j+1].v	= 0;
 		tmd->vertexUVs[j].u		= tmd->vertexUVs[j+1].u = u;
-
-
-				/* CALC & SET TRANSPARENCY */
-
-		if (gDoAutoFade)											// see if this level has xparency
-		{
-			float dist = CalcQuickDistance(camX, camZ, x, z);		// see if in fade zone
-			if (dist < gAutoFadeStartDist)	
-				dist = 1.0;
-			else
-			{
-				dist -= gAutoFadeStartDist;							// calc xparency %
-				dist = 1.0f - (dist / AUTO_FADE_RANGE);
-				if (dist < 0.0f)
-					dist = 0;
-			}
-			tmd->vertexColors[j+0].a = dist;						// set xparency value
-			tmd->vertexColors[j+1].a = dist;
-		}
 	}
 
 			/**************************************************/
@@ -713,6 +818,41 @@ TQ3TriMeshData			*tmd;
 			Q3Vector3D_Normalize(&tmd->vertexNormals[j], &tmd->vertexNormals[j]);
 		}
 	}
+}
+
+
+/******************** SUBMIT FENCE **************************/
+//
+// Visibility checks have already been done, so there's a good chance the fence is visible.
+// The geometry was built in PrimeFences, so all that's left is the auto-fade transparency.
+//
+
+static void SubmitFence(int f, float camX, float camZ)
+{
+TQ3TriMeshData	*tmd = gFenceTriMeshDataPtrs[f];
+
+			/* CALC & SET TRANSPARENCY */
+
+	if (gDoAutoFade)												// see if this level has xparency
+	{
+		const FencePointType* nubs = *gFenceList[f].nubList;
+
+		for (long i = 0, j = 0; i < gFenceList[f].numNubs; i++, j+=2)
+		{
+			float dist = CalcQuickDistance(camX, camZ, nubs[i].x, nubs[i].z);	// see if in fade zone
+			if (dist < gAutoFadeStartDist)	
+				dist = 1.0;
+			else
+			{
+				dist -= gAutoFadeStartDist;							// calc xparency %
+				dist = 1.0f - (dist / AUTO_FADE_RANGE);
+				if (dist < 0.0f)
+					dist = 0;
+			}
+			tmd->vertexColors[j+0].a = dist;						// set xparency value
+			tmd->vertexColors[j+1].a = dist;
+		}
+	}
 
 		/*******************/
 		/* SUBMIT GEOMETRY */
@@ -721,3 +861,226 @@ TQ3TriMeshData			*tmd;
 	Render_SubmitMesh(tmd, nil, &gFenceRenderMods[f], nil);
 }
 
+
+#pragma mark -
+
+/******************** BUILD FENCE SEGMENT GRID **************************/
+
+static inline int FenceGridCellX(double x)
+{
+	int cx = (int) floor(x * (1.0 / FENCE_GRID_CELL_SIZE));
+	if (cx < 0) cx = 0;
+	if (cx >= gFenceGridWidth) cx = gFenceGridWidth-1;
+	return cx;
+}
+
+static inline int FenceGridCellZ(double z)
+{
+	int cz = (int) floor(z * (1.0 / FENCE_GRID_CELL_SIZE));
+	if (cz < 0) cz = 0;
+	if (cz >= gFenceGridDepth) cz = gFenceGridDepth-1;
+	return cz;
+}
+
+static void BuildFenceSegmentGrid(void)
+{
+	DisposeFenceSegmentGrid();
+
+	gFenceGridWidth = (gTerrainUnitWidth + FENCE_GRID_CELL_SIZE - 1) / FENCE_GRID_CELL_SIZE;
+	gFenceGridDepth = (gTerrainUnitDepth + FENCE_GRID_CELL_SIZE - 1) / FENCE_GRID_CELL_SIZE;
+	if (gFenceGridWidth < 1) gFenceGridWidth = 1;
+	if (gFenceGridDepth < 1) gFenceGridDepth = 1;
+
+	int numCells = gFenceGridWidth * gFenceGridDepth;
+
+	gFenceGridCellStart = (int32_t*) NewPtrClear(sizeof(int32_t) * (numCells + 1));
+	GAME_ASSERT(gFenceGridCellStart);
+
+			/* PASS 1: COUNT ENTRIES PER CELL, PASS 2: FILL THEM IN */
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		if (pass == 1)
+		{
+			int32_t total = 0;											// turn counts into start offsets
+			for (int c = 0; c <= numCells; c++)
+			{
+				int32_t count = gFenceGridCellStart[c];
+				gFenceGridCellStart[c] = total;
+				total += count;
+			}
+
+			gFenceGridEntries = (uint16_t*) AllocPtr(sizeof(uint16_t) * (total > 0 ? total : 1));
+			GAME_ASSERT(gFenceGridEntries);
+		}
+
+		for (int f = 0; f < gNumFences; f++)
+		{
+			const FencePointType* nubs = *gFenceList[f].nubList;
+
+			for (int i = 0; i < gFenceList[f].numNubs-1; i++)
+			{
+				int x0 = FenceGridCellX(fmin(nubs[i].x, nubs[i+1].x));
+				int x1 = FenceGridCellX(fmax(nubs[i].x, nubs[i+1].x));
+				int z0 = FenceGridCellZ(fmin(nubs[i].z, nubs[i+1].z));
+				int z1 = FenceGridCellZ(fmax(nubs[i].z, nubs[i+1].z));
+
+				for (int cz = z0; cz <= z1; cz++)
+				{
+					for (int cx = x0; cx <= x1; cx++)
+					{
+						int c = cz * gFenceGridWidth + cx;
+						if (pass == 0)
+							gFenceGridCellStart[c]++;
+						else
+							gFenceGridEntries[gFenceGridCellStart[c]++] = f * MAX_NUBS_IN_FENCE + i;
+					}
+				}
+			}
+		}
+	}
+
+			/* FILLING ADVANCED EACH START TO THE NEXT CELL'S, SO SHIFT BACK */
+
+	for (int c = numCells; c > 0; c--)
+		gFenceGridCellStart[c] = gFenceGridCellStart[c-1];
+	gFenceGridCellStart[0] = 0;
+}
+
+
+/******************** DISPOSE FENCE SEGMENT GRID **************************/
+
+static void DisposeFenceSegmentGrid(void)
+{
+	if (gFenceGridCellStart)
+	{
+		DisposePtr((Ptr) gFenceGridCellStart);
+		gFenceGridCellStart = nil;
+	}
+
+	if (gFenceGridEntries)
+	{
+		DisposePtr((Ptr) gFenceGridEntries);
+		gFenceGridEntries = nil;
+	}
+
+	gFenceGridWidth = 0;
+	gFenceGridDepth = 0;
+}
+
+
+/******************** FIND FENCE SEGMENTS NEAR MOTION **************************/
+//
+// Fills gFenceSegmentCandidates with every segment that has a grid cell in common with the
+// bbox of the motion from x0/z0 to x1/z1, grown by the radius.
+// The motion line that's tested in CollideWithFences is pushed back by at most the radius
+// (along a unit normal), and the endpoint check uses CalcQuickDistance, which is never less
+// than the distance on either axis, so anything that can collide is inside this box.
+//
+
+static void FindFenceSegmentsNearMotion(double x0, double z0, double x1, double z1, double radius)
+{
+	memset(gFenceSegmentCandidates, 0, sizeof(gFenceSegmentCandidates));
+
+	if (!gFenceGridEntries)
+		return;
+
+	double margin = radius * 1.001 + 1.0;							// a little extra for float rounding
+
+	int cx0 = FenceGridCellX(fmin(x0, x1) - margin);
+	int cx1 = FenceGridCellX(fmax(x0, x1) + margin);
+	int cz0 = FenceGridCellZ(fmin(z0, z1) - margin);
+	int cz1 = FenceGridCellZ(fmax(z0, z1) + margin);
+
+	for (int cz = cz0; cz <= cz1; cz++)
+	{
+		for (int cx = cx0; cx <= cx1; cx++)
+		{
+			int c = cz * gFenceGridWidth + cx;
+
+			for (int32_t e = gFenceGridCellStart[c]; e < gFenceGridCellStart[c+1]; e++)
+			{
+				int entry = gFenceGridEntries[e];
+				gFenceSegmentCandidates[entry / MAX_NUBS_IN_FENCE] |= 1ull << (entry % MAX_NUBS_IN_FENCE);
+			}
+		}
+	}
+}
+
+
+#if _DEBUG
+/******************** BENCHMARK FENCE COLLISION **************************/
+//
+// Sweeps a probe object across the level's fences with and without the segment grid,
+// checks that both paths push back identically, and prints how long each took.
+//
+
+static void BenchmarkFenceCollision(void)
+{
+	if (gNumFences == 0)
+		return;
+
+	ObjNode			probe;
+	TQ3Point3D		savedCoord = gCoord;
+	TQ3Vector3D		savedDelta = gDelta;
+	Boolean			savedVisible[MAX_FENCES];
+	double			totalMS[2] = {0, 0};
+	int				numMismatches = 0;
+	int				numProbes = 0;
+
+	memcpy(savedVisible, gIsFenceVisible, sizeof(savedVisible));
+	for (int f = 0; f < gNumFences; f++)
+		gIsFenceVisible[f] = true;
+
+	memset(&probe, 0, sizeof(probe));
+	probe.BoundingSphere.radius = 100;
+	probe.BottomOff = 0;
+
+	for (int f = 0; f < gNumFences; f++)
+	{
+		const FencePointType* nubs = *gFenceList[f].nubList;
+
+		for (int i = 0; i < gFenceList[f].numNubs-1; i++)
+		{
+					/* CROSS THIS SEGMENT AT ITS MIDPOINT */
+
+			float mx = (nubs[i].x + nubs[i+1].x) * .5f;
+			float mz = (nubs[i].z + nubs[i+1].z) * .5f;
+			TQ3Vector2D n = { -gFenceList[f].sectionVectors[i].y, gFenceList[f].sectionVectors[i].x };
+
+			TQ3Point3D	result[2];
+			TQ3Vector3D	resultDelta[2];
+
+			for (int useGrid = 0; useGrid < 2; useGrid++)
+			{
+				probe.OldCoord = (TQ3Point3D) { mx - n.x * 150, -10000, mz - n.y * 150 };
+				gCoord = (TQ3Point3D) { mx + n.x * 150, -10000, mz + n.y * 150 };
+				gDelta = (TQ3Vector3D) { n.x * 500, 0, n.y * 500 };
+
+				uint64_t start = GetProfilingTimestamp();
+				CollideWithFences(&probe, 1, useGrid);
+				totalMS[useGrid] += GetMillisecondsSince(start);
+
+				result[useGrid] = gCoord;
+				resultDelta[useGrid] = gDelta;
+			}
+
+			if (0 != memcmp(&result[0], &result[1], sizeof(result[0]))
+				|| 0 != memcmp(&resultDelta[0], &resultDelta[1], sizeof(resultDelta[0])))
+			{
+				numMismatches++;
+			}
+
+			numProbes++;
+		}
+	}
+
+	printf("Fence collision: %d probes, brute force %.3f ms, grid %.3f ms, %d mismatches\n",
+			numProbes, totalMS[0], totalMS[1], numMismatches);
+	GAME_ASSERT_MESSAGE(numMismatches == 0, "Fence segment grid changed collision results");
+
+	memcpy(gIsFenceVisible, savedVisible, sizeof(savedVisible));
+	gCoord = savedCoord;
+	gDelta = savedDelta;
+}
+#endif
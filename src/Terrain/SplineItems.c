@@ -17,6 +17,10 @@
 /****************************/
 
 static Boolean NilPrime(long splineNum, SplineItemType *itemPtr);
+static void BuildSplineArcLengths(SplineDefType* spline);
+static void BuildSplineSuperTileList(SplineDefType* spline, Byte* cellSeen);
+static Boolean IsSplineOnActiveSuperTile(const SplineDefType* spline);
+static float GetSplinePointSpacing(const SplineDefType* spline);
 
 
 /****************************/
@@ -133,6 +137,21 @@ SplinePointType	*points;
 		}
 
 	}	
+
+
+			/* BUILD LOOKUP TABLES FOR EACH SPLINE */
+
+	Byte* cellSeen = (Byte*) AllocPtr(gNumSuperTilesDeep * gNumSuperTilesWide);
+	GAME_ASSERT(cellSeen);
+
+	for (s = 0; s < gNumSplines; s++)
+	{
+		spline = &(*gSplineList)[s];
+		BuildSplineArcLengths(spline);
+		BuildSplineSuperTileList(spline, cellSeen);
+	}
+
+	DisposePtr((Ptr) cellSeen);
 	
 	
 				/* CLEAR SPLINE OBJECT LIST */
@@ -174,6 +193,136 @@ static Boolean NilPrime(long splineNum, SplineItemType *itemPtr)
 }
 
 
+/******************** BUILD SPLINE ARC LENGTHS ***********************/
+//
+// Cumulative distance along the spline at each point.
+// The last entry closes the loop back to point 0, the same way GetCoordOnSpline wraps.
+//
+
+static void BuildSplineArcLengths(SplineDefType* spline)
+{
+	int numPoints = spline->numPoints;
+	const SplinePointType* points = *spline->pointList;
+
+	GAME_ASSERT(!spline->arcLengths);
+
+	spline->arcLengths = (float*) AllocPtr(sizeof(float) * (numPoints + 1));
+	GAME_ASSERT(spline->arcLengths);
+
+	float distance = 0;
+	spline->arcLengths[0] = 0;
+
+	for (int i = 0; i < numPoints; i++)
+	{
+		const SplinePointType* next = &points[(i < numPoints - 1) ? (i + 1) : 0];
+		distance += CalcDistance(points[i].x, points[i].z, next->x, next->z);
+		spline->arcLengths[i + 1] = distance;
+	}
+}
+
+
+/******************** BUILD SPLINE SUPERTILE LIST ***********************/
+//
+// Remembers which supertiles the spline passes through.
+// Each segment marks every supertile in its bounding box, so any coord lerped
+// between two points (see GetCoordOnSpline) is on one of the listed supertiles.
+//
+// cellSeen is a zeroed scratch array with one byte per supertile; it's zeroed again on exit.
+//
+
+static void BuildSplineSuperTileList(SplineDefType* spline, Byte* cellSeen)
+{
+	const SplinePointType* points = *spline->pointList;
+	const int numPoints = spline->numPoints;
+	int numSuperTiles = 0;
+
+	GAME_ASSERT(!spline->superTiles);
+
+	for (int pass = 0; pass < 2; pass++)							// pass 0 counts, pass 1 fills in the list
+	{
+		if (pass == 1)
+		{
+			spline->superTiles = (Byte (*)[2]) AllocPtr(sizeof(spline->superTiles[0]) * (numSuperTiles + 1));
+			GAME_ASSERT(spline->superTiles);
+			numSuperTiles = 0;
+		}
+
+		for (int i = 0; i < numPoints; i++)
+		{
+			const SplinePointType* next = &points[(i < numPoints - 1) ? (i + 1) : 0];	// last segment closes the loop
+
+			int row1 = points[i].z * (1.0f/TERRAIN_SUPERTILE_UNIT_SIZE);
+			int col1 = points[i].x * (1.0f/TERRAIN_SUPERTILE_UNIT_SIZE);
+			int row2 = next->z * (1.0f/TERRAIN_SUPERTILE_UNIT_SIZE);
+			int col2 = next->x * (1.0f/TERRAIN_SUPERTILE_UNIT_SIZE);
+
+			int minRow = row1 < row2 ? row1 : row2;
+			int maxRow = row1 < row2 ? row2 : row1;
+			int minCol = col1 < col2 ? col1 : col2;
+			int maxCol = col1 < col2 ? col2 : col1;
+
+			if (minRow < 0)						minRow = 0;					// stay on the map
+			if (maxRow >= gNumSuperTilesDeep)	maxRow = gNumSuperTilesDeep - 1;
+			if (minCol < 0)						minCol = 0;
+			if (maxCol >= gNumSuperTilesWide)	maxCol = gNumSuperTilesWide - 1;
+
+			for (int row = minRow; row <= maxRow; row++)
+			{
+				for (int col = minCol; col <= maxCol; col++)
+				{
+					Byte* seen = &cellSeen[row * gNumSuperTilesWide + col];
+
+					if (*seen == pass)									// not counted (pass 0) / not listed (pass 1) yet
+					{
+						*seen = pass + 1;
+						if (pass == 1)
+						{
+							spline->superTiles[numSuperTiles][0] = row;
+							spline->superTiles[numSuperTiles][1] = col;
+						}
+						numSuperTiles++;
+					}
+				}
+			}
+		}
+	}
+
+	spline->numSuperTiles = numSuperTiles;
+	spline->isOnActiveSuperTile = false;						// updated by MoveSplineObjects
+
+	for (int i = 0; i < numSuperTiles; i++)							// reset scratch array for next spline
+		cellSeen[spline->superTiles[i][0] * gNumSuperTilesWide + spline->superTiles[i][1]] = 0;
+}
+
+
+/******************** IS SPLINE ON ACTIVE SUPERTILE ***********************/
+
+static Boolean IsSplineOnActiveSuperTile(const SplineDefType* spline)
+{
+	for (int i = 0; i < spline->numSuperTiles; i++)
+	{
+		if (gTerrainScrollBuffer[spline->superTiles[i][0]][spline->superTiles[i][1]] != EMPTY_SUPERTILE)
+			return true;
+	}
+
+	return false;
+}
+
+
+
+/******************* GET SPLINE POINT SPACING **********************/
+//
+// Average distance between two consecutive points of the spline, in world units.
+//
+
+static float GetSplinePointSpacing(const SplineDefType* spline)
+{
+	GAME_ASSERT(spline->arcLengths);
+	GAME_ASSERT(spline->numPoints > 0);
+
+	return spline->arcLengths[spline->numPoints] / spline->numPoints;
+}
+
 
 /*********************** GET COORD ON SPLINE **********************/
 
@@ -208,6 +357,68 @@ int GetCoordOnSpline(const SplineDefType* spline, float placement, float* x, flo
 }
 
 
+/******************* GET SPLINE DISTANCE AT PLACEMENT **********************/
+//
+// Converts a placement (0..1) to a distance along the spline, in world units.
+//
+
+float GetSplineDistanceAtPlacement(const SplineDefType* spline, float placement)
+{
+	const float* arcLengths = spline->arcLengths;
+
+	GAME_ASSERT(arcLengths);
+
+	placement = ClampFloat(placement, 0, MAX_PLACEMENT);
+
+	float scaledPlacement = placement * spline->numPoints;
+	int index = (int)(scaledPlacement);
+	float interpointFrac = scaledPlacement - index;
+
+	return arcLengths[index] + (arcLengths[index + 1] - arcLengths[index]) * interpointFrac;
+}
+
+
+/******************* GET SPLINE PLACEMENT AT DISTANCE **********************/
+//
+// Converts a distance along the spline (world units, wraps around) to a placement.
+// Binary search in the arc length table.
+//
+
+float GetSplinePlacementAtDistance(const SplineDefType* spline, float distance)
+{
+	const float* arcLengths = spline->arcLengths;
+	int numPoints = spline->numPoints;
+
+	GAME_ASSERT(arcLengths);
+
+	float length = arcLengths[numPoints];
+	if (length <= 0)
+		return 0;
+
+	distance = fmodf(distance, length);								// loop around
+	if (distance < 0)
+		distance += length;
+
+			/* FIND LAST POINT AT OR BEFORE THIS DISTANCE */
+
+	int lo = 0;
+	int hi = numPoints - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) / 2;
+		if (arcLengths[mid] <= distance)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	float segmentLength = arcLengths[lo + 1] - arcLengths[lo];
+	float interpointFrac = segmentLength > 0 ? (distance - arcLengths[lo]) / segmentLength : 0;
+
+	return ClampFloat((lo + interpointFrac) / numPoints, 0, MAX_PLACEMENT);
+}
+
+
 /********************* IS SPLINE ITEM VISIBLE ********************/
 //
 // Returns true if the input objnode is in visible range.
@@ -220,6 +431,14 @@ Boolean IsSplineItemVisible(ObjNode *theNode)
 Boolean	visible = true;
 long	row,col;
 
+			/* IF SPLINE DOESN'T TOUCH ANY ACTIVE SUPERTILE, THEN NOT VISIBLE */
+
+	if (!(*gSplineList)[theNode->SplineNum].isOnActiveSuperTile)
+	{
+		visible = false;
+		goto update;
+	}
+
 			/* IF IS ON AN ACTIVE SUPERTILE, THEN ASSUME VISIBLE */
 
 	row = theNode->Coord.z * (1.0f/TERRAIN_SUPERTILE_UNIT_SIZE);	// calc supertile row,col
@@ -233,6 +452,7 @@ long	row,col;
 
 			/* HANDLE OBJNODE UPDATES */			
 
+update:
 	if (visible)
 	{
 		if (theNode->StatusBits & STATUS_BIT_DETACHED)			// see if need to insert into linked list
@@ -327,6 +547,16 @@ void MoveSplineObjects(void)
 long	i;
 ObjNode	*theNode;
 
+			/* SEE WHICH SPLINES ARE IN RANGE THIS FRAME */
+
+	for (i = 0; i < gNumSplines; i++)
+	{
+		SplineDefType* spline = &(*gSplineList)[i];
+		spline->isOnActiveSuperTile = IsSplineOnActiveSuperTile(spline);
+	}
+
+			/* MOVE THE OBJECTS */
+
 	for (i = 0; i < gNumSplineObjects; i++)
 	{
 		theNode = gSplineObjectList[i];
@@ -353,60 +583,69 @@ int GetObjectCoordOnSpline(ObjNode* theNode, float* x, float* z)
 
 /******************* INCREASE SPLINE INDEX *********************/
 //
-// Moves objects on spline at given speed
+// Moves objects on spline at given speed, in spline points per second.
+//
+// The speed is converted to world units using the spline's average point spacing,
+// so an object still takes as long to go around the loop as it used to, but it no
+// longer speeds up and slows down where the points are packed unevenly.
 //
 
 float IncreaseSplineIndex(ObjNode *theNode, float speed)
 {
-	SplineDefType* spline = &(*gSplineList)[theNode->SplineNum];
+	const SplineDefType* spline = &(*gSplineList)[theNode->SplineNum];
 
-	float placement = theNode->SplinePlacement;
+	return IncreaseSplineDistance(theNode, speed * GetSplinePointSpacing(spline));
+}
 
-	placement += speed * gFramesPerSecondFrac / spline->numPoints;
 
-	if (placement > MAX_PLACEMENT)
-	{
-		// Loop to start
-		placement -= 1.0f;
-		placement = ClampFloat(placement, 0, MAX_PLACEMENT);
-	}
-	else if (placement < 0)
-	{
-		// Loop to end
-		placement += 1.0f;
-		placement = ClampFloat(placement, 0, MAX_PLACEMENT);
-	}
+/******************* INCREASE SPLINE DISTANCE *********************/
+//
+// Moves objects on spline at a constant speed in world units per second,
+// regardless of how tightly the spline's points are packed.
+//
+
+float IncreaseSplineDistance(ObjNode *theNode, float unitsPerSecond)
+{
+	const SplineDefType* spline = &(*gSplineList)[theNode->SplineNum];
 
-	theNode->SplinePlacement = placement;
+	float distance = GetSplineDistanceAtPlacement(spline, theNode->SplinePlacement);
 
-	return placement;
+	distance += unitsPerSecond * gFramesPerSecondFrac;
+
+	theNode->SplinePlacement = GetSplinePlacementAtDistance(spline, distance);	// loops around
+
+	return theNode->SplinePlacement;
 }
 
 
 /******************* INCREASE SPLINE INDEX ZIGZAG *********************/
 //
-// Moves objects on spline at given speed, but zigzags
+// Moves objects on spline at given speed (in spline points per second, like
+// IncreaseSplineIndex), but zigzags
 //
 
 float IncreaseSplineIndexZigZag(ObjNode *theNode, float speed)
 {
-SplineDefType	*splinePtr;
-float			numPointsInSpline;
-
-	speed *= gFramesPerSecondFrac;
+const SplineDefType	*splinePtr;
+float				distance, length;
 
 	splinePtr = &(*gSplineList)[theNode->SplineNum];			// point to the spline
-	numPointsInSpline = splinePtr->numPoints;					// get # points in the spline
+	length = splinePtr->arcLengths[splinePtr->numPoints];		// get length of the spline
+
+	speed *= GetSplinePointSpacing(splinePtr) * gFramesPerSecondFrac;
+
+	distance = GetSplineDistanceAtPlacement(splinePtr, theNode->SplinePlacement);
 
 			/* GOING BACKWARD */
 
 	if (theNode->StatusBits & STATUS_BIT_REVERSESPLINE)			// see if going backward
 	{
-		theNode->SplinePlacement -= speed / numPointsInSpline;
-		if (theNode->SplinePlacement <= 0.0f)
+		distance -= speed;
+		if (distance <= 0.0f)
 		{
 			theNode->SplinePlacement = 0;
 			theNode->StatusBits ^= STATUS_BIT_REVERSESPLINE;	// toggle direction
+			return theNode->SplinePlacement;
 		}
 	}
 
@@ -414,16 +653,17 @@ float			numPointsInSpline;
 
 	else
 	{
-		theNode->SplinePlacement += speed / numPointsInSpline;
-		if (theNode->SplinePlacement >= MAX_PLACEMENT)
+		distance += speed;
+		if (distance >= length)
 		{
 			theNode->SplinePlacement = MAX_PLACEMENT;
-			GAME_ASSERT(theNode->SplinePlacement >= 0);
-			GAME_ASSERT(theNode->SplinePlacement < 1);
 			theNode->StatusBits ^= STATUS_BIT_REVERSESPLINE;	// toggle direction
+			return theNode->SplinePlacement;
 		}
 	}
 
+	theNode->SplinePlacement = GetSplinePlacementAtDistance(splinePtr, distance);
+
 	return theNode->SplinePlacement;
 }
 
@@ -445,8 +685,7 @@ void DrawSplines(void)
 		const SplinePointType* nubs = *spline->nubList;
 		const int halfway = spline->numPoints / 2;
 
-		if (IsPositionOutOfRange(points[0].x, points[0].z)
-			&& IsPositionOutOfRange(points[halfway].x, points[halfway].z))
+		if (!IsSplineOnActiveSuperTile(spline))
 		{
 			continue;
 		}
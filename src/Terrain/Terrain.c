@@ -10,6 +10,7 @@
 /***************/
 
 #include "game.h"
+#include "simd.h"
 #include <stdio.h>
 
 
@@ -27,11 +28,18 @@ static void CalcNewItemDeleteWindow(void);
 static short	BuildTerrainSuperTile(long	startCol, long startRow);
 static Boolean IsSuperTileVisible(int32_t superTileNum, Byte layer);
 static void DrawTileIntoMipmap(uint16_t tile, int row, int col, uint16_t* buffer);
+static void DrawSuperTileTextureSeams(int layer, long startRow, long startCol, uint16_t* buffer);
+static void BlitOrientedTile(const uint16_t* tileData, uint16_t flipRotBits, uint16_t* buffer, int bufWidth);
+static void BuildTileAtlas(void);
+static void DisposeTileAtlas(void);
 static void	ShrinkSuperTileTextureMap(const u_short *srcPtr,u_short *destPtr);
 //static void	ShrinkSuperTileTextureMapTo64(u_short *srcPtr,u_short *destPtr);
 static void ShrinkHalf(const uint16_t* input, uint16_t* output, int outputSize);
 static inline void ReleaseAllSuperTiles(void);
 static void BuildSuperTileLOD(SuperTileMemoryType *superTilePtr, short lod);
+static void PrecomputeTerrainLighting(void);
+static void DisposeTerrainLighting(void);
+static void BuildFarSuperTileIndices(void);
 
 
 /****************************/
@@ -45,6 +53,9 @@ static void BuildSuperTileLOD(SuperTileMemoryType *superTilePtr, short lod);
 #define TILE_TEXTURE_FORMAT				GL_BGRA_EXT
 #define TILE_TEXTURE_TYPE				GL_UNSIGNED_SHORT_1_5_5_5_REV
 
+#define	FAR_SUPERTILE_DIST			1700.0f		// supertiles farther than this are drawn with the decimated mesh
+#define	NUM_TRIS_IN_FAR_SUPERTILE	(4*6 + 2)	// 6 triangles per side of the border ring + 2 for the inner quad
+
 
 /**********************/
 /*     VARIABLES      */
@@ -88,6 +99,64 @@ static int		gTextureSizePerLOD[MAX_LODS] = { 0, 0, 0 };
 
 static RenderModifiers gTerrainRenderMods;
 
+static TQ3Vector3D	*gTerrainVertexNormals[MAX_LAYERS];		// vertex normals for the whole map, (depth+1) x (width+1)
+static TQ3ColorRGB	*gTerrainVertexLighting[MAX_LAYERS];	// lit vertex colors for the whole map, (depth+1) x (width+1)
+
+float	gSuperTileBuildMilliseconds = 0;				// average time to build a supertile this level
+float	gSuperTileTextureMilliseconds = 0;				// average time spent composing a supertile's textures this level
+static int		gNumSuperTilesBuilt = 0;
+static float	gTotalSuperTileBuildMilliseconds = 0;
+static float	gTotalSuperTileTextureMilliseconds = 0;
+
+			/* TILE ATLAS */
+			//
+			// Every flip/rotate orientation of every tile that the level's maps actually use,
+			// baked once at load time so composing a supertile texture is just row copies.
+			//
+
+#define	NUM_TILE_ORIENTATIONS	8
+#define	TILE_PIXELS				(OREOMAP_TILE_SIZE * OREOMAP_TILE_SIZE)
+
+static int16_t		*gTileAtlasSlots = nil;			// atlas slot for each [tile # * NUM_TILE_ORIENTATIONS + orientation], -1 if unused
+static uint16_t		*gTileAtlasPixels = nil;
+static int			gNumTileAtlasSlots = 0;
+
+				/* 16 FLIP/ROTATE COMBOS -> 8 UNIQUE ORIENTATIONS */
+
+#define	FLIPROT_INDEX(bits)		((bits) >> 12)
+
+static const Byte	gTileOrientationOfFlipRot[16] =
+{
+	[FLIPROT_INDEX(0)]									= 0,
+	[FLIPROT_INDEX(TILE_FLIPXY_MASK | TILE_ROT2)]		= 0,
+	[FLIPROT_INDEX(TILE_FLIPX_MASK)]					= 1,
+	[FLIPROT_INDEX(TILE_FLIPY_MASK | TILE_ROT2)]		= 1,
+	[FLIPROT_INDEX(TILE_FLIPY_MASK)]					= 2,
+	[FLIPROT_INDEX(TILE_FLIPX_MASK | TILE_ROT2)]		= 2,
+	[FLIPROT_INDEX(TILE_FLIPXY_MASK)]					= 3,
+	[FLIPROT_INDEX(TILE_ROT2)]							= 3,
+	[FLIPROT_INDEX(TILE_ROT1)]							= 4,
+	[FLIPROT_INDEX(TILE_FLIPXY_MASK | TILE_ROT3)]		= 4,
+	[FLIPROT_INDEX(TILE_ROT3)]							= 5,
+	[FLIPROT_INDEX(TILE_FLIPXY_MASK | TILE_ROT1)]		= 5,
+	[FLIPROT_INDEX(TILE_FLIPX_MASK | TILE_ROT1)]		= 6,
+	[FLIPROT_INDEX(TILE_FLIPY_MASK | TILE_ROT3)]		= 6,
+	[FLIPROT_INDEX(TILE_FLIPX_MASK | TILE_ROT3)]		= 7,
+	[FLIPROT_INDEX(TILE_FLIPY_MASK | TILE_ROT1)]		= 7,
+};
+
+static const uint16_t	gFlipRotOfTileOrientation[NUM_TILE_ORIENTATIONS] =
+{
+	0,
+	TILE_FLIPX_MASK,
+	TILE_FLIPY_MASK,
+	TILE_FLIPXY_MASK,
+	TILE_ROT1,
+	TILE_ROT3,
+	TILE_FLIPX_MASK | TILE_ROT1,
+	TILE_FLIPX_MASK | TILE_ROT3,
+};
+
 			/* TILE SPLITTING TABLES */
 			
 					
@@ -135,6 +204,26 @@ static const	Byte			gTileTriangleWinding[2][3] =
 	{ 0, 1, 2 },  // ceiling
 };
 
+			/* SHARED INDEX POOL */
+			//
+			// The 6 indices (2 triangles) of every tile position in a supertile, for both split modes,
+			// already wound for each layer. Supertiles assemble their index list from these spans.
+			//
+
+#define	SPLIT_MODES		2
+
+static uint16_t		gTileIndexPool[MAX_LAYERS][SPLIT_MODES][SUPERTILE_SIZE][SUPERTILE_SIZE][6];
+
+			/* FAR SUPERTILE INDICES */
+			//
+			// Decimated topology for distant supertiles, drawn over the same 6x6 vertex grid.
+			// The border ring of vertices is kept at full resolution so there are never any cracks
+			// against a full-detail neighbor; only the interior is collapsed into a single quad.
+			//
+
+static uint16_t		gFarSuperTileIndices[MAX_LAYERS][NUM_TRIS_IN_FAR_SUPERTILE*3];
+int					gNumFarSuperTilesDrawn = 0;
+
 
 
 TQ3Point3D		gWorkGrid[SUPERTILE_SIZE+1][SUPERTILE_SIZE+1];
@@ -142,6 +231,8 @@ uint16_t		*gTempTextureBuffer = nil;
 
 TQ3Vector3D		gRecentTerrainNormal[2];							// from _Planar
 
+static TQ3PlaneEquation	*gTerrainPlanes[MAX_LAYERS];					// plane of each terrain triangle: [(row * width + col) * 2 + tri]
+
 
 
 /****************** INIT TERRAIN MANAGER ************************/
@@ -171,6 +262,147 @@ void InitTerrainManager(void)
 	Render_SetDefaultModifiers(&gTerrainRenderMods);
 	gTerrainRenderMods.statusBits |= STATUS_BIT_NULLSHADER;
 	gTerrainRenderMods.drawOrder = kDrawOrder_Terrain;
+
+
+			/* BUILD SHARED INDEX POOL */
+
+	for (int layer = 0; layer < MAX_LAYERS; layer++)
+	{
+		for (int row = 0; row < SUPERTILE_SIZE; row++)
+		{
+			for (int col = 0; col < SUPERTILE_SIZE; col++)
+			{
+				for (int split = 0; split < SPLIT_MODES; split++)
+				{
+					const Byte* tri1 = (split == SPLIT_BACKWARD) ? gTileTriangles1_B[row][col] : gTileTriangles1_A[row][col];	// \ or /
+					const Byte* tri2 = (split == SPLIT_BACKWARD) ? gTileTriangles2_B[row][col] : gTileTriangles2_A[row][col];
+					uint16_t* span = gTileIndexPool[layer][split][row][col];
+
+					for (int v = 0; v < 3; v++)
+					{
+						span[v]		= tri1[gTileTriangleWinding[layer][v]];
+						span[v+3]	= tri2[gTileTriangleWinding[layer][v]];
+					}
+				}
+			}
+		}
+	}
+
+	BuildFarSuperTileIndices();
+}
+
+
+// Returns the z component of the cross product of a triangle's edges on the supertile vertex grid,
+// which tells which way the triangle faces.
+static inline int CrossGridTriangle(Byte a, Byte b, Byte c)
+{
+	int ax = a % (SUPERTILE_SIZE+1), az = a / (SUPERTILE_SIZE+1);
+	int bx = b % (SUPERTILE_SIZE+1), bz = b / (SUPERTILE_SIZE+1);
+	int cx = c % (SUPERTILE_SIZE+1), cz = c / (SUPERTILE_SIZE+1);
+	return (bx-ax)*(cz-az) - (bz-az)*(cx-ax);
+}
+
+
+/****************** BUILD FAR SUPERTILE INDICES ************************/
+//
+// Each side of the border ring is a trapezoid between 6 outer vertices and 2 corners
+// of the inner quad (e.g. for the back side: outer row 0, cols 0-5; inner row 1, cols 1 & 4).
+// Triangles are emitted with the same facing as gTileTriangles1_A, then wound per layer.
+//
+
+static void BuildFarSuperTileIndices(void)
+{
+#define GRID_INDEX(r, c)	((r) * (SUPERTILE_SIZE+1) + (c))
+
+const int	lo = 1;										// inner quad spans rows/cols lo...hi
+const int	hi = SUPERTILE_SIZE-1;
+Byte		tris[NUM_TRIS_IN_FAR_SUPERTILE][3];
+int			numTris = 0;
+
+	for (int side = 0; side < 4; side++)
+	{
+		Byte outer[SUPERTILE_SIZE+1];
+		Byte inner[2];
+
+				/* GET VERTICES ALONG THIS SIDE */
+
+		for (int k = 0; k <= SUPERTILE_SIZE; k++)
+		{
+			switch (side)
+			{
+				case 0:	outer[k] = GRID_INDEX(0, k);					break;		// back
+				case 1:	outer[k] = GRID_INDEX(k, SUPERTILE_SIZE);		break;		// right
+				case 2:	outer[k] = GRID_INDEX(SUPERTILE_SIZE, SUPERTILE_SIZE-k);	break;	// front
+				case 3:	outer[k] = GRID_INDEX(SUPERTILE_SIZE-k, 0);		break;		// left
+			}
+		}
+
+		switch (side)
+		{
+			case 0:	inner[0] = GRID_INDEX(lo, lo);	inner[1] = GRID_INDEX(lo, hi);	break;
+			case 1:	inner[0] = GRID_INDEX(lo, hi);	inner[1] = GRID_INDEX(hi, hi);	break;
+			case 2:	inner[0] = GRID_INDEX(hi, hi);	inner[1] = GRID_INDEX(hi, lo);	break;
+			case 3:	inner[0] = GRID_INDEX(hi, lo);	inner[1] = GRID_INDEX(lo, lo);	break;
+		}
+
+				/* FAN THE OUTER EDGE TO THE 2 INNER CORNERS */
+
+		const int mid = (SUPERTILE_SIZE+1)/2;
+
+		for (int k = 0; k < SUPERTILE_SIZE; k++)
+		{
+			Byte* t = tris[numTris++];
+			t[0] = outer[k];
+			t[1] = outer[k+1];
+			t[2] = (k < mid) ? inner[0] : inner[1];
+		}
+
+		Byte* bridge = tris[numTris++];							// bridge between the 2 fans
+		bridge[0] = outer[mid];
+		bridge[1] = inner[1];
+		bridge[2] = inner[0];
+	}
+
+			/* INNER QUAD */
+
+	tris[numTris][0] = GRID_INDEX(lo, lo);
+	tris[numTris][1] = GRID_INDEX(lo, hi);
+	tris[numTris][2] = GRID_INDEX(hi, hi);
+	numTris++;
+	tris[numTris][0] = GRID_INDEX(lo, lo);
+	tris[numTris][1] = GRID_INDEX(hi, hi);
+	tris[numTris][2] = GRID_INDEX(hi, lo);
+	numTris++;
+
+	GAME_ASSERT(numTris == NUM_TRIS_IN_FAR_SUPERTILE);
+
+			/* MATCH THE FACING OF THE FULL-DETAIL MESH */
+
+	const Byte* ref = gTileTriangles1_A[0][0];
+	int refFacing = CrossGridTriangle(ref[0], ref[1], ref[2]) > 0;
+
+	for (int i = 0; i < numTris; i++)
+	{
+		if ((CrossGridTriangle(tris[i][0], tris[i][1], tris[i][2]) > 0) != refFacing)
+		{
+			Byte temp = tris[i][1];
+			tris[i][1] = tris[i][2];
+			tris[i][2] = temp;
+		}
+	}
+
+			/* WIND FOR EACH LAYER */
+
+	for (int layer = 0; layer < MAX_LAYERS; layer++)
+	{
+		for (int i = 0; i < numTris; i++)
+		{
+			for (int v = 0; v < 3; v++)
+				gFarSuperTileIndices[layer][i*3 + v] = tris[i][gTileTriangleWinding[layer][v]];
+		}
+	}
+
+#undef GRID_INDEX
 }
 
 
@@ -215,6 +447,15 @@ void DisposeTerrain(void)
 {
 int	i;
 
+	for (i = 0; i < MAX_LAYERS; i++)
+	{
+		if (gTerrainPlanes[i])
+		{
+			DisposePtr((Ptr) gTerrainPlanes[i]);
+			gTerrainPlanes[i] = nil;
+		}
+	}
+
 	if (gTileDataHandle)
 	{
 		DisposeHandle((Handle)gTileDataHandle);
@@ -233,6 +474,9 @@ int	i;
 	  	gTerrainItemLookupTableX = nil;
 	}
 
+	DisposeTerrainItemGrid();
+	DisposeSceneryBatches();
+
 	if (gFloorMap != nil)
 	{
 		Free2DArray((void**) gFloorMap);
@@ -276,6 +520,11 @@ int	i;
 			DisposeHandle((Handle)(*gSplineList)[i].nubList);	// nuke nub list
 			DisposeHandle((Handle)(*gSplineList)[i].pointList);	// nuke point list
 			DisposeHandle((Handle)(*gSplineList)[i].itemList);	// nuke item list
+
+			if ((*gSplineList)[i].arcLengths)
+				DisposePtr((Ptr)(*gSplineList)[i].arcLengths);
+			if ((*gSplineList)[i].superTiles)
+				DisposePtr((Ptr)(*gSplineList)[i].superTiles);
 		}
 		DisposeHandle((Handle) gSplineList);
 		gSplineList = nil;										// make sure to clear handle to prevent double-free next time
@@ -306,7 +555,6 @@ int	i;
 void CreateSuperTileMemoryList(void)
 {
 long							u,v,i,numLayers;
-static 	TQ3TriMeshTriangleData	newTriangle[NUM_TRIS_IN_SUPERTILE];
 static	TQ3Param2D				uvs[NUM_VERTICES_IN_SUPERTILE];
 
 
@@ -467,9 +715,12 @@ retryParseLODPref:
 			}
 
 				/* CREATE AN EMPTY TRIMESH STRUCTURE */
+				//
+				// No triangle list: the supertile is drawn from its 16-bit triangleIndices.
+				//
 
 			TQ3TriMeshData* tmd = Q3TriMeshData_New(
-					NUM_TRIS_IN_SUPERTILE,
+					0,
 					NUM_VERTICES_IN_SUPERTILE,
 					kQ3TriMeshDataFeatureVertexUVs | kQ3TriMeshDataFeatureVertexNormals | kQ3TriMeshDataFeatureVertexColors
 			);
@@ -477,7 +728,6 @@ retryParseLODPref:
 
 			_Static_assert(sizeof(uvs) == sizeof(tmd->vertexUVs[0]) * NUM_VERTICES_IN_SUPERTILE, "supertile UV array size mismatch");
 
-			memcpy(tmd->triangles,		newTriangle,	sizeof(tmd->triangles[0]) * NUM_TRIS_IN_SUPERTILE);
 			memcpy(tmd->vertexUVs,		uvs,			sizeof(tmd->vertexUVs[0]) * NUM_VERTICES_IN_SUPERTILE);
 
 			tmd->bBox.isEmpty = kQ3False;										// calc bounding box
@@ -492,6 +742,20 @@ retryParseLODPref:
 	}
 
 	gSuperTileMemoryListExists = true;
+
+			/* LIGHT THE WHOLE MAP ONCE SO SUPERTILES JUST COPY THE RESULT */
+
+	PrecomputeTerrainLighting();
+
+			/* BAKE ALL TILE ORIENTATIONS USED BY THE MAPS */
+
+	BuildTileAtlas();
+
+	gNumSuperTilesBuilt = 0;
+	gTotalSuperTileBuildMilliseconds = 0;
+	gTotalSuperTileTextureMilliseconds = 0;
+	gSuperTileBuildMilliseconds = 0;
+	gSuperTileTextureMilliseconds = 0;
 }
 
 
@@ -543,11 +807,292 @@ int		numLayers;
 			gSuperTileMemoryList[i].triMeshDataPtrs[layer] = nil;
 		}
 	}
+
+	DisposeTerrainLighting();
+	DisposeTileAtlas();
 	
 	gSuperTileMemoryListExists = false;
 }
 
 
+#pragma mark -
+
+typedef struct
+{
+	int					layer;
+	TQ3Vector3D			*faceNormals;			// 2 per tile
+	float				ambientR,ambientG,ambientB;
+	float				fillR0,fillG0,fillB0;
+	float				fillR1,fillG1,fillB1;
+	TQ3Vector3D			fillDir0,fillDir1;
+	Byte				numFillLights;
+} TerrainLightingJob;
+
+
+/**************** GET TERRAIN MESH VERTEX ********************/
+//
+// Returns a vertex exactly as BuildTerrainSuperTile places it in the supertile mesh
+// (vertices past the map edge are flattened to y=0).
+//
+// INPUT: localIndex = vertex index within a supertile's grid, relative to the tile at row/col
+//
+
+static inline TQ3Point3D GetTerrainMeshVertex(int layer, long row, long col, Byte localIndex)
+{
+	row += localIndex / (SUPERTILE_SIZE+1);
+	col += localIndex % (SUPERTILE_SIZE+1);
+
+	TQ3Point3D p;
+	p.x = (col*TERRAIN_POLYGON_SIZE);
+	p.z = (row*TERRAIN_POLYGON_SIZE);
+	if ((row >= gTerrainTileDepth) || (col >= gTerrainTileWidth))
+		p.y = 0;
+	else
+		p.y = gMapYCoords[row][col].layerY[layer];
+	return p;
+}
+
+
+/**************** CALC TERRAIN FACE NORMALS ********************/
+//
+// ParallelFor callback: calculates the 2 face normals of every tile in the given rows,
+// using the same triangle splitting & winding as the supertile meshes.
+//
+
+static void CalcTerrainFaceNormals(int rowBegin, int rowEnd, void* userData)
+{
+	TerrainLightingJob* job = (TerrainLightingJob*) userData;
+	const int layer = job->layer;
+
+	for (long row = rowBegin; row < rowEnd; row++)
+	{
+		for (long col = 0; col < gTerrainTileWidth; col++)
+		{
+			const Byte* tris[2];
+
+			if (gMapInfoMatrix[row][col].splitMode[layer] == SPLIT_BACKWARD)
+			{
+				tris[0] = gTileTriangles1_B[0][0];
+				tris[1] = gTileTriangles2_B[0][0];
+			}
+			else
+			{
+				tris[0] = gTileTriangles1_A[0][0];
+				tris[1] = gTileTriangles2_A[0][0];
+			}
+
+			TQ3Vector3D* out = &job->faceNormals[(row * gTerrainTileWidth + col) * 2];
+
+			for (int t = 0; t < 2; t++)
+			{
+				TQ3Point3D p0 = GetTerrainMeshVertex(layer, row, col, tris[t][gTileTriangleWinding[layer][0]]);
+				TQ3Point3D p1 = GetTerrainMeshVertex(layer, row, col, tris[t][gTileTriangleWinding[layer][1]]);
+				TQ3Point3D p2 = GetTerrainMeshVertex(layer, row, col, tris[t][gTileTriangleWinding[layer][2]]);
+				CalcFaceNormal(&p0, &p1, &p2, &out[t]);
+			}
+		}
+	}
+}
+
+
+/**************** LIGHT TERRAIN VERTICES ********************/
+//
+// ParallelFor callback: averages the face normals of the 4 tiles around each vertex
+// in the given rows, then applies ambient + fill lighting to the vertex's diffuse color.
+//
+
+static void LightTerrainVertices(int rowBegin, int rowEnd, void* userData)
+{
+	const TerrainLightingJob* job = (const TerrainLightingJob*) userData;
+	const int layer = job->layer;
+
+	for (long row = rowBegin; row < rowEnd; row++)
+	{
+		long i = row * (gTerrainTileWidth+1);
+
+		for (long col = 0; col <= gTerrainTileWidth; col++, i++)
+		{
+			float	avX,avY,avZ;
+
+				/* SCAN 4 TILES AROUND THIS VERTEX TO CALC AVERAGE NORMAL */
+
+			avX = avY = avZ = 0;
+
+			for (long rr = row-1; rr <= row; rr++)
+			{
+				for (long cc = col-1; cc <= col; cc++)
+				{
+					if ((rr >= 0) && (rr < gTerrainTileDepth) && (cc >= 0) && (cc < gTerrainTileWidth))
+					{
+						const TQ3Vector3D* n = &job->faceNormals[(rr * gTerrainTileWidth + cc) * 2];
+						avX += n[0].x + n[1].x;
+						avY += n[0].y + n[1].y;
+						avZ += n[0].z + n[1].z;
+					}
+					else														// off map: up vector (see CalcTileNormals)
+					{
+						avX += 0.0f + 0.0f;
+						avY += 1.0f + 1.0f;
+						avZ += 0.0f + 0.0f;
+					}
+				}
+			}
+
+			TQ3Vector3D* normal = &gTerrainVertexNormals[layer][i];
+			FastNormalizeVector(avX, avY, avZ, normal);
+
+				/* GET VERTEX DIFFUSE COLOR */
+
+			u_short	color = gVertexColors[layer][row][col];
+			float	r,g,b,dot;
+			float	lr,lg,lb;
+
+			r = (float)(color>>11) * (1.0f/32.0f);
+			g = (float)((color>>5) & 0x3f) * (1.0f/64.0f);
+			b = (float)(color&0x1f) * (1.0f/32.0f);
+
+				/* APPLY LIGHTING TO THE VERTEX */
+
+			lr = job->ambientR;											// factor in the ambient
+			lg = job->ambientG;
+			lb = job->ambientB;
+
+			dot = normal->x * job->fillDir0.x;							// calc dot product of fill #0
+			dot += normal->y * job->fillDir0.y;
+			dot += normal->z * job->fillDir0.z;
+			dot = -dot;
+
+			if (dot > 0.0f)
+			{
+				lr += job->fillR0 * dot;
+				lg += job->fillG0 * dot;
+				lb += job->fillB0 * dot;
+			}
+
+			if (job->numFillLights > 1)
+			{
+				dot = normal->x * job->fillDir1.x;						// calc dot product of fill #1
+				dot += normal->y * job->fillDir1.y;
+				dot += normal->z * job->fillDir1.z;
+				dot = -dot;
+
+				if (dot > 0.0f)
+				{
+					lr += job->fillR1 * dot;
+					lg += job->fillG1 * dot;
+					lb += job->fillB1 * dot;
+				}
+			}
+
+			r *= lr;													// apply final lighting to diffuse color
+			if (r > 1.0f)
+				r = 1.0f;
+			g *= lg;
+			if (g > 1.0f)
+				g = 1.0f;
+			b *= lb;
+			if (b > 1.0f)
+				b = 1.0f;
+
+			gTerrainVertexLighting[layer][i] = (TQ3ColorRGB) { r, g, b };
+		}
+	}
+}
+
+
+/**************** PRECOMPUTE TERRAIN LIGHTING ********************/
+//
+// Terrain lighting never changes during a level, so instead of relighting every supertile
+// each time it scrolls into view, light every vertex of the map once, in parallel across rows.
+// Must be called after the terrain is loaded, shadows are cast and the lights are set up.
+//
+
+static void PrecomputeTerrainLighting(void)
+{
+TerrainLightingJob	job;
+float				brightness;
+const QD3DLightDefType*	lights = &gGameViewInfoPtr->lightList;
+
+	DisposeTerrainLighting();
+
+	uint64_t startTime = GetProfilingTimestamp();
+
+		/* GET LIGHT DATA */
+
+	memset(&job, 0, sizeof(job));
+
+	brightness = lights->ambientBrightness;						// get ambient brightness
+	job.ambientR = lights->ambientColor.r * brightness;			// calc ambient color
+	job.ambientG = lights->ambientColor.g * brightness;
+	job.ambientB = lights->ambientColor.b * brightness;
+
+	brightness = lights->fillBrightness[0];						// get fill brightness 0
+	job.fillR0 = lights->fillColor[0].r * brightness;
+	job.fillG0 = lights->fillColor[0].g * brightness;
+	job.fillB0 = lights->fillColor[0].b * brightness;
+	job.fillDir0 = lights->fillDirection[0];
+
+	job.numFillLights = lights->numFillLights;
+	if (job.numFillLights > 1)
+	{
+		brightness = lights->fillBrightness[1];					// get fill brightness 1
+		job.fillR1 = lights->fillColor[1].r * brightness;
+		job.fillG1 = lights->fillColor[1].g * brightness;
+		job.fillB1 = lights->fillColor[1].b * brightness;
+		job.fillDir1 = lights->fillDirection[1];
+	}
+
+		/* LIGHT EACH LAYER */
+
+	int numLayers = gDoCeiling ? 2 : 1;
+	long numVertices = (gTerrainTileDepth+1) * (gTerrainTileWidth+1);
+
+	job.faceNormals = (TQ3Vector3D*) AllocPtr(sizeof(TQ3Vector3D) * 2 * gTerrainTileDepth * gTerrainTileWidth);
+	GAME_ASSERT(job.faceNormals);
+
+	for (int layer = 0; layer < numLayers; layer++)
+	{
+		gTerrainVertexNormals[layer] = (TQ3Vector3D*) AllocPtr(sizeof(TQ3Vector3D) * numVertices);
+		gTerrainVertexLighting[layer] = (TQ3ColorRGB*) AllocPtr(sizeof(TQ3ColorRGB) * numVertices);
+		GAME_ASSERT(gTerrainVertexNormals[layer]);
+		GAME_ASSERT(gTerrainVertexLighting[layer]);
+
+		job.layer = layer;
+		ParallelFor(gTerrainTileDepth, CalcTerrainFaceNormals, &job);
+		ParallelFor(gTerrainTileDepth+1, LightTerrainVertices, &job);
+	}
+
+	DisposePtr((Ptr) job.faceNormals);
+
+#if _DEBUG
+	printf("Terrain lighting: %ld vertices x %d layers in %.2f ms\n", numVertices, numLayers, GetMillisecondsSince(startTime));
+#else
+	(void) startTime;
+#endif
+}
+
+
+/**************** DISPOSE TERRAIN LIGHTING ********************/
+
+static void DisposeTerrainLighting(void)
+{
+	for (int layer = 0; layer < MAX_LAYERS; layer++)
+	{
+		if (gTerrainVertexNormals[layer])
+		{
+			DisposePtr((Ptr) gTerrainVertexNormals[layer]);
+			gTerrainVertexNormals[layer] = nil;
+		}
+
+		if (gTerrainVertexLighting[layer])
+		{
+			DisposePtr((Ptr) gTerrainVertexLighting[layer]);
+			gTerrainVertexLighting[layer] = nil;
+		}
+	}
+}
+
+
 /***************** GET FREE SUPERTILE MEMORY *******************/
 //
 // Finds one of the preallocated supertile memory blocks and returns its index
@@ -597,17 +1142,14 @@ TQ3TriMeshData		*triMeshData;
 TQ3Vector3D			*vertexNormalList;
 u_short				tile;
 TQ3Point3D			*pointList;
-TQ3TriMeshTriangleData	*triangleList;
 SuperTileMemoryType	*superTilePtr;
 TQ3ColorRGBA		*vertexColorList;
-float				brightness;
-float				ambientR,ambientG,ambientB;
-float				fillR0,fillG0,fillB0;
-float				fillR1,fillG1,fillB1;
-TQ3Vector3D			*fillDir0,*fillDir1;
-Byte				numFillLights, numLayers;
+Byte				numLayers;
+
+	uint64_t buildStartTime = GetProfilingTimestamp();
 
-static TQ3Vector3D	faceNormal[NUM_TRIS_IN_SUPERTILE];
+	GAME_ASSERT(startRow + SUPERTILE_SIZE <= gTerrainTileDepth);
+	GAME_ASSERT(startCol + SUPERTILE_SIZE <= gTerrainTileWidth);
 
 	if (gDoCeiling)
 		numLayers = 2;
@@ -640,36 +1182,6 @@ static TQ3Vector3D	faceNormal[NUM_TRIS_IN_SUPERTILE];
 	superTilePtr->back = (startRow * TERRAIN_POLYGON_SIZE);
 
 
-		/* GET LIGHT DATA */
-
-	brightness = gGameViewInfoPtr->lightList.ambientBrightness;				// get ambient brightness
-	ambientR = gGameViewInfoPtr->lightList.ambientColor.r * brightness;		// calc ambient color
-	ambientG = gGameViewInfoPtr->lightList.ambientColor.g * brightness;		
-	ambientB = gGameViewInfoPtr->lightList.ambientColor.b * brightness;
-
-	brightness = gGameViewInfoPtr->lightList.fillBrightness[0];				// get fill brightness 0
-	fillR0 = gGameViewInfoPtr->lightList.fillColor[0].r * brightness;		// calc ambient color
-	fillG0 = gGameViewInfoPtr->lightList.fillColor[0].g * brightness;		
-	fillB0 = gGameViewInfoPtr->lightList.fillColor[0].b * brightness;		
-	fillDir0 = &gGameViewInfoPtr->lightList.fillDirection[0];		// get fill direction
-
-	numFillLights = gGameViewInfoPtr->lightList.numFillLights;
-	if (numFillLights > 1)
-	{
-		brightness = gGameViewInfoPtr->lightList.fillBrightness[1];			// get fill brightness 1
-		fillR1 = gGameViewInfoPtr->lightList.fillColor[1].r * brightness;	// calc ambient color
-		fillG1 = gGameViewInfoPtr->lightList.fillColor[1].g * brightness;		
-		fillB1 = gGameViewInfoPtr->lightList.fillColor[1].b * brightness;		
-		fillDir1 = &gGameViewInfoPtr->lightList.fillDirection[1];
-	}
-	else
-	{
-		fillR1 = 0;
-		fillG1 = 0;
-		fillB1 = 0;
-		fillDir1 = nil;
-	}
-
 		/***********************************************************/
 		/*                DO FLOOR & CEILING LAYERS                */
 		/***********************************************************/
@@ -682,7 +1194,6 @@ static TQ3Vector3D	faceNormal[NUM_TRIS_IN_SUPERTILE];
 					
 		triMeshData = gSuperTileMemoryList[superTileNum].triMeshDataPtrs[layer];	// get ptr to triMesh data
 		pointList = triMeshData->points;									// get ptr to point/vertex list
-		triangleList = triMeshData->triangles;								// get ptr to triangle index list
 		vertexColorList = triMeshData->vertexColors;						// get ptr to vertex color
 		vertexNormalList = triMeshData->vertexNormals;						// get ptr to vertex normals
 
@@ -738,231 +1249,88 @@ static TQ3Vector3D	faceNormal[NUM_TRIS_IN_SUPERTILE];
 		memset(gTempTextureBuffer, 0xFF, SUPERTILE_TEXSIZE_MAX * SUPERTILE_TEXSIZE_MAX * sizeof(uint16_t));
 #endif
 
-		i = 0;
+		uint16_t* indexList = superTilePtr->triangleIndices[layer];
+
 		for (row2 = 0; row2 < SUPERTILE_SIZE; row2++)
 		{
 			row = row2 + startRow;
 	
 			for (col2 = 0; col2 < SUPERTILE_SIZE; col2++)
 			{
-	
 				col = col2 + startCol;
 	
-						/* SET SPLITTING INFO */
+						/* COPY THIS TILE'S SPAN FROM THE SHARED INDEX POOL */
 
-				const Byte* tri1;
-				const Byte* tri2;
+				int split = (gMapInfoMatrix[row][col].splitMode[layer] == SPLIT_BACKWARD) ? SPLIT_BACKWARD : SPLIT_FORWARD;
 
-				if (gMapInfoMatrix[row][col].splitMode[layer] == SPLIT_BACKWARD)	// set coords & uv's based on splitting
-				{
-						/* \ */
-					tri1 = gTileTriangles1_B[row2][col2];
-					tri2 = gTileTriangles2_B[row2][col2];
-				}
-				else
-				{
-						/* / */
-					tri1 = gTileTriangles1_A[row2][col2];
-					tri2 = gTileTriangles2_A[row2][col2];
-				}
-
-				triangleList[i].pointIndices[0] 	= tri1[gTileTriangleWinding[layer][0]];
-				triangleList[i].pointIndices[1] 	= tri1[gTileTriangleWinding[layer][1]];
-				triangleList[i++].pointIndices[2] 	= tri1[gTileTriangleWinding[layer][2]];
-				triangleList[i].pointIndices[0] 	= tri2[gTileTriangleWinding[layer][0]];
-				triangleList[i].pointIndices[1] 	= tri2[gTileTriangleWinding[layer][1]];
-				triangleList[i++].pointIndices[2] 	= tri2[gTileTriangleWinding[layer][2]];
+				memcpy(indexList, gTileIndexPool[layer][split][row2][col2], sizeof(gTileIndexPool[0][0][0][0]));
+				indexList += 6;
 			}
 		}
 
-							/* CALC FACE NORMALS */
-						
-		for (i = 0; i < NUM_TRIS_IN_SUPERTILE; i++)
-		{
-			CalcFaceNormal( &pointList[triangleList[i].pointIndices[0]],
-							&pointList[triangleList[i].pointIndices[1]],
-							&pointList[triangleList[i].pointIndices[2]],
-							&faceNormal[i]);
-		}
+				/**************************************/
+				/* COPY PRECOMPUTED NORMALS & COLORS  */
+				/**************************************/
+				//
+				// Vertex normals & lighting are computed for the whole map in PrecomputeTerrainLighting,
+				// so neighboring supertiles always agree on the vertices along their shared edges.
+				//
+
+		const long mapRowStride = gTerrainTileWidth+1;
 
-				/******************************/
-				/* CALCULATE VERTEX NORMALS   */
-				/******************************/
-	
 		i = 0;
 		for (row = 0; row <= SUPERTILE_SIZE; row++)
 		{
-			for (col = 0; col <= (SUPERTILE_SIZE*2); col += 2)
-			{
-				TQ3Vector3D	*n1,*n2;
-				float		avX,avY,avZ;
-				TQ3Vector3D	nA,nB;
-				long		ro,co;
-				
-				/* SCAN 4 TILES AROUND THIS TILE TO CALC AVERAGE NORMAL FOR THIS VERTEX */
-				//
-				// We use the face normal already calculated for triangles inside the supertile,
-				// but for tiles/tris outside the supertile (on the borders), we need to calculate
-				// the face normals there.
-				//
-				
-				avX = avY = avZ = 0;									// init the normal	
-				
-				for (ro = -1; ro <= 0; ro++)
-				{
-					for (co = -2; co <= 0; co+=2)
-					{
-						long	cc = col + co;
-						long	rr = row + ro;
-						
-						if ((cc >= 0) && (cc < (SUPERTILE_SIZE*2)) && (rr >= 0) && (rr < SUPERTILE_SIZE)) // see if this vertex is in supertile bounds							 
-						{					
-							n1 = &faceNormal[rr * (SUPERTILE_SIZE*2) + cc];					// average 2 triangles...
-							n2 = n1+1;
-							avX += n1->x + n2->x;											// ...and average with current average
-							avY += n1->y + n2->y;
-							avZ += n1->z + n2->z;
-						}
-						else																// tile is out of supertile, so calc face normal & average
-						{
-							CalcTileNormals(layer, rr+startRow, (cc>>1)+startCol, &nA,&nB);	// calculate the 2 face normals for this tile
-							avX += nA.x + nB.x;												// average with current average
-							avY += nA.y + nB.y;
-							avZ += nA.z + nB.z;
-						}
-					}
-				}
-				FastNormalizeVector(avX, avY, avZ, &vertexNormalList[i++]);					// normalize the vertex normal	
-			}
-		}
-		
-		if (vertexColorList)
-		{
-				/*****************************/
-				/* CALCULATE VERTEX COLORS   */
-				/*****************************/
-					
-			i = 0;
-			for (row = 0; row <= SUPERTILE_SIZE; row++)
+			long mapIndex = (row+startRow) * mapRowStride + startCol;
+
+			memcpy(&vertexNormalList[i], &gTerrainVertexNormals[layer][mapIndex], sizeof(TQ3Vector3D) * (SUPERTILE_SIZE+1));
+
+			if (vertexColorList)
 			{
+				const TQ3ColorRGB* lit = &gTerrainVertexLighting[layer][mapIndex];
 				for (col = 0; col <= SUPERTILE_SIZE; col++)
 				{
-					u_short	color = gVertexColors[layer][row+startRow][col+startCol];
-					float	r,g,b,dot;
-					float	lr,lg,lb;
-					
-							/* GET VERTEX DIFFUSE COLOR */
-							
-					r = (float)(color>>11) * (1.0f/32.0f);
-					g = (float)((color>>5) & 0x3f) * (1.0f/64.0f);
-					b = (float)(color&0x1f) * (1.0f/32.0f);
-	
-							/* APPLY LIGHTING TO THE VERTEX */
-					
-					lr = ambientR;												// factor in the ambient
-					lg = ambientG;
-					lb = ambientB;
-					
-					dot = vertexNormalList[i].x * fillDir0->x;					// calc dot product of fill #0
-					dot += vertexNormalList[i].y * fillDir0->y;
-					dot += vertexNormalList[i].z * fillDir0->z;
-					dot = -dot;
-	
-					if (dot > 0.0f)
-					{					
-						lr += fillR0 * dot;
-						lg += fillG0 * dot;
-						lb += fillB0 * dot;					
-					}
-	
-					if (numFillLights > 1)
-					{
-						dot = vertexNormalList[i].x * fillDir1->x;				// calc dot product of fill #1
-						dot += vertexNormalList[i].y * fillDir1->y;
-						dot += vertexNormalList[i].z * fillDir1->z;
-						dot = -dot;
-						
-						if (dot > 0.0f)
-						{					
-							lr += fillR1 * dot;
-							lg += fillG1 * dot;
-							lb += fillB1 * dot;					
-						}
-					}
-					
-					r *= lr;													// apply final lighting to diffuse color
-					if (r > 1.0f)
-						r = 1.0f;
-					g *= lg;
-					if (g > 1.0f)
-						g = 1.0f;
-					b *= lb;
-					if (b > 1.0f)
-						b = 1.0f;
-										
-	
-							/* SAVE COLOR INTO LIST */
-							
-					vertexColorList[i].r = r;
-					vertexColorList[i].g = g;
-					vertexColorList[i].b = b;
-					i++;
+					vertexColorList[i+col].r = lit[col].r;
+					vertexColorList[i+col].g = lit[col].g;
+					vertexColorList[i+col].b = lit[col].b;
 				}
 			}
+
+			i += SUPERTILE_SIZE+1;
 		}
 
 					/********************/
 					/* ASSEMBLE TEXTURE */
 					/********************/
 
-		int textureMinRow = 0;
-		int textureMinCol = 0;
-		int textureMaxRow = textureMinRow + SUPERTILE_SIZE;
-		int textureMaxCol = textureMinCol + SUPERTILE_SIZE;
+		uint64_t textureStartTime = GetProfilingTimestamp();
 
-		if (gTerrainTextureDetail == SUPERTILE_DETAIL_SEAMLESS)
-		{
-			textureMinRow--;
-			textureMinCol--;
-			textureMaxRow++;
-			textureMaxCol++;
-		}
+		int textureOffset = (gTerrainTextureDetail == SUPERTILE_DETAIL_SEAMLESS) ? 1 : 0;	// seamless textures have a 1-tile border
 
-		for (row2 = textureMinRow; row2 < textureMaxRow; row2++)
+		for (row2 = 0; row2 < SUPERTILE_SIZE; row2++)
 		{
 			row = row2 + startRow;
 	
-			for (col2 = textureMinCol; col2 < textureMaxRow; col2++)
+			for (col2 = 0; col2 < SUPERTILE_SIZE; col2++)
 			{
 				col = col2 + startCol;
 	
 						/* ADD TILE TO PIXMAP */
 
-				if (row < 0 || row >= gTerrainTileDepth ||
-					col < 0 || col >= gTerrainTileWidth)
-				{
-					tile = 0;
-				}
-				else if (layer == 0)
-				{
+				if (layer == 0)
 					tile = gFloorMap[row][col];				// get tile from floor map...
-				}
 				else
-				{
 					tile = gCeilingMap[row][col];			// ...or get tile from ceiling map
-				}
 
-				if (gTerrainTextureDetail == SUPERTILE_DETAIL_SEAMLESS)
-				{
-					DrawTileIntoMipmap(tile, row2+1, col2+1, gTempTextureBuffer);		// draw into mipmap
-				}
-				else
-				{
-					DrawTileIntoMipmap(tile, row2, col2, gTempTextureBuffer);		// draw into mipmap
-				}
+				DrawTileIntoMipmap(tile, row2+textureOffset, col2+textureOffset, gTempTextureBuffer);		// draw into mipmap
 			}
 		}
 
+		if (gTerrainTextureDetail == SUPERTILE_DETAIL_SEAMLESS)
+			DrawSuperTileTextureSeams(layer, startRow, startCol, gTempTextureBuffer);
+
+		gTotalSuperTileTextureMilliseconds += GetMillisecondsSince(textureStartTime);
+
 				/************************/
 				/* UPDATE TEXTURE LOD 0 */
 				/************************/
@@ -1025,7 +1393,14 @@ static TQ3Vector3D	faceNormal[NUM_TRIS_IN_SUPERTILE];
 		superTilePtr->radius[layer] = 0.5f * Q3Point3D_Distance(&triMeshData->bBox.min, &triMeshData->bBox.max);
 
 	}	// j (layer)
-									
+
+			/* KEEP RUNNING AVERAGE OF BUILD TIME */
+
+	gTotalSuperTileBuildMilliseconds += GetMillisecondsSince(buildStartTime);
+	gNumSuperTilesBuilt++;
+	gSuperTileBuildMilliseconds = gTotalSuperTileBuildMilliseconds / gNumSuperTilesBuilt;
+	gSuperTileTextureMilliseconds = gTotalSuperTileTextureMilliseconds / gNumSuperTilesBuilt;
+
 	return(superTileNum);
 }
 
@@ -1083,14 +1458,29 @@ static void BuildSuperTileLOD(SuperTileMemoryType *superTilePtr, short lod)
 
 
 
+/******************** GET ATLAS TILE ***********************/
+//
+// Returns the pixels of a tile in the orientation given by its flip/rotate bits.
+//
+
+static inline const uint16_t* GetAtlasTile(uint16_t tile)
+{
+	uint16_t texMapNum = tile & TILENUM_MASK;						// filter out texture #
+	if (texMapNum >= gNumTerrainTextureTiles)						// make sure not illegal tile #
+		texMapNum = 0;
+
+	int orientation = gTileOrientationOfFlipRot[FLIPROT_INDEX(tile & (TILE_FLIPXY_MASK|TILE_ROTATE_MASK))];
+	int slot = gTileAtlasSlots[texMapNum * NUM_TILE_ORIENTATIONS + orientation];
+	GAME_ASSERT_MESSAGE(slot >= 0, "Tile orientation wasn't baked into the atlas");
+
+	return gTileAtlasPixels + slot * TILE_PIXELS;
+}
+
+
 /********************* DRAW TILE INTO MIPMAP *************************/
 
 static void DrawTileIntoMipmap(uint16_t tile, int row, int col, uint16_t *buffer)
 {
-uint16_t texMapNum;
-uint16_t flipRotBits;
-const uint16_t* tileData;
-
 const int tileSize = OREOMAP_TILE_SIZE;
 
 const int bufWidth
@@ -1098,26 +1488,79 @@ const int bufWidth
 	? SUPERTILE_TEXSIZE_SEAMLESS
 	: SUPERTILE_TEXSIZE_LOSSLESS;
 
+	const uint16_t* tileData = GetAtlasTile(tile);					// get src (already flipped/rotated)
 
-			/* EXTRACT BITS INFO FROM TILE */
-				
-	flipRotBits = tile&(TILE_FLIPXY_MASK|TILE_ROTATE_MASK);		// get flip & rotate bits
-	texMapNum = tile&TILENUM_MASK; 								// filter out texture #
+	buffer += (row * tileSize * bufWidth) + (col * tileSize);		// get dest
 
-	if (texMapNum >= gNumTerrainTextureTiles)					// make sure not illegal tile #
+	for (int y = 0; y < tileSize; y++)
 	{
-//		DoFatalAlert("DrawTileIntoMipmap: illegal tile #");
-		texMapNum = 0;
+		memcpy(buffer, tileData, tileSize * sizeof(uint16_t));
+
+		buffer += bufWidth;											// next line in dest
+		tileData += tileSize;										// next line in src
 	}
+}
+
+
+/********************* DRAW SUPERTILE TEXTURE SEAMS *************************/
+//
+// In SUPERTILE_DETAIL_SEAMLESS mode, the texture has a 1-tile border so that bilinear filtering
+// along the supertile's edges blends with the neighboring tiles. The mesh's UVs never go past
+// the inner 5x5 tiles, so the only border texels that ever get sampled are the ones touching
+// the inner area. Rather than drawing 24 full border tiles, just copy those 1-pixel seams.
+//
 
-				/* CALC PTRS */
+static inline uint16_t GetTerrainTileOrBlank(int layer, long row, long col)
+{
+	if (row < 0 || row >= gTerrainTileDepth || col < 0 || col >= gTerrainTileWidth)
+		return 0;
+	return (layer == 0) ? gFloorMap[row][col] : gCeilingMap[row][col];
+}
+
+static void DrawSuperTileTextureSeams(int layer, long startRow, long startCol, uint16_t* buffer)
+{
+const int	tileSize	= OREOMAP_TILE_SIZE;
+const int	bufWidth	= SUPERTILE_TEXSIZE_SEAMLESS;
+const int	farEdge		= (SUPERTILE_SIZE+1) * tileSize;		// first texel row/col past the inner area
+
+			/* BACK & FRONT SEAM ROWS (INCLUDING CORNERS) */
+
+	for (int i = -1; i <= SUPERTILE_SIZE; i++)
+	{
+		const uint16_t* back	= GetAtlasTile(GetTerrainTileOrBlank(layer, startRow - 1, startCol + i));
+		const uint16_t* front	= GetAtlasTile(GetTerrainTileOrBlank(layer, startRow + SUPERTILE_SIZE, startCol + i));
+		int x = (i+1) * tileSize;
+
+		memcpy(&buffer[(tileSize-1) * bufWidth + x], &back[(tileSize-1) * tileSize], tileSize * sizeof(uint16_t));	// last row of tile above
+		memcpy(&buffer[farEdge * bufWidth + x], &front[0], tileSize * sizeof(uint16_t));								// first row of tile below
+	}
+
+			/* LEFT & RIGHT SEAM COLUMNS */
+
+	for (int i = 0; i < SUPERTILE_SIZE; i++)
+	{
+		const uint16_t* left	= GetAtlasTile(GetTerrainTileOrBlank(layer, startRow + i, startCol - 1));
+		const uint16_t* right	= GetAtlasTile(GetTerrainTileOrBlank(layer, startRow + i, startCol + SUPERTILE_SIZE));
+		uint16_t* dest = &buffer[(i+1) * tileSize * bufWidth];
+
+		for (int y = 0; y < tileSize; y++)
+		{
+			dest[tileSize-1]	= left[y * tileSize + (tileSize-1)];		// last col of tile to the left
+			dest[farEdge]		= right[y * tileSize];						// first col of tile to the right
+			dest += bufWidth;
+		}
+	}
+}
 
-	const int startX = col * tileSize;
-	const int startY = row * tileSize;
 
-	buffer += (startY * bufWidth) + startX;						// get dest
-	tileData = (*gTileDataHandle) + (texMapNum * tileSize*tileSize);	// get src
+/********************* BLIT ORIENTED TILE *************************/
+//
+// Copies a tile into a buffer, applying its flip & rotate bits.
+//
 
+static void BlitOrientedTile(const uint16_t* tileData, uint16_t flipRotBits, uint16_t* buffer, int bufWidth)
+{
+const int tileSize = OREOMAP_TILE_SIZE;
 
 	switch(flipRotBits)         								// set uv's based on flip & rot bits
 	{
@@ -1247,6 +1690,96 @@ const int bufWidth
 }
 
 
+/********************* BUILD TILE ATLAS *************************/
+
+static void MarkTileInAtlas(uint16_t tile)
+{
+	uint16_t texMapNum = tile & TILENUM_MASK;
+	if (texMapNum >= gNumTerrainTextureTiles)						// illegal tiles are drawn as tile 0
+		texMapNum = 0;
+
+	int orientation = gTileOrientationOfFlipRot[FLIPROT_INDEX(tile & (TILE_FLIPXY_MASK|TILE_ROTATE_MASK))];
+	int16_t* slot = &gTileAtlasSlots[texMapNum * NUM_TILE_ORIENTATIONS + orientation];
+
+	if (*slot < 0)
+		*slot = gNumTileAtlasSlots++;
+}
+
+static void BuildTileAtlas(void)
+{
+	DisposeTileAtlas();
+
+	uint64_t startTime = GetProfilingTimestamp();
+
+	long numEntries = gNumTerrainTextureTiles * NUM_TILE_ORIENTATIONS;
+	gTileAtlasSlots = (int16_t*) AllocPtr(numEntries * sizeof(int16_t));
+	GAME_ASSERT(gTileAtlasSlots);
+
+	for (long i = 0; i < numEntries; i++)
+		gTileAtlasSlots[i] = -1;
+
+			/* SEE WHICH ORIENTATIONS THE MAPS USE */
+
+	MarkTileInAtlas(0);												// blank tile used past the edges of the map
+
+	for (long row = 0; row < gTerrainTileDepth; row++)
+	{
+		for (long col = 0; col < gTerrainTileWidth; col++)
+		{
+			MarkTileInAtlas(gFloorMap[row][col]);
+			if (gDoCeiling)
+				MarkTileInAtlas(gCeilingMap[row][col]);
+		}
+	}
+
+	GAME_ASSERT(gNumTileAtlasSlots <= INT16_MAX);
+
+			/* BAKE THEM */
+
+	gTileAtlasPixels = (uint16_t*) AllocPtr(gNumTileAtlasSlots * TILE_PIXELS * sizeof(uint16_t));
+	GAME_ASSERT(gTileAtlasPixels);
+
+	for (long i = 0; i < numEntries; i++)
+	{
+		int slot = gTileAtlasSlots[i];
+		if (slot < 0)
+			continue;
+
+		const uint16_t* src = (*gTileDataHandle) + (i / NUM_TILE_ORIENTATIONS) * TILE_PIXELS;
+		uint16_t flipRotBits = gFlipRotOfTileOrientation[i % NUM_TILE_ORIENTATIONS];
+
+		BlitOrientedTile(src, flipRotBits, gTileAtlasPixels + slot * TILE_PIXELS, OREOMAP_TILE_SIZE);
+	}
+
+#if _DEBUG
+	printf("Tile atlas: %d tile orientations (%ldK) in %.2f ms\n",
+			gNumTileAtlasSlots, (long) gNumTileAtlasSlots * TILE_PIXELS * sizeof(uint16_t) / 1024, GetMillisecondsSince(startTime));
+#else
+	(void) startTime;
+#endif
+}
+
+
+/********************* DISPOSE TILE ATLAS *************************/
+
+static void DisposeTileAtlas(void)
+{
+	if (gTileAtlasSlots)
+	{
+		DisposePtr((Ptr) gTileAtlasSlots);
+		gTileAtlasSlots = nil;
+	}
+
+	if (gTileAtlasPixels)
+	{
+		DisposePtr((Ptr) gTileAtlasPixels);
+		gTileAtlasPixels = nil;
+	}
+
+	gNumTileAtlasSlots = 0;
+}
+
+
 /************ SHRINK SUPERTILE TEXTURE MAP ********************/
 //
 // Shrinks a 160x160 src texture to a 128x128 dest texture
@@ -1405,6 +1938,7 @@ void DrawTerrain(const QD3DSetupOutputType *setupInfo)
 		
 	TQ3Point3D cameraCoord = setupInfo->currentCameraCoords;
 	
+	gNumFarSuperTilesDrawn = 0;
 
 				/* DRAW STUFF */
 
@@ -1436,13 +1970,13 @@ void DrawTerrain(const QD3DSetupOutputType *setupInfo)
 
 			int lod = 0;
 
+			TQ3Point3D tileCoord = gSuperTileMemoryList[i].coord[j];		// get x & z coords of tile
+			float dist = CalcQuickDistance(cameraCoord.x, cameraCoord.z, tileCoord.x, tileCoord.z);
+
 			if (gTerrainTextureDetail == SUPERTILE_DETAIL_PROGRESSIVE)	// the only detail level with 3 LODs
 			{
 						/* SEE WHICH LOD TO USE */
 
-				TQ3Point3D tileCoord = gSuperTileMemoryList[i].coord[j];	// get x & z coords of tile
-				float dist = CalcQuickDistance(cameraCoord.x, cameraCoord.z, tileCoord.x, tileCoord.z);
-
 				if (dist < 1300.0f)
 					lod = 0;
 				else if (dist < 1700.0f)
@@ -1468,9 +2002,22 @@ void DrawTerrain(const QD3DSetupOutputType *setupInfo)
 
 			gSuperTileMemoryList[i].triMeshDataPtrs[j]->glTextureName = gSuperTileMemoryList[i].glTextureName[j][lod];
 
+						/* USE DECIMATED GEOMETRY IF FAR AWAY */
+
+			int				numTris = NUM_TRIS_IN_SUPERTILE;
+			const uint16_t*	indices = gSuperTileMemoryList[i].triangleIndices[j];
+
+			if (dist >= FAR_SUPERTILE_DIST)
+			{
+				numTris = NUM_TRIS_IN_FAR_SUPERTILE;
+				indices = gFarSuperTileIndices[j];
+				gNumFarSuperTilesDrawn++;
+			}
+
 						/* SUBMIT FOR DRAWING */
 
-			Render_SubmitMesh(gSuperTileMemoryList[i].triMeshDataPtrs[j], nil, &gTerrainRenderMods, &gSuperTileMemoryList[i].coord[j]);
+			Render_SubmitMeshWithShortIndices(gSuperTileMemoryList[i].triMeshDataPtrs[j], numTris, indices,
+												nil, &gTerrainRenderMods, &gSuperTileMemoryList[i].coord[j]);
 		}
 	}
 
@@ -1482,7 +2029,9 @@ void DrawTerrain(const QD3DSetupOutputType *setupInfo)
 	if (gDoAutoFade)													// avoid clover-shaped holes in fences
 		Render_FlushQueue();
 
+	DrawSceneryBatches(setupInfo);										// draw batched scenery (must be before DrawObjects)
 	DrawObjects(setupInfo);												// draw objNodes
+	DrawRipples();														// draw pooled water ripples
 	QD3D_DrawShards(setupInfo);											// draw "shard" particles
 	DrawParticleGroup(setupInfo);										// draw alpha-blended particle groups
 
@@ -1514,6 +2063,42 @@ void DrawTerrain(const QD3DSetupOutputType *setupInfo)
 }
 
 
+/***************** WHICH TERRAIN TRIANGLE ******************/
+//
+// Returns which of a tile's 2 triangles (0 = left, 1 = right) contains the
+// given x/z offset into the tile.
+//
+
+static inline int WhichTerrainTriangle(int row, int col, long layer, float xi, float zi)
+{
+	if (gMapInfoMatrix[row][col].splitMode[layer] == SPLIT_BACKWARD)			// if \ split
+		return (xi < zi) ? 0 : 1;
+	else																		// otherwise, / split
+		return ((TERRAIN_POLYGON_SIZE-xi) > zi) ? 0 : 1;						// flip x
+}
+
+
+/***************** GET TERRAIN PLANE AT COORD ******************/
+//
+// Returns the precomputed plane of the terrain triangle under a world x/z coord,
+// or nil if the coord is off the map.
+//
+
+static inline const TQ3PlaneEquation* GetTerrainPlaneAtCoord(float x, float z, long layer)
+{
+	int col = x * TERRAIN_POLYGON_SIZE_Frac;
+	int row = z * TERRAIN_POLYGON_SIZE_Frac;
+
+	if ((col < 0) || (col >= gTerrainTileWidth) || (row < 0) || (row >= gTerrainTileDepth))
+		return nil;
+
+	float xi = x - (col * TERRAIN_POLYGON_SIZE);
+	float zi = z - (row * TERRAIN_POLYGON_SIZE);
+
+	return &gTerrainPlanes[layer][(row * gTerrainTileWidth + col) * 2 + WhichTerrainTriangle(row, col, layer, xi, zi)];
+}
+
+
 /***************** GET TERRAIN HEIGHT AT COORD ******************/
 //
 // Given a world x/z coord, return the y coord based on height map
@@ -1525,9 +2110,7 @@ void DrawTerrain(const QD3DSetupOutputType *setupInfo)
 
 float	GetTerrainHeightAtCoord(float x, float z, long layer)
 {
-TQ3PlaneEquation	planeEq;
 int					row,col;
-TQ3Point3D			p[4];
 float				xi,zi;
 
 	if (!gFloorMap)														// make sure there's a terrain
@@ -1548,73 +2131,166 @@ float				xi,zi;
 				
 	xi = x - (col * TERRAIN_POLYGON_SIZE);								// calc x/z offset into the tile
 	zi = z - (row * TERRAIN_POLYGON_SIZE);
-				
-				
-				
-					/* BUILD VERTICES FOR THE 4 CORNERS OF THE TILE */
-				
-	p[0].x = col * TERRAIN_POLYGON_SIZE;								// far left
-	p[0].y = gMapYCoords[row][col].layerY[layer];
-	p[0].z = row * TERRAIN_POLYGON_SIZE;
 
-	p[1].x = p[0].x + TERRAIN_POLYGON_SIZE;								// far right
-	p[1].y = gMapYCoords[row][col+1].layerY[layer];
-	p[1].z = p[0].z;
+			/* GET PRECOMPUTED PLANE OF THE TRIANGLE WE'RE ON */
 
-	p[2].x = p[1].x;													// near right
-	p[2].y = gMapYCoords[row+1][col+1].layerY[layer];
-	p[2].z = p[1].z + TERRAIN_POLYGON_SIZE;
+	const TQ3PlaneEquation* planeEq = &gTerrainPlanes[layer][(row * gTerrainTileWidth + col) * 2 + WhichTerrainTriangle(row, col, layer, xi, zi)];
 
-	p[3].x = col * TERRAIN_POLYGON_SIZE;								// near left
-	p[3].y = gMapYCoords[row+1][col].layerY[layer];
-	p[3].z = p[2].z;
+	gRecentTerrainNormal[layer] = planeEq->normal;								// remember the normal here
 
-				
+	return (IntersectionOfYAndPlane(x,z,planeEq));								// calc intersection
+}
 
-		/************************************/
-		/* CALC PLANE EQUATION FOR TRIANGLE */
-		/************************************/
-		
-	if (gMapInfoMatrix[row][col].splitMode[layer] == SPLIT_BACKWARD)			// if \ split
+
+/***************** GET TERRAIN HEIGHTS AT COORDS ******************/
+//
+// Batched version of GetTerrainHeightAtCoord, for callers that need many heights at once.
+// Results are identical to calling GetTerrainHeightAtCoord on each coord,
+// and gRecentTerrainNormal is left as it would be after the last coord.
+//
+
+void GetTerrainHeightsAtCoords(int n, const float* xs, const float* zs, long layer, float* outY)
+{
+static const TQ3PlaneEquation kOffMapPlane = { {0, 1, 0}, 0 };		// y=0 everywhere
+
+	if (n <= 0)
+		return;
+
+	if (!gFloorMap || (layer == CEILING && !gDoCeiling))
 	{
-		if (layer == 0)
+		float y = gFloorMap ? 10000000 : 0;
+		for (int i = 0; i < n; i++)
+			outY[i] = y;
+		return;
+	}
+
+	const TQ3PlaneEquation* planes[4];
+	const TQ3PlaneEquation* lastPlane = nil;
+	int i = 0;
+
+			/* DO 4 AT A TIME */
+
+	for ( ; i + 4 <= n; i += 4)
+	{
+		for (int k = 0; k < 4; k++)
 		{
-			if (xi < zi)														// which triangle are we on?
-				CalcPlaneEquationOfTriangle(&planeEq, &p[0], &p[2],&p[3]);		// calc plane equation for left triangle
+			planes[k] = GetTerrainPlaneAtCoord(xs[i+k], zs[i+k], layer);
+			if (planes[k])
+				lastPlane = planes[k];
 			else
-				CalcPlaneEquationOfTriangle(&planeEq, &p[0], &p[1], &p[2]);		// calc plane equation for right triangle
+				planes[k] = &kOffMapPlane;
 		}
-		else																	// clockwise for ceiling
+
+		Vec4f nx = Vec4f_Set(planes[0]->normal.x, planes[1]->normal.x, planes[2]->normal.x, planes[3]->normal.x);
+		Vec4f ny = Vec4f_Set(planes[0]->normal.y, planes[1]->normal.y, planes[2]->normal.y, planes[3]->normal.y);
+		Vec4f nz = Vec4f_Set(planes[0]->normal.z, planes[1]->normal.z, planes[2]->normal.z, planes[3]->normal.z);
+		Vec4f c  = Vec4f_Set(planes[0]->constant, planes[1]->constant, planes[2]->constant, planes[3]->constant);
+
+		Vec4f x = Vec4f_Load(&xs[i]);
+		Vec4f z = Vec4f_Load(&zs[i]);
+
+		Vec4f dot = Vec4f_Add(Vec4f_Mul(nx, x), Vec4f_Mul(nz, z));		// same operation order as IntersectionOfYAndPlane
+		Vec4f_Store(&outY[i], Vec4f_Div(Vec4f_Sub(c, dot), ny));
+	}
+
+			/* DO THE REST ONE BY ONE */
+
+	for ( ; i < n; i++)
+	{
+		const TQ3PlaneEquation* plane = GetTerrainPlaneAtCoord(xs[i], zs[i], layer);
+		if (plane)
+			lastPlane = plane;
+		else
+			plane = &kOffMapPlane;
+		outY[i] = IntersectionOfYAndPlane(xs[i], zs[i], plane);
+	}
+
+	if (lastPlane)														// remember the normal like GetTerrainHeightAtCoord would
+		gRecentTerrainNormal[layer] = lastPlane->normal;
+}
+
+
+/***************** BUILD TERRAIN PLANE TABLE ******************/
+//
+// Precalculates the plane equation of both triangles of every tile, for each layer,
+// so that GetTerrainHeightAtCoord doesn't have to derive a plane on every query.
+// Call after the height map & split mode matrix are loaded.
+//
+
+void BuildTerrainPlaneTable(void)
+{
+TQ3Point3D			p[4];
+int					numLayers = gDoCeiling ? 2 : 1;
+
+	for (int layer = 0; layer < MAX_LAYERS; layer++)
+	{
+		if (gTerrainPlanes[layer])
 		{
-			if (xi < zi)														// which triangle are we on?
-				CalcPlaneEquationOfTriangle(&planeEq, &p[3], &p[2], &p[0]);		// calc plane equation for left triangle
-			else
-				CalcPlaneEquationOfTriangle(&planeEq, &p[2], &p[1], &p[0]);		// calc plane equation for right triangle
+			DisposePtr((Ptr) gTerrainPlanes[layer]);
+			gTerrainPlanes[layer] = nil;
 		}
 	}
-	else																		// otherwise, / split
+
+	for (int layer = 0; layer < numLayers; layer++)
 	{
-		xi = TERRAIN_POLYGON_SIZE-xi;											// flip x
-		if (layer == 0)
-		{	
-			if (xi > zi)
-				CalcPlaneEquationOfTriangle(&planeEq, &p[0], &p[1], &p[3]);		// calc plane equation for left triangle
-			else
-				CalcPlaneEquationOfTriangle(&planeEq, &p[1], &p[2], &p[3]);		// calc plane equation for right triangle
-		}
-		else																	// clockwise for ceiling
-		{			
-			if (xi > zi)
-				CalcPlaneEquationOfTriangle(&planeEq, &p[3], &p[1], &p[0]);		// calc plane equation for left triangle
-			else
-				CalcPlaneEquationOfTriangle(&planeEq, &p[3], &p[2], &p[1]);		// calc plane equation for right triangle
-		}
-			
-	}			
+		gTerrainPlanes[layer] = (TQ3PlaneEquation*) AllocPtr(sizeof(TQ3PlaneEquation) * 2 * gTerrainTileDepth * gTerrainTileWidth);
+		GAME_ASSERT(gTerrainPlanes[layer]);
+
+		TQ3PlaneEquation* planes = gTerrainPlanes[layer];
+
+		for (int row = 0; row < gTerrainTileDepth; row++)
+		{
+			for (int col = 0; col < gTerrainTileWidth; col++, planes += 2)
+			{
+						/* BUILD VERTICES FOR THE 4 CORNERS OF THE TILE */
 
-	gRecentTerrainNormal[layer] = planeEq.normal;								// remember the normal here
+				p[0].x = col * TERRAIN_POLYGON_SIZE;								// far left
+				p[0].y = gMapYCoords[row][col].layerY[layer];
+				p[0].z = row * TERRAIN_POLYGON_SIZE;
 
-	return (IntersectionOfYAndPlane(x,z,&planeEq));								// calc intersection
+				p[1].x = p[0].x + TERRAIN_POLYGON_SIZE;								// far right
+				p[1].y = gMapYCoords[row][col+1].layerY[layer];
+				p[1].z = p[0].z;
+
+				p[2].x = p[1].x;													// near right
+				p[2].y = gMapYCoords[row+1][col+1].layerY[layer];
+				p[2].z = p[1].z + TERRAIN_POLYGON_SIZE;
+
+				p[3].x = col * TERRAIN_POLYGON_SIZE;								// near left
+				p[3].y = gMapYCoords[row+1][col].layerY[layer];
+				p[3].z = p[2].z;
+
+						/* CALC PLANE EQUATIONS FOR LEFT [0] & RIGHT [1] TRIANGLES */
+
+				if (gMapInfoMatrix[row][col].splitMode[layer] == SPLIT_BACKWARD)	// if \ split
+				{
+					if (layer == 0)
+					{
+						CalcPlaneEquationOfTriangle(&planes[0], &p[0], &p[2], &p[3]);
+						CalcPlaneEquationOfTriangle(&planes[1], &p[0], &p[1], &p[2]);
+					}
+					else															// clockwise for ceiling
+					{
+						CalcPlaneEquationOfTriangle(&planes[0], &p[3], &p[2], &p[0]);
+						CalcPlaneEquationOfTriangle(&planes[1], &p[2], &p[1], &p[0]);
+					}
+				}
+				else																// otherwise, / split
+				{
+					if (layer == 0)
+					{
+						CalcPlaneEquationOfTriangle(&planes[0], &p[0], &p[1], &p[3]);
+						CalcPlaneEquationOfTriangle(&planes[1], &p[1], &p[2], &p[3]);
+					}
+					else															// clockwise for ceiling
+					{
+						CalcPlaneEquationOfTriangle(&planes[0], &p[3], &p[1], &p[0]);
+						CalcPlaneEquationOfTriangle(&planes[1], &p[3], &p[2], &p[1]);
+					}
+				}
+			}
+		}
+	}
 }
 
 
@@ -2163,7 +2839,10 @@ long	i,w;
 		ScrollTerrainLeft();
 		CalcNewItemDeleteWindow();							// recalc item delete window
 	}	
-	
+
+#if _DEBUG
+	BenchmarkShadowBlockers();
+#endif
 }
 
 
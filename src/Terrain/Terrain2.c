@@ -15,6 +15,11 @@
 /****************************/
 
 static Boolean NilAdd(TerrainItemEntryType *itemPtr,long x, long z);
+static void BuildTerrainItemGrid(void);
+static int CollectItemsInRange(long top, long bottom, long left, long right, short *outItems);
+#if _DEBUG
+static void VerifyTerrainItemGrid(void);
+#endif
 
 
 /****************************/
@@ -33,6 +38,21 @@ TerrainItemEntryType 	**gMasterItemList = nil;
 
 Ptr						gMaxItemAddress;			// addr of last item in current item list
 
+			/* ITEM GRID */
+			//
+			// Items bucketed by the supertile they're in, so that a scroll only has to look at
+			// the strip of supertiles that just came into range. Each cell lists its items
+			// in master list order.
+			//
+
+static int32_t			*gTerrainItemCellStart = nil;	// index of each cell's first item; [numCells] = total # items
+static short			*gTerrainItemCellItems = nil;
+static short			*gTerrainItemScanBuffer = nil;	// scratch space for ScanForPlayfieldItems
+
+float					gItemScanMilliseconds = 0;		// average time spent in ScanForPlayfieldItems this level
+static int				gNumItemScans = 0;
+static float			gTotalItemScanMilliseconds = 0;
+
 TerrainYCoordType		**gMapYCoords = nil;		// 2D array of map vertex y coords
 
 TerrainInfoMatrixType	**gMapInfoMatrix = nil;
@@ -180,6 +200,11 @@ trail:
 	{
 		gTerrainItemLookupTableX[col] = lastPtr;
 	}
+
+
+			/* BUCKET ITEMS BY SUPERTILE */
+
+	BuildTerrainItemGrid();
 	
 
 			/* FIGURE OUT WHERE THE STARTING POINT IS */
@@ -234,65 +259,272 @@ gotit:
 
 void ScanForPlayfieldItems(long top, long bottom, long left, long right)
 {
-TerrainItemEntryType *itemPtr;
+TerrainItemEntryType *itemList,*itemPtr;
 long			type,n;
 Boolean			flag;
-long			maxX,minX,maxY,minY;
 long			realX,realZ;
+int				numItems;
+uint64_t		scanStartTime;
 
 	if (gNumTerrainItems == 0)
 		return;
 
-	itemPtr = gTerrainItemLookupTableX[left];					// get pointer to 1st item at this X
-	if ((Ptr)itemPtr > gMaxItemAddress)					// see if out of bounds			
-		return;
-
-	minX = left*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
-	maxX = right*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE);			// calc min/max coords to be in range (map relative)
-	maxX += (SUPERTILE_SIZE*OREOMAP_TILE_SIZE)-1;
+	scanStartTime = GetProfilingTimestamp();
 
-	minY = top*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
-	maxY = bottom*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
-	maxY += (SUPERTILE_SIZE*OREOMAP_TILE_SIZE)-1;
+	numItems = CollectItemsInRange(top, bottom, left, right, gTerrainItemScanBuffer);	// get items in this range, in list order
 
+	itemList = *gMasterItemList;
 	n = 0;														// init counter
 
-	while ((itemPtr->x >= minX) && (itemPtr->x <= maxX)) 		// check all items in this column range
+	for (int i = 0; i < numItems; i++)
 	{
-		if ((itemPtr->y >= minY) && (itemPtr->y <= maxY))		// & this row range
-		{
-					/* ADD AN ITEM */
+		itemPtr = &itemList[gTerrainItemScanBuffer[i]];
 
-			if (itemPtr->flags&ITEM_FLAGS_INUSE)				// see if item available
-				goto skip;
-				
-			type = itemPtr->type;								// get item #
-			if (type > MAX_ITEM_NUM)							// error check!
-			{
-				DoAlert("Illegal Map Item Type! (%d)", type);
-			}
+				/* ADD AN ITEM */
 
-			realX = itemPtr->x * MAP2UNIT_VALUE;				// calc & pass 3-space coords
-			realZ = itemPtr->y * MAP2UNIT_VALUE;
-	
-			flag = gTerrainItemAddRoutines[type](itemPtr,realX, realZ); // call item's ADD routine
-			if (flag)
-				itemPtr->flags |= ITEM_FLAGS_INUSE;				// set in-use flag
-				
-			n++;												// inc counter
+		if (itemPtr->flags&ITEM_FLAGS_INUSE)					// see if item available
+			continue;
+
+		type = itemPtr->type;									// get item #
+		if (type > MAX_ITEM_NUM)								// error check!
+		{
+			DoAlert("Illegal Map Item Type! (%d)", type);
 		}
-skip:		
-		itemPtr++;												// point to next item in list
-		if ((Ptr)itemPtr > gMaxItemAddress)
-			break;
+
+		realX = itemPtr->x * MAP2UNIT_VALUE;					// calc & pass 3-space coords
+		realZ = itemPtr->y * MAP2UNIT_VALUE;
+
+		flag = gTerrainItemAddRoutines[type](itemPtr,realX, realZ); // call item's ADD routine
+		if (flag)
+			itemPtr->flags |= ITEM_FLAGS_INUSE;					// set in-use flag
+
+		n++;													// inc counter
 	}
 	
 	if (n > gMaxItemsAllocatedInAPass)							// update this for debug purposes
 		gMaxItemsAllocatedInAPass = n;
-	
+
+	gTotalItemScanMilliseconds += GetMillisecondsSince(scanStartTime);
+	gNumItemScans++;
+	gItemScanMilliseconds = gTotalItemScanMilliseconds / gNumItemScans;
+}
+
+
+#pragma mark -
+
+/******************** BUILD TERRAIN ITEM GRID ***********************/
+//
+// Buckets the master item list by supertile. Called once per level, after the list is loaded.
+//
+
+static void BuildTerrainItemGrid(void)
+{
+TerrainItemEntryType *itemPtr;
+int				numCells;
+
+	DisposeTerrainItemGrid();
+
+	numCells = gNumSuperTilesDeep * gNumSuperTilesWide;
+
+	gTerrainItemCellStart = (int32_t *)AllocPtr(sizeof(int32_t) * (numCells + 1));
+	gTerrainItemCellItems = (short *)AllocPtr(sizeof(short) * gNumTerrainItems);
+	gTerrainItemScanBuffer = (short *)AllocPtr(sizeof(short) * gNumTerrainItems);
+	GAME_ASSERT(gTerrainItemCellStart);
+	GAME_ASSERT(gTerrainItemCellItems);
+	GAME_ASSERT(gTerrainItemScanBuffer);
+
+	itemPtr = *gMasterItemList;
+
+			/* COUNT ITEMS IN EACH CELL */
+
+	for (int i = 0; i < gNumTerrainItems; i++)
+	{
+		long row = itemPtr[i].y / (SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
+		long col = itemPtr[i].x / (SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
+
+		if (row >= gNumSuperTilesDeep || col >= gNumSuperTilesWide)	// off map, can never come into range
+			continue;
+
+		gTerrainItemCellStart[row * gNumSuperTilesWide + col + 1]++;
+	}
+
+	for (int cell = 0; cell < numCells; cell++)
+		gTerrainItemCellStart[cell + 1] += gTerrainItemCellStart[cell];
+
+			/* FILL CELLS IN LIST ORDER */
+
+	int32_t* fillPos = (int32_t *)AllocPtr(sizeof(int32_t) * numCells);
+	GAME_ASSERT(fillPos);
+	memcpy(fillPos, gTerrainItemCellStart, sizeof(int32_t) * numCells);
+
+	for (int i = 0; i < gNumTerrainItems; i++)
+	{
+		long row = itemPtr[i].y / (SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
+		long col = itemPtr[i].x / (SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
+
+		if (row >= gNumSuperTilesDeep || col >= gNumSuperTilesWide)
+			continue;
+
+		gTerrainItemCellItems[fillPos[row * gNumSuperTilesWide + col]++] = i;
+	}
+
+	DisposePtr((Ptr) fillPos);
+
+#if _DEBUG
+	VerifyTerrainItemGrid();
+#endif
+}
+
+
+/******************** DISPOSE TERRAIN ITEM GRID ***********************/
+
+void DisposeTerrainItemGrid(void)
+{
+	if (gTerrainItemCellStart)
+	{
+		DisposePtr((Ptr) gTerrainItemCellStart);
+		gTerrainItemCellStart = nil;
+	}
+
+	if (gTerrainItemCellItems)
+	{
+		DisposePtr((Ptr) gTerrainItemCellItems);
+		gTerrainItemCellItems = nil;
+	}
+
+	if (gTerrainItemScanBuffer)
+	{
+		DisposePtr((Ptr) gTerrainItemScanBuffer);
+		gTerrainItemScanBuffer = nil;
+	}
+
+	gNumItemScans = 0;
+	gTotalItemScanMilliseconds = 0;
+	gItemScanMilliseconds = 0;
 }
 
 
+/******************** COLLECT ITEMS IN RANGE ***********************/
+//
+// Gets the indices of all items in the given supertile range, in the same order
+// as they appear in the master list.
+//
+
+static int CollectItemsInRange(long top, long bottom, long left, long right, short *outItems)
+{
+int		numItems = 0;
+
+	GAME_ASSERT(top >= 0 && bottom < gNumSuperTilesDeep);
+	GAME_ASSERT(left >= 0 && right < gNumSuperTilesWide);
+
+	for (long col = left; col <= right; col++)					// the list is sorted by column...
+	{
+		int columnStart = numItems;
+
+		for (long row = top; row <= bottom; row++)
+		{
+			int cell = row * gNumSuperTilesWide + col;
+
+			for (int j = gTerrainItemCellStart[cell]; j < gTerrainItemCellStart[cell+1]; j++)
+				outItems[numItems++] = gTerrainItemCellItems[j];
+		}
+
+				/* ...BUT NOT BY ROW, SO RESTORE LIST ORDER WITHIN THE COLUMN */
+
+		if (top != bottom)
+		{
+			for (int i = columnStart + 1; i < numItems; i++)
+			{
+				short item = outItems[i];
+				int k = i - 1;
+				while (k >= columnStart && outItems[k] > item)
+				{
+					outItems[k+1] = outItems[k];
+					k--;
+				}
+				outItems[k+1] = item;
+			}
+		}
+	}
+
+	return numItems;
+}
+
+
+#if _DEBUG
+/******************** VERIFY TERRAIN ITEM GRID ***********************/
+//
+// Checks every row & column strip that the scroll code may ask for against a walk of
+// the sorted item list (the way ScanForPlayfieldItems used to find items), and prints
+// how long each took.
+//
+
+static void VerifyTerrainItemGrid(void)
+{
+TerrainItemEntryType *itemList = *gMasterItemList;
+short		*listItems = (short *)AllocPtr(sizeof(short) * gNumTerrainItems);
+double		totalMS[2] = {0, 0};
+int			numMismatches = 0;
+int			numStrips = 0;
+
+	GAME_ASSERT(listItems);
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		long numStripsThisPass = (pass == 0) ? gNumSuperTilesDeep : gNumSuperTilesWide;
+
+		for (long s = 0; s < numStripsThisPass; s++)
+		{
+			long top	= (pass == 0) ? s : 0;
+			long bottom	= (pass == 0) ? s : gNumSuperTilesDeep-1;
+			long left	= (pass == 0) ? 0 : s;
+			long right	= (pass == 0) ? gNumSuperTilesWide-1 : s;
+
+					/* WALK THE SORTED LIST */
+
+			uint64_t start = GetProfilingTimestamp();
+
+			long minX = left*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
+			long maxX = right*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE) + (SUPERTILE_SIZE*OREOMAP_TILE_SIZE)-1;
+			long minY = top*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE);
+			long maxY = bottom*(SUPERTILE_SIZE*OREOMAP_TILE_SIZE) + (SUPERTILE_SIZE*OREOMAP_TILE_SIZE)-1;
+			int numListItems = 0;
+
+			for (TerrainItemEntryType *itemPtr = gTerrainItemLookupTableX[left];
+				(Ptr)itemPtr <= gMaxItemAddress && itemPtr->x >= minX && itemPtr->x <= maxX;
+				itemPtr++)
+			{
+				if (itemPtr->y >= minY && itemPtr->y <= maxY)
+					listItems[numListItems++] = (short)(itemPtr - itemList);
+			}
+
+			totalMS[0] += GetMillisecondsSince(start);
+
+					/* ASK THE GRID */
+
+			start = GetProfilingTimestamp();
+			int numGridItems = CollectItemsInRange(top, bottom, left, right, gTerrainItemScanBuffer);
+			totalMS[1] += GetMillisecondsSince(start);
+
+			if (numGridItems != numListItems
+				|| 0 != memcmp(listItems, gTerrainItemScanBuffer, sizeof(short) * numGridItems))
+			{
+				numMismatches++;
+			}
+
+			numStrips++;
+		}
+	}
+
+	DisposePtr((Ptr) listItems);
+
+	printf("Terrain items: %d strips, list walk %.3f ms, grid %.3f ms, %d mismatches\n",
+			numStrips, totalMS[0], totalMS[1], numMismatches);
+	GAME_ASSERT_MESSAGE(numMismatches == 0, "Terrain item grid changed which items get added");
+}
+#endif
+
+
 /******************** NIL ADD ***********************/
 //
 // nothing add
@@ -479,31 +711,102 @@ static TQ3Point3D	p4 = {0, 0, TERRAIN_POLYGON_SIZE};
 }
 
 
-/****************** DO ITEM SHADOW CASTING **********************/
+			/* ITEM SHADOW CASTING JOB */
+
+typedef struct
+{
+	TQ3Point2D			from,to;				// line to draw shadow along
+	float				length;
+	long				minRow,maxRow;			// rows the line can reach (conservative)
+} ItemShadowLine;
+
+typedef struct
+{
+	int					numLines;
+	ItemShadowLine		*lines;
+	Byte				**shadowFlags;
+	u_short				**vertexColors;
+} ItemShadowJob;
+
+
+/****************** GET ITEM SHADOW HEIGHT **********************/
 //
-// Scans thru item list and casts a shadown onto the terrain
-// by darkening the vertex colors of the terrain.
+// Returns 0 if the item type doesn't cast a shadow.
 //
 
-void DoItemShadowCasting(void)
+static float GetItemShadowHeight(uint16_t itemType)
 {
-long				i;
-static TQ3Vector3D up = {0,1,0};
-float				height,dot,length;
-TQ3Vector2D			lightVector;
-TQ3Point2D			from,to;
-float				x,z,t;
-long				row,col;
-Byte				**shadowFlags;
+	switch(itemType)
+	{
+		case	5:						// clover
+				return 1000;
+				
+		case	6:						// grass
+				return 1200;
+				
+		case	7:						// weed
+				return 2500;
+				
+		case	10:						// sunflower
+				return 3000;
 
-			/* INIT SHADOW FLAGS TEMP BUFFER */
-			
-	Alloc_2d_array(Byte, shadowFlags, gTerrainTileDepth+1, gTerrainTileWidth+1);
+		case	11:						// cosmo
+				return 2000;
 
-	for (row = 0; row <= gTerrainTileDepth; row++)
-		for (col = 0; col <= gTerrainTileWidth; col++)
-			shadowFlags[row][col] = 0;
+		case	12:						// poppy
+				return 2000;
+
+		case	19:						// cattail
+				return 3000;
+
+		case	20:						// duckweed
+				return 2500;
+
+		case	21:						// lily flower
+				return 2000;
+
+		case	22:						// lily pad
+				return 2000;
+				
+		case	23:						// pond grass
+				return 2500;
+
+		case	24:						// reed
+				return 2500;
+
+		case	45:						// honey tube
+				return 1200;
 
+		case	51:						// tree stump
+				return 3000;
+
+		case	57:						// ant pipe
+		case	58:
+				return 1000;
+
+		case	60:						// faucet
+				return 1200;
+
+		case	63:						// king pipe
+				return 1200;
+				
+		default:
+				return 0;
+	}
+}
+
+
+/****************** BUILD ITEM SHADOW LINES **********************/
+//
+// OUTPUT: # of lines written to outLines (1 per shadow-casting item, in item list order)
+//
+
+static int BuildItemShadowLines(ItemShadowLine *outLines)
+{
+static TQ3Vector3D up = {0,1,0};
+float				height,dot;
+TQ3Vector2D			lightVector;
+int					numLines = 0;
 
 			/* GET MAIN LIGHT VECTOR INFO */
 
@@ -514,165 +817,209 @@ Byte				**shadowFlags;
 	dot = -Q3Vector3D_Dot(&up,&gGameViewInfoPtr->lightList.fillDirection[0]);
 	dot = 1.0 - dot;
 	
-			/***********************/
-			/* SCAN THRU ITEM LIST */
-			/***********************/
-			
-	for (i = 0; i < gNumTerrainItems; i++)
+	for (long i = 0; i < gNumTerrainItems; i++)
 	{
 			/* SEE WHICH THINGS WE SUPPORT & GET PARMS */
+
+		height = GetItemShadowHeight((*gMasterItemList)[i].type);
+		if (height == 0)
+			continue;
+		
+			/* CALCULATE LINE TO DRAW SHADOW ALONG */
+
+		ItemShadowLine* line = &outLines[numLines++];
+			
+		line->from.x = (int)(*gMasterItemList)[i].x * MAP2UNIT_VALUE;
+		line->from.y = (int)(*gMasterItemList)[i].y * MAP2UNIT_VALUE;
 				
-		switch((*gMasterItemList)[i].type)
-		{
-			case	5:						// clover
-					height = 1000;
-					break;
-					
-			case	6:						// grass
-					height = 1200;
-					break;
-					
-			case	7:						// weed
-					height = 2500;
-					break;
-					
-			case	10:						// sunflower
-					height = 3000;
-					break;
+		line->to.x = line->from.x + lightVector.x * (height * dot);
+		line->to.y = line->from.y + lightVector.y * (height * dot);
+		
+		line->length = Q3Point2D_Distance(&line->from, &line->to);
 
-			case	11:						// cosmo
-					height = 2000;
-					break;
+		float minZ = line->from.y < line->to.y ? line->from.y : line->to.y;
+		float maxZ = line->from.y > line->to.y ? line->from.y : line->to.y;
+		line->minRow = (long) floorf(minZ / TERRAIN_POLYGON_SIZE - .5f) - 1;
+		line->maxRow = (long) (maxZ / TERRAIN_POLYGON_SIZE + .5f) + 1;
+	}
 
-			case	12:						// poppy
-					height = 2000;
-					break;
+	return numLines;
+}
 
-			case	19:						// cattail
-					height = 3000;
-					break;
 
-			case	20:						// duckweed
-					height = 2500;
-					break;
+/****************** CAST ITEM SHADOW **********************/
+//
+// Scans along the light and shades the vertices in rows [rowBegin, rowEnd).
+//
 
-			case	21:						// lily flower
-					height = 2000;
-					break;
+static void CastItemShadow(const ItemShadowLine *line, Byte **shadowFlags, u_short **vertexColors, long rowBegin, long rowEnd)
+{
+const TQ3Point2D	from = line->from;
+const TQ3Point2D	to = line->to;
+float				x,z,t;
+long				row,col;
 
-			case	22:						// lily pad
-					height = 2000;
-					break;
-					
-			case	23:						// pond grass
-					height = 2500;
-					break;
-
-			case	24:						// reed
-					height = 2500;
-					break;
-
-			case	45:						// honey tube
-					height = 1200;
-					break;
-
-			case	51:						// tree stump
-					height = 3000;
-					break;
-
-			case	57:						// ant pipe
-			case	58:
-					height = 1000;
-					break;
-
-			case	60:						// faucet
-					height = 1200;
-					break;
-
-			case	63:						// king pipe
-					height = 1200;
-					break;
-					
-			default:
-					continue;		
-		}
-		
-			/* CALCULATE LINE TO DRAW SHADOW ALONG */
-			
-		from.x = (int)(*gMasterItemList)[i].x * MAP2UNIT_VALUE;
-		from.y = (int)(*gMasterItemList)[i].y * MAP2UNIT_VALUE;
-				
-		to.x = from.x + lightVector.x * (height * dot);
-		to.y = from.y + lightVector.y * (height * dot);
-		
-		length = Q3Point2D_Distance(&from, &to);
-		
+	for (t = 1.0; t > 0.0f; t -= 1.0f / (line->length/TERRAIN_POLYGON_SIZE))
+	{
+		float	oneMinusT = 1.0f - t;
+		float	r,g,b;
+		float	ro,co;
+		u_short	*color;
 		
-			/***************************************/
-			/* SCAN ALONG LIGHT AND SHADE VERTICES */
-			/***************************************/
-					
-		for (t = 1.0; t > 0.0f; t -= 1.0f / (length/TERRAIN_POLYGON_SIZE))
+		x = (from.x * oneMinusT) + (to.x * t);			// calc center x
+		z = (from.y * oneMinusT) + (to.y * t);
+	
+		for (ro = -.5; ro <= .5; ro += .5)
 		{
-			float	oneMinusT = 1.0f - t;
-			float	r,g,b;
-			float	ro,co;
-			u_short	*color;
-			
-			x = (from.x * oneMinusT) + (to.x * t);			// calc center x
-			z = (from.y * oneMinusT) + (to.y * t);
-		
-			for (ro = -.5; ro <= .5; ro += .5)
+			for (co = -.5; co <= .5; co += .5)
 			{
-				for (co = -.5; co <= .5; co += .5)
-				{
-					row = z / TERRAIN_POLYGON_SIZE + ro;			// calc row/col
-					col = x / TERRAIN_POLYGON_SIZE + co;
-		
-					if ((row < 0) || (col < 0))						// check for out of bounds
-						continue;
-					if ((row >= gTerrainTileDepth) || (col >= gTerrainTileWidth))	
-						continue;
-					
-					if (shadowFlags[row][col])						// see if this already shadowed
-						continue;
-		
-					shadowFlags[row][col] = 1;						// set flag
-					
+				row = z / TERRAIN_POLYGON_SIZE + ro;			// calc row/col
+				col = x / TERRAIN_POLYGON_SIZE + co;
+	
+				if ((row < 0) || (col < 0))						// check for out of bounds
+					continue;
+				if ((row >= gTerrainTileDepth) || (col >= gTerrainTileWidth))	
+					continue;
+
+				if ((row < rowBegin) || (row >= rowEnd))		// not in our band
+					continue;
 				
-						/* EXTRACT RGB */
-						
-					color = &gVertexColors[FLOOR][row][col];
-					
-					r = (*color >> 11);
-					r /= 0x1f;
-					g = (*color >> 5) & 0x3f;
-					g /= 0x3f;
-					b = (*color & 0x1f);
-					b /= 0x1f;
+				if (shadowFlags[row][col])						// see if this already shadowed
+					continue;
+	
+				shadowFlags[row][col] = 1;						// set flag
+				
+			
+					/* EXTRACT RGB */
 					
-						/* FADE IT */
-						
-					r *= .7f;
-					g *= .7f;
-					b *= .7f;
+				color = &vertexColors[row][col];
+				
+				r = (*color >> 11);
+				r /= 0x1f;
+				g = (*color >> 5) & 0x3f;
+				g /= 0x3f;
+				b = (*color & 0x1f);
+				b /= 0x1f;
+				
+					/* FADE IT */
 					
+				r *= .7f;
+				g *= .7f;
+				b *= .7f;
+				
+				
+					/* SAVE RGB */
 					
-						/* SAVE RGB */
-						
-					*color = (int)(r*(float)0x1f)<<11;
-					*color |= (int)(g*(float)0x3f)<<5;
-					*color |= (int)(b*(float)0x1f);	
-				}// co
-			} // ro
-		}		
+				*color = (int)(r*(float)0x1f)<<11;
+				*color |= (int)(g*(float)0x3f)<<5;
+				*color |= (int)(b*(float)0x1f);	
+			}// co
+		} // ro
+	}		
+}
+
+
+/****************** CAST ITEM SHADOWS IN ROWS **********************/
+//
+// ParallelFor callback: stamps every item shadow that reaches the given band of rows.
+//
+
+static void CastItemShadowsInRows(int rowBegin, int rowEnd, void* userData)
+{
+	const ItemShadowJob* job = (const ItemShadowJob*) userData;
+
+	for (int i = 0; i < job->numLines; i++)
+	{
+		const ItemShadowLine* line = &job->lines[i];
+
+		if ((line->maxRow < rowBegin) || (line->minRow >= rowEnd))		// can't reach this band
+			continue;
+
+		CastItemShadow(line, job->shadowFlags, job->vertexColors, rowBegin, rowEnd);
 	}
-	
-	
+}
+
+
+/****************** DO ITEM SHADOW CASTING **********************/
+//
+// Scans thru item list and casts a shadown onto the terrain
+// by darkening the vertex colors of the terrain.
+//
+// Each vertex is darkened at most once no matter how many items shade it, so the result
+// doesn't depend on the order the items are stamped in. That lets us split the map into
+// bands of rows and stamp every band on its own thread: a band only ever touches its own rows
+// of the vertex colors and shadow flags, and ends up exactly as if done serially.
+//
+
+void DoItemShadowCasting(void)
+{
+ItemShadowJob		job;
+long				row;
+
+	uint64_t startTime = GetProfilingTimestamp();
+
+			/* INIT SHADOW FLAGS TEMP BUFFER */
+			
+	Alloc_2d_array(Byte, job.shadowFlags, gTerrainTileDepth+1, gTerrainTileWidth+1);
+
+	for (row = 0; row <= gTerrainTileDepth; row++)
+		memset(job.shadowFlags[row], 0, gTerrainTileWidth+1);
+
+			/* GET SHADOW LINES OF ALL ITEMS */
+
+	job.lines = (ItemShadowLine*) AllocPtr(sizeof(ItemShadowLine) * (gNumTerrainItems > 0 ? gNumTerrainItems : 1));
+	GAME_ASSERT(job.lines);
+	job.numLines = BuildItemShadowLines(job.lines);
+
+#if _DEBUG
+			/* CAST SHADOWS SERIALLY INTO A COPY FOR REFERENCE */
+
+	u_short**	referenceColors;
+	Alloc_2d_array(u_short, referenceColors, gTerrainTileDepth+1, gTerrainTileWidth+1);
+	for (row = 0; row <= gTerrainTileDepth; row++)
+		memcpy(referenceColors[row], gVertexColors[FLOOR][row], sizeof(u_short) * (gTerrainTileWidth+1));
+
+	uint64_t serialStartTime = GetProfilingTimestamp();
+
+	for (int i = 0; i < job.numLines; i++)
+		CastItemShadow(&job.lines[i], job.shadowFlags, referenceColors, 0, gTerrainTileDepth);
+
+	float serialMilliseconds = GetMillisecondsSince(serialStartTime);
+
+	for (row = 0; row <= gTerrainTileDepth; row++)
+		memset(job.shadowFlags[row], 0, gTerrainTileWidth+1);
+#endif
+
+			/*********************************/
+			/* STAMP SHADOWS, 1 BAND PER CPU */
+			/*********************************/
+
+	uint64_t parallelStartTime = GetProfilingTimestamp();
+
+	job.vertexColors = gVertexColors[FLOOR];
+	ParallelFor(gTerrainTileDepth, CastItemShadowsInRows, &job);
+
+#if _DEBUG
+	float parallelMilliseconds = GetMillisecondsSince(parallelStartTime);
+
+	for (row = 0; row <= gTerrainTileDepth; row++)
+	{
+		GAME_ASSERT_MESSAGE(0 == memcmp(referenceColors[row], gVertexColors[FLOOR][row], sizeof(u_short) * (gTerrainTileWidth+1)),
+							"Parallel item shadows differ from serial");
+	}
+	Free2DArray((void**) referenceColors);
+
+	printf("Item shadows: %d items x %d workers in %.2f ms (serial %.2f ms), %.2f ms total\n",
+			job.numLines, GetNumParallelWorkers(), parallelMilliseconds, serialMilliseconds, GetMillisecondsSince(startTime));
+#else
+	(void) startTime;
+	(void) parallelStartTime;
+#endif
+
 			/* CLEANUP */
 			
-	Free2DArray((void**) shadowFlags);
-	shadowFlags = nil;
+	DisposePtr((Ptr) job.lines);
+	Free2DArray((void**) job.shadowFlags);
 }
 
 